@@ -0,0 +1,32 @@
+#ifndef APP_ACQ_H_
+#define APP_ACQ_H_
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#include "blocks.h"
+
+/** Sample period in microseconds. */
+#define ACQ_SAMPLE_PERIOD_US (USEC_PER_SEC / PIPELINE_SAMPLE_RATE_HZ)
+
+/** Duration of one sample block in microseconds. */
+#define ACQ_BLOCK_PERIOD_US (PIPELINE_BLOCK_SAMPLES * ACQ_SAMPLE_PERIOD_US)
+
+/**
+ * Get the next acquired block.
+ *
+ * The caller owns the block and returns it with
+ * block_pool_free(BLOCK_POOL_SAMPLES, block).
+ */
+struct sample_block *acq_get(k_timeout_t timeout);
+
+/** Number of blocks dropped because the sample pool was exhausted. */
+uint32_t acq_dropped(void);
+
+/**
+ * Worst-case delay between the end of a block period and the block being
+ * produced. A value above ACQ_BLOCK_PERIOD_US means acquisition stalled.
+ */
+uint32_t acq_max_late_us(void);
+
+#endif /* APP_ACQ_H_ */
@@ -0,0 +1,60 @@
+#ifndef APP_SETTINGS_H_
+#define APP_SETTINGS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Persistent application settings.
+ *
+ * Each subtree is stored as one blob under "app/<name>" and loaded from
+ * flash on first access only. Updates land in a RAM copy and are written
+ * back in one batch CONFIG_APP_SETTINGS_FLUSH_DELAY_S after the first
+ * change, so repeated updates of the same value cost a single flash write.
+ */
+enum app_settings_id {
+    APP_SETTINGS_CAL,
+    APP_SETTINGS_FILTER,
+    APP_SETTINGS_COUNT,
+};
+
+/** Front end calibration: uV = raw * gain_q16 / 65536 + offset_uv. */
+struct cal_settings {
+    int32_t gain_q16;
+    int32_t offset_uv;
+};
+
+struct filter_settings {
+    /** Baseline wander high-pass cutoff in 0.01 Hz. */
+    uint16_t baseline_cutoff_chz;
+};
+
+struct app_settings_stats {
+    /** Values written to flash since boot. */
+    uint32_t writes;
+    /** Updates absorbed by the RAM copy without a flash write. */
+    uint32_t coalesced;
+    /** Time spent loading subtrees from flash, microseconds. */
+    uint32_t load_us;
+};
+
+/**
+ * Read a settings subtree, loading it from flash on first use.
+ *
+ * @return 0 on success, -EINVAL on a size mismatch, other negative errno
+ *         if the storage could not be initialized (defaults are returned).
+ */
+int app_settings_get(enum app_settings_id id, void *val, size_t len);
+
+/** Update a settings subtree, the flash write is deferred and batched. */
+int app_settings_set(enum app_settings_id id, const void *val, size_t len);
+
+/** Write all pending updates to flash now. */
+int app_settings_flush(void);
+
+void app_settings_stats_get(struct app_settings_stats *stats);
+
+/** Log write statistics, extrapolated to flash writes per day. */
+void app_settings_stats_log(void);
+
+#endif /* APP_SETTINGS_H_ */
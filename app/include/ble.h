@@ -0,0 +1,22 @@
+#ifndef APP_BLE_H_
+#define APP_BLE_H_
+
+#include <stdbool.h>
+
+/**
+ * Start Bluetooth initialization.
+ *
+ * Returns immediately, the stack comes up on the system work queue and
+ * starts advertising once ready.
+ */
+int ble_init(void);
+
+/**
+ * Switch the current connection between the shortest connection interval
+ * (bulk transfers) and the normal one.
+ *
+ * @return 0 if the update was requested, -ENOTCONN without a connection.
+ */
+int ble_conn_fast(bool fast);
+
+#endif /* APP_BLE_H_ */
@@ -0,0 +1,52 @@
+#ifndef APP_BLOCK_POOL_H_
+#define APP_BLOCK_POOL_H_
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+/**
+ * Fixed-size block pools for the data path.
+ *
+ * Every buffer that flows between acquisition, processing and transport is
+ * taken from one of these k_mem_slab pools, the firmware does not use the
+ * heap. Allocation and release are O(1) and cannot fragment.
+ */
+enum block_pool_id {
+    BLOCK_POOL_SAMPLES,
+    BLOCK_POOL_PACKETS,
+    BLOCK_POOL_EVENTS,
+    BLOCK_POOL_COUNT,
+};
+
+struct block_pool_stats {
+    uint32_t block_size;
+    uint32_t num_blocks;
+    uint32_t num_used;
+    /** High-water mark of @ref num_used since boot or last reset. */
+    uint32_t max_used;
+    /** Number of allocations that returned NULL. */
+    uint32_t alloc_failures;
+};
+
+/**
+ * Allocate a block from a pool.
+ *
+ * @param id      Pool to allocate from.
+ * @param timeout Time to wait for a free block, K_NO_WAIT from ISRs.
+ *
+ * @return Pointer to the block or NULL if none became available.
+ */
+void *block_pool_alloc(enum block_pool_id id, k_timeout_t timeout);
+
+/** Return a block obtained with block_pool_alloc() to its pool. */
+void block_pool_free(enum block_pool_id id, void *block);
+
+int block_pool_stats_get(enum block_pool_id id, struct block_pool_stats *stats);
+
+/** Reset high-water marks and failure counters of all pools. */
+void block_pool_stats_reset(void);
+
+/** Log occupancy of all pools. */
+void block_pool_stats_log(void);
+
+#endif /* APP_BLOCK_POOL_H_ */
@@ -0,0 +1,56 @@
+#ifndef APP_BLOCKS_H_
+#define APP_BLOCKS_H_
+
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/toolchain.h>
+
+#include "pipeline.h"
+
+/** Alignment of every lead in a sample block, one 128 bit vector. */
+#define SAMPLE_ALIGN 16
+
+/** Distance between leads in samples, padded to the vector alignment. */
+#define SAMPLE_STRIDE                                                          \
+    ROUND_UP(PIPELINE_BLOCK_SAMPLES, SAMPLE_ALIGN / sizeof(int32_t))
+
+/**
+ * Block of consecutive samples produced by the acquisition front end.
+ *
+ * Samples are stored per lead (structure of arrays): samples[l] holds
+ * @ref count consecutive samples of lead l, so per-lead filters walk
+ * contiguous memory and every lead starts on a vector boundary. Rows are
+ * SAMPLE_STRIDE long, the padding past @ref count is unused.
+ */
+struct sample_block {
+    /** Reserved for k_fifo / k_queue linkage. */
+    void *fifo_reserved;
+    /** Sequence number of the block, increments by one per block. */
+    uint32_t seq;
+    /** Timestamp of the first sample, microseconds since boot. */
+    int64_t timestamp_us;
+    /** Samples per lead, always PIPELINE_BLOCK_SAMPLES. */
+    uint16_t count;
+    int32_t samples[PIPELINE_LEADS][SAMPLE_STRIDE] __aligned(SAMPLE_ALIGN);
+};
+
+/** Encoded (compressed/framed) packet ready for storage or transport. */
+struct enc_packet {
+    void *fifo_reserved;
+    uint16_t len;
+    uint8_t data[CONFIG_APP_PACKET_SIZE];
+};
+
+enum event_type {
+    EVENT_NONE = 0,
+};
+
+/** Detected event (beat, alarm, ...) with its timestamp. */
+struct event_record {
+    void *fifo_reserved;
+    int64_t timestamp_us;
+    uint16_t type;
+    int32_t value;
+};
+
+#endif /* APP_BLOCKS_H_ */
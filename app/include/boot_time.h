@@ -0,0 +1,30 @@
+#ifndef APP_BOOT_TIME_H_
+#define APP_BOOT_TIME_H_
+
+#include <stdint.h>
+
+/** Boot milestones, timestamped on the common timebase. */
+enum boot_mark {
+    /** Entry to main(). */
+    BOOT_MARK_MAIN,
+    /** First ECG sample acquired. */
+    BOOT_MARK_FIRST_SAMPLE,
+    /** Bluetooth enabled and advertising. */
+    BOOT_MARK_BLE_READY,
+    /** Persistent settings loaded and applied. */
+    BOOT_MARK_SETTINGS,
+    /** Recorder partition scanned and ready for writing. */
+    BOOT_MARK_STORAGE,
+    BOOT_MARK_COUNT,
+};
+
+/** Record a milestone at the current time. Only the first call counts. */
+void boot_time_mark(enum boot_mark mark);
+
+/** Record a milestone at an explicit timestamp (microseconds). */
+void boot_time_mark_at(enum boot_mark mark, int64_t t_us);
+
+/** @return Milestone timestamp in microseconds or -1 if not reached yet. */
+int64_t boot_time_get_us(enum boot_mark mark);
+
+#endif /* APP_BOOT_TIME_H_ */
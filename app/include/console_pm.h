@@ -0,0 +1,12 @@
+#ifndef APP_CONSOLE_PM_H_
+#define APP_CONSOLE_PM_H_
+
+#include <stdint.h>
+
+/** Total time the console UART has spent suspended, in milliseconds. */
+int64_t console_pm_suspended_ms(void);
+
+/** Log the console suspend statistics. */
+void console_pm_stats_log(void);
+
+#endif /* APP_CONSOLE_PM_H_ */
@@ -0,0 +1,43 @@
+#ifndef APP_DSP_BIQUAD_H_
+#define APP_DSP_BIQUAD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Fractional bits of biquad coefficients. */
+#define BIQUAD_COEFF_SHIFT 28
+
+/** Coefficients in Q(31-BIQUAD_COEFF_SHIFT).BIQUAD_COEFF_SHIFT, a0 == 1. */
+struct biquad_coeffs {
+    int32_t b0, b1, b2;
+    int32_t a1, a2;
+};
+
+/** Direct form I biquad section with integer state. */
+struct biquad {
+    struct biquad_coeffs c;
+    int32_t x1, x2;
+    int32_t y1, y2;
+    /* Truncation error carried to the next sample */
+    int32_t err;
+};
+
+/** Second order Butterworth high-pass coefficients. */
+void biquad_highpass(struct biquad_coeffs *c, uint32_t fs_hz, double fc_hz);
+
+/** Second order Butterworth low-pass coefficients. */
+void biquad_lowpass(struct biquad_coeffs *c, uint32_t fs_hz, double fc_hz);
+
+/**
+ * Notch coefficients: zeros on the unit circle at @p f0_hz, -3 dB width
+ * @p bw_hz, unity gain away from the notch.
+ */
+void biquad_notch(struct biquad_coeffs *c, uint32_t fs_hz, double f0_hz,
+                  double bw_hz);
+
+void biquad_init(struct biquad *f, const struct biquad_coeffs *c);
+
+/** Filter @p n samples in place. */
+void biquad_process(struct biquad *f, int32_t *x, size_t n);
+
+#endif /* APP_DSP_BIQUAD_H_ */
@@ -0,0 +1,122 @@
+#ifndef APP_DSP_DELIN_H_
+#define APP_DSP_DELIN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Wavelet ECG delineator after Martinez et al. (2004).
+ *
+ * Baseline-filtered samples are averaged down to DELIN_FS_HZ into a ring.
+ * Once the window around a detected R peak is complete, an integer
+ * quadratic spline wavelet (a trous, scales 2^1..2^4) is evaluated over
+ * that window only. QRS onset and offset come from the modulus maxima at
+ * scale 2^2, P and T waves from scale 2^4. Work per beat is fixed, about
+ * DELIN_WIN * 4 filter taps plus linear searches, whatever the input
+ * sample rate.
+ */
+#define DELIN_FS_HZ   250
+/** Delineation window before and after the R peak in ms. */
+#define DELIN_PRE_MS  300
+#define DELIN_POST_MS 500
+/** Beats detected but not yet delineated. */
+#define DELIN_PENDING 4
+
+/* Window in decimated samples, with room for the wavelet filter settling */
+#define DELIN_PRE  (DELIN_FS_HZ * DELIN_PRE_MS / 1000)
+#define DELIN_POST (DELIN_FS_HZ * DELIN_POST_MS / 1000)
+#define DELIN_LEAD 32
+#define DELIN_TAIL 16
+#define DELIN_WIN  (DELIN_LEAD + DELIN_PRE + 1 + DELIN_POST + DELIN_TAIL)
+#define DELIN_RING 256
+
+/** Flags of struct delin_beat. */
+#define DELIN_P_WAVE 0x01
+#define DELIN_T_WAVE 0x02
+
+/** Fiducial points of one beat, in ms relative to the R peak. */
+struct delin_beat {
+    /** R peak, input sample index as reported by the QRS detector. */
+    uint64_t r;
+    /** Preceding RR interval, 0 if unknown. */
+    uint16_t rr_ms;
+    uint8_t flags;
+    int16_t p_on, p_peak, p_end;
+    int16_t qrs_on, qrs_off;
+    int16_t t_peak, t_end;
+    /** QT and Bazett corrected QT, 0 without a T wave or RR. */
+    uint16_t qt_ms, qtc_ms;
+    /** ST deviation at J + 60 ms (J + 40 ms above 100 bpm) from PR. */
+    int16_t st_uv;
+};
+
+/** Means over the beats delineated since delin_stats_get() was last reset. */
+struct delin_stats {
+    uint32_t beats;
+    /** Beats skipped because their window had already left the ring. */
+    uint32_t late;
+    uint32_t p_waves;
+    uint32_t t_waves;
+    uint16_t qrs_ms;
+    uint16_t pr_ms;
+    uint16_t qt_ms;
+    uint16_t qtc_ms;
+    int16_t st_uv;
+};
+
+struct delin {
+    uint32_t dec;
+    uint32_t acc_n;
+    int32_t acc;
+    /* Decimated samples pushed so far */
+    uint64_t n;
+    int32_t ring[DELIN_RING];
+
+    struct {
+        uint64_t r;
+        uint16_t rr_ms;
+    } pending[DELIN_PENDING];
+    uint32_t head;
+    uint32_t count;
+
+    /* Wavelet scratch, approximation and the two detail scales used */
+    int32_t a[DELIN_WIN];
+    int32_t w2[DELIN_WIN];
+    int32_t w4[DELIN_WIN];
+
+    uint32_t late;
+    uint32_t beats, p_waves, t_waves, qt_beats;
+    int64_t qrs_sum, pr_sum, qt_sum, qtc_sum, st_sum;
+};
+
+/**
+ * Initialize a delineator.
+ *
+ * @param fs_hz Input sample rate, a multiple of DELIN_FS_HZ.
+ *
+ * @return 0, or -1 if @p fs_hz is not supported.
+ */
+int delin_init(struct delin *d, uint32_t fs_hz);
+
+/**
+ * Queue an R peak for delineation.
+ *
+ * Must be called before the samples DELIN_POST_MS after the peak are
+ * pushed, which holds for beats reported by qrs_process() on the same
+ * block.
+ */
+void delin_add_beat(struct delin *d, uint64_t r, uint16_t rr_ms);
+
+/**
+ * Push @p n baseline-filtered samples and delineate queued beats whose
+ * window became complete.
+ *
+ * @return Number of beats delineated, at most @p max are stored.
+ */
+size_t delin_push(struct delin *d, const int32_t *x, size_t n,
+                  struct delin_beat *out, size_t max);
+
+/** Get the means since the last reset, optionally starting over. */
+void delin_stats_get(struct delin *d, struct delin_stats *st, int reset);
+
+#endif /* APP_DSP_DELIN_H_ */
@@ -0,0 +1,76 @@
+#ifndef APP_DSP_ECG_ANALYSIS_H_
+#define APP_DSP_ECG_ANALYSIS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dsp/biquad.h"
+#include "dsp/delin.h"
+#include "dsp/hrv.h"
+#include "dsp/median.h"
+#include "dsp/qrs.h"
+
+/**
+ * Beat analysis chain shared by the DSP thread and the host tools.
+ *
+ * Baseline wander removal, QRS detection, HRV and beat delineation on
+ * calibrated samples, so a recording analysed on the host gives the beats
+ * the device saw.
+ */
+#define ECG_ANALYSIS_DELIN_MAX 16
+
+struct ecg_analysis {
+    uint32_t fs_hz;
+    struct biquad baseline;
+    /* Median baseline instead of the high-pass, if storage was given */
+    int median_on;
+    struct median_baseline median;
+    /* Signal delay of the baseline filter, taken off reported beats */
+    uint32_t delay;
+    struct qrs qrs;
+    struct hrv hrv;
+    uint64_t last_beat;
+    uint32_t beats;
+
+    /* Delineation, only at sample rates that are a multiple of 250 Hz */
+    int delin_on;
+    struct delin delin;
+    /** Beats delineated by the last ecg_analysis_process() call. */
+    struct delin_beat delineated[ECG_ANALYSIS_DELIN_MAX];
+    size_t delineated_count;
+};
+
+void ecg_analysis_init(struct ecg_analysis *a, uint32_t fs_hz,
+                       uint16_t baseline_cutoff_chz);
+
+/**
+ * Remove baseline wander with the two stage median instead of the
+ * high-pass. Call right after ecg_analysis_init().
+ *
+ * @param storage MEDIAN_BASELINE_WORDS(fs_hz) words, kept in use.
+ *
+ * @return 0, or -1 if @p words is too small.
+ */
+int ecg_analysis_use_median(struct ecg_analysis *a, uint32_t *storage,
+                            size_t words);
+
+/** Change the high-pass baseline cutoff, the filter state is kept. */
+void ecg_analysis_set_baseline(struct ecg_analysis *a,
+                               uint16_t baseline_cutoff_chz);
+
+/**
+ * Filter @p n samples in place and detect beats.
+ *
+ * @param beats     Sample indices of the R peaks found, may be NULL.
+ * @param max_beats Capacity of @p beats.
+ *
+ * Beats are delineated once the samples DELIN_POST_MS after them are in,
+ * the first ECG_ANALYSIS_DELIN_MAX of a call are kept in @ref delineated.
+ *
+ * @return Number of beats detected in this call, beyond @p max_beats
+ *         they are counted but not stored.
+ */
+size_t ecg_analysis_process(struct ecg_analysis *a, int32_t *x, size_t n,
+                            uint64_t *beats, size_t max_beats);
+
+#endif /* APP_DSP_ECG_ANALYSIS_H_ */
@@ -0,0 +1,65 @@
+#ifndef APP_DSP_ECG_CODEC_H_
+#define APP_DSP_ECG_CODEC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Lossless ECG block codec.
+ *
+ * A frame carries one block: a fixed header followed, lead after lead,
+ * by the first sample and the sample-to-sample differences, zigzag mapped
+ * and stored as LEB128 varints. When that would not be smaller the
+ * samples are stored raw, so a frame never exceeds ECG_CODEC_MAX_SIZE().
+ * Frames are independent of each other and self-delimiting.
+ *
+ * Header (little endian): magic u8, flags u8, count u16, seq u32,
+ * timestamp_us i64. count is samples per lead; the lead count minus one
+ * is in the upper flags nibble, so single lead frames are unchanged.
+ */
+#define ECG_CODEC_MAGIC    0xEC
+#define ECG_CODEC_HDR_SIZE 16
+#define ECG_CODEC_FLAG_RAW 0x01
+#define ECG_CODEC_MAX_LEADS 16
+
+/** Upper bound of an encoded frame carrying @p n samples over all leads. */
+#define ECG_CODEC_MAX_SIZE(n) (ECG_CODEC_HDR_SIZE + 4 * (size_t)(n))
+
+struct ecg_codec_frame {
+    uint32_t seq;
+    int64_t timestamp_us;
+    /** Samples per lead. */
+    uint16_t count;
+    /** Number of leads, 0 is taken as 1. */
+    uint8_t leads;
+};
+
+/**
+ * Encode one block.
+ *
+ * @param x Samples as a [leads][count] array, lead after lead.
+ *
+ * @return Frame size in bytes, 0 if @p cap is below ECG_CODEC_MAX_SIZE().
+ */
+size_t ecg_codec_encode(const struct ecg_codec_frame *f, const int32_t *x,
+                        uint8_t *out, size_t cap);
+
+/** As ecg_codec_encode(), lead l starting at x[l * stride]. */
+size_t ecg_codec_encode_strided(const struct ecg_codec_frame *f,
+                                const int32_t *x, size_t stride, uint8_t *out,
+                                size_t cap);
+
+/**
+ * Decode one frame.
+ *
+ * @param x           Receives the samples as a [leads][count] array, so
+ *                    the first count samples are always lead 0.
+ * @param max_samples Capacity of @p x over all leads.
+ *
+ * @return Bytes consumed, or -1 if the data is not a valid frame, is
+ *         truncated or does not fit into @p x.
+ */
+int ecg_codec_decode(const uint8_t *in, size_t len, struct ecg_codec_frame *f,
+                     int32_t *x, size_t max_samples);
+
+#endif /* APP_DSP_ECG_CODEC_H_ */
@@ -0,0 +1,47 @@
+#ifndef APP_DSP_ECG_SYNTH_H_
+#define APP_DSP_ECG_SYNTH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Synthetic ECG generator.
+ *
+ * Produces a lead II like waveform in microvolts: P, Q, R, S and T waves
+ * built from parabolic bumps, beat-to-beat RR variability and baseline
+ * wander. Used as the emulated front end where no ECG AFE is present.
+ */
+struct ecg_synth {
+    uint32_t fs_hz;
+    uint32_t seed;
+    /** Mean RR interval and maximum RR jitter in milliseconds. */
+    uint32_t rr_ms;
+    uint32_t rr_jitter_ms;
+    /** Baseline wander amplitude in microvolts. */
+    int32_t wander_uv;
+
+    /* Generator state */
+    uint64_t n;
+    uint64_t beat_start;
+    uint32_t beat_len;
+};
+
+/**
+ * Initialize a generator.
+ *
+ * @param seed Seed of the RR variability, distinct seeds give distinct
+ *             recordings.
+ */
+void ecg_synth_init(struct ecg_synth *s, uint32_t fs_hz, uint32_t hr_bpm,
+                    uint32_t seed);
+
+/** Generate the next @p n samples. */
+void ecg_synth_fill(struct ecg_synth *s, int32_t *out, size_t n);
+
+/**
+ * Sample index of the R peak of the beat the last sample belongs to, the
+ * ground truth for anything timed against the beats.
+ */
+uint64_t ecg_synth_r_peak(const struct ecg_synth *s);
+
+#endif /* APP_DSP_ECG_SYNTH_H_ */
@@ -0,0 +1,130 @@
+#ifndef APP_DSP_HR_FUSION_H_
+#define APP_DSP_HR_FUSION_H_
+
+#include <stdint.h>
+
+/**
+ * Heart rate fused from beat to beat measurements of several sources.
+ *
+ * A scalar Kalman filter tracks the heart rate as a random walk. Its
+ * process noise grows with the motion context, since the rate changes
+ * faster in exercise. Every measurement carries the variance of its
+ * source: a fixed SD per source, doubled for every level the caller
+ * marks it degraded (a noisy lead, a weak pulse) and scaled with motion:
+ * down for the ECG, whose sinus arrhythmia fades in exercise, and up to
+ * a ceiling for the PPG, whose sensor moves against the skin.
+ *
+ * Measurements further than HR_FUSION_GATE SDs of the innovation from
+ * the estimate are rejected: double detections, missed beats, a PPG
+ * locked onto the step rate. A source rejected HR_FUSION_REACQUIRE times
+ * in a row while no other source is accepted restarts the estimate from
+ * its measurement. Without measurements the variance grows until the
+ * estimate is no longer valid, so the estimate follows whichever source
+ * is left and says when none is.
+ *
+ * Measurements may arrive out of order between sources, each pipeline
+ * has its own latency; a late one is taken as made at the time of the
+ * estimate. Every call is O(1).
+ */
+enum hr_source {
+    HR_SOURCE_ECG,
+    HR_SOURCE_PPG,
+    HR_SOURCES,
+};
+
+/** SD of one beat of a good source in 0.01 bpm, sinus arrhythmia included. */
+#define HR_FUSION_ECG_SD_CBPM 300
+#define HR_FUSION_PPG_SD_CBPM 400
+
+/** Highest degradation level, SD x 2^level. */
+#define HR_FUSION_DEGRADED_MAX 4
+
+/** Process noise at rest in (0.01 bpm)^2 per second, 1 bpm^2/s. */
+#define HR_FUSION_Q_REST 10000
+/** Motion that adds the rest process noise once more. */
+#define HR_FUSION_MOTION_MG 20
+/**
+ * The PPG SD grows with motion towards HR_FUSION_PPG_MOTION_MAX times its
+ * rest value, halfway there at HR_FUSION_PPG_MOTION_MG: noisier with every
+ * step at first, but a PPG-only estimate stays valid while walking.
+ */
+#define HR_FUSION_PPG_MOTION_MG  2000
+#define HR_FUSION_PPG_MOTION_MAX 16
+/** Motion that halves the ECG SD, sinus arrhythmia fades in exercise. */
+#define HR_FUSION_ECG_MOTION_MG 100
+
+#define HR_FUSION_GATE       3
+#define HR_FUSION_REACQUIRE  4
+/**
+ * RMS in 0.01 bpm of the recent innovations of a source, averaged over
+ * about 1 << HR_FUSION_INNOV_SHIFT beats, above which it is not reliable.
+ */
+#define HR_FUSION_RELIABLE_CBPM 500
+#define HR_FUSION_INNOV_SHIFT   3
+/** A source without an accepted beat for this long is lost. */
+#define HR_FUSION_STALE_MS   3000
+/** Estimates less certain than this SD in 0.01 bpm are not valid. */
+#define HR_FUSION_SD_MAX_CBPM 1000
+
+struct hr_fusion_stats {
+    /** Heart rate and its SD in 0.01 bpm, zero until the first beat */
+    uint32_t hr_cbpm;
+    uint32_t sd_cbpm;
+    /** Some source was accepted lately and the SD is small enough */
+    uint8_t valid;
+    /**
+     * Sources accepted lately, neither degraded nor rejected since, whose
+     * innovations stay within HR_FUSION_RELIABLE_CBPM
+     */
+    uint8_t reliable;
+    uint32_t activity_mg;
+    uint32_t accepted[HR_SOURCES];
+    uint32_t rejected[HR_SOURCES];
+    uint32_t restarts;
+};
+
+struct hr_fusion_source {
+    int64_t accepted_us;
+    /* Mean innovation squared, (0.01 bpm)^2 */
+    uint64_t innov_sq;
+    uint32_t accepted;
+    uint32_t rejected;
+    uint8_t rejected_run;
+    uint8_t degraded;
+};
+
+struct hr_fusion {
+    uint8_t started;
+    /* Estimate in 0.01 bpm, its variance, and the time it is for */
+    int32_t hr_cbpm;
+    uint64_t var;
+    int64_t t_us;
+    uint32_t activity_mg;
+    uint32_t restarts;
+    struct hr_fusion_source src[HR_SOURCES];
+};
+
+void hr_fusion_init(struct hr_fusion *f);
+
+/**
+ * Set the motion context: mean acceleration magnitude in mg with gravity
+ * taken out, about 20 at rest, 250 walking and 700 running.
+ */
+void hr_fusion_motion(struct hr_fusion *f, uint32_t activity_mg);
+
+/**
+ * Fuse a heart rate of @p hr_cbpm measured from the beat at @p t_us.
+ *
+ * @param degraded Quality of the measurement, 0 for good up to
+ *                 HR_FUSION_DEGRADED_MAX.
+ *
+ * @return 1 if accepted, 0 if rejected.
+ */
+int hr_fusion_update(struct hr_fusion *f, enum hr_source src, int64_t t_us,
+                     uint32_t hr_cbpm, uint8_t degraded);
+
+/** Get the estimate, with the sources lost as of @p now_us. */
+void hr_fusion_stats_get(const struct hr_fusion *f, int64_t now_us,
+                         struct hr_fusion_stats *st);
+
+#endif /* APP_DSP_HR_FUSION_H_ */
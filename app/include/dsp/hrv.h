@@ -0,0 +1,100 @@
+#ifndef APP_DSP_HRV_H_
+#define APP_DSP_HRV_H_
+
+#include <stdint.h>
+
+#include "dsp/median.h"
+#include "dsp/spectrum.h"
+
+/** Number of RR intervals in the time domain HRV window. */
+#define HRV_WINDOW 64
+
+/** RR intervals outside this range are treated as artefacts. */
+#define HRV_RR_MIN_MS 250
+#define HRV_RR_MAX_MS 2000
+
+/**
+ * Intervals further than HRV_MEDIAN_DEV_PCT from the median of the last
+ * HRV_MEDIAN_BEATS are artefacts too: a missed beat doubles an interval,
+ * an extra detection splits one.
+ */
+#define HRV_MEDIAN_BEATS   9
+#define HRV_MEDIAN_DEV_PCT 20
+
+/**
+ * Time domain heart rate variability over the last HRV_WINDOW beats.
+ *
+ * Running sums are updated per beat, so a snapshot costs one square root.
+ */
+struct hrv {
+    uint16_t rr[HRV_WINDOW];
+    /* Squared successive difference, UINT32_MAX after an artefact */
+    uint32_t diff_sq[HRV_WINDOW];
+    uint32_t count;
+    uint32_t diffs;
+    uint32_t head;
+    uint64_t sum;
+    uint64_t sum_sq;
+    uint64_t sum_diff_sq;
+    uint16_t prev_rr;
+    uint32_t rejected;
+    struct median rr_median;
+    uint32_t rr_median_buf[MEDIAN_WORDS(HRV_MEDIAN_BEATS)];
+};
+
+struct hrv_stats {
+    /** Beats per minute x 10 */
+    uint32_t hr_dbpm;
+    uint32_t mean_rr_ms;
+    uint32_t sdnn_ms;
+    uint32_t rmssd_ms;
+    /** RR intervals in the window */
+    uint32_t count;
+    /** Intervals rejected as artefacts since init */
+    uint32_t rejected;
+};
+
+void hrv_init(struct hrv *h);
+
+void hrv_add_rr(struct hrv *h, uint32_t rr_ms);
+
+void hrv_get(const struct hrv *h, struct hrv_stats *st);
+
+/**
+ * Frequency domain HRV over the same window.
+ *
+ * The RR series is resampled at HRV_FREQ_N evenly spaced instants across
+ * the beats in the window, so one bin is the inverse of the window span
+ * (about 0.02 Hz at rest), windowed with Hann and transformed. LF is
+ * 0.04 to 0.15 Hz, HF 0.15 to 0.4 Hz, and the HF peak is the respiration
+ * rate as seen through respiratory sinus arrhythmia.
+ */
+#define HRV_FREQ_N         256
+/** Fewer intervals than this give no frequency domain result. */
+#define HRV_FREQ_MIN_BEATS 32
+
+/** Working buffer of hrv_freq(), in 32 bit words. */
+#define HRV_FREQ_WORDS SPECTRUM_WORDS(HRV_FREQ_N)
+
+struct hrv_freq {
+    uint32_t lf_ms2;
+    uint32_t hf_ms2;
+    /** LF / HF x 100, 0 without HF power */
+    uint32_t lf_hf_pct;
+    /** Breaths per minute x 10 at the HF peak */
+    uint32_t resp_dbrpm;
+};
+
+/**
+ * Compute the frequency domain measures.
+ *
+ * @param s     Transform set up for HRV_FREQ_N points.
+ * @param buf   HRV_FREQ_WORDS words of scratch.
+ * @param power HRV_FREQ_N / 2 + 1 words of scratch.
+ *
+ * @return 0, or -1 with too few intervals or a transform of the wrong size.
+ */
+int hrv_freq_get(const struct hrv *h, const struct spectrum *s, int32_t *buf,
+                 uint64_t *power, struct hrv_freq *fr);
+
+#endif /* APP_DSP_HRV_H_ */
@@ -0,0 +1,104 @@
+#ifndef APP_DSP_MAINS_H_
+#define APP_DSP_MAINS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dsp/biquad.h"
+
+/**
+ * Mains interference detection and tracking notch.
+ *
+ * Every so often one window of a lead is run through a handful of
+ * fixed-point Goertzel bins: the fundamental and harmonics of 50 and
+ * 60 Hz, each against reference bins MAINS_REF_HZ to either side. The
+ * mains frequency is the candidate whose fundamental stands out most.
+ * From then on the window brackets the tracked fundamental with two more
+ * bins, MAINS_STEP_MHZ to each side, whose balance gives the frequency
+ * error, and the notches are retuned to follow grid drift.
+ *
+ * The interval between windows doubles up to MAINS_INTERVAL_MAX_MS while
+ * the estimate holds still, so a stable estimate costs a few multiplies
+ * per hundred samples; without mains interference no notch runs at all.
+ */
+#define MAINS_HARMONICS       3
+#define MAINS_WINDOW_MS       2000
+#define MAINS_INTERVAL_MIN_MS 1000
+#define MAINS_INTERVAL_MAX_MS 64000
+/** Reference bins this far from every mains bin, for the noise floor. */
+#define MAINS_REF_HZ          5
+/** Offset of the frequency error bins around the tracked fundamental. */
+#define MAINS_STEP_MHZ        250
+/**
+ * A harmonic is present at this power over its reference bins, 16 dB:
+ * below that the ECG's own harmonics near 50 Hz get notched now and then.
+ */
+#define MAINS_SNR             40
+/** -3 dB width of the notches in 0.01 Hz. */
+#define MAINS_NOTCH_BW_CHZ    100
+
+/* Three bins per harmonic of both candidates, or two more for tracking */
+#define MAINS_BINS (2 * 3 * MAINS_HARMONICS)
+
+struct mains_stats {
+    /** Tracked fundamental in mHz, 0 while none is detected. */
+    uint32_t freq_mhz;
+    /** Notched harmonics, bit h - 1 for harmonic h. */
+    uint8_t harmonics;
+    /** Estimation windows run and notch retunes since init. */
+    uint32_t estimates;
+    uint32_t retunes;
+    /** Current gap between estimation windows in samples. */
+    uint32_t interval;
+};
+
+struct mains {
+    uint32_t fs_hz;
+    uint32_t window;
+    uint32_t interval;
+    /* Samples until the next window starts, then samples into it */
+    uint32_t wait;
+    uint32_t n;
+    int32_t prev;
+
+    struct {
+        int32_t coef;
+        int32_t s1, s2;
+        uint32_t freq_mhz;
+    } bins[MAINS_BINS];
+    size_t nbins;
+
+    uint32_t freq_mhz;
+    uint8_t misses;
+    uint32_t estimates;
+    uint32_t retunes;
+
+    /* Notch coefficients, bumped generation on every change */
+    uint8_t harmonics;
+    struct biquad_coeffs notch[MAINS_HARMONICS];
+    uint32_t generation;
+};
+
+/** The notches of one lead, following a struct mains. Zero initialize. */
+struct mains_notch {
+    uint32_t generation;
+    uint8_t harmonics;
+    struct biquad section[MAINS_HARMONICS];
+};
+
+void mains_init(struct mains *m, uint32_t fs_hz);
+
+/**
+ * Feed @p n samples of the reference lead, ahead of any notch.
+ *
+ * @return 1 if the notches changed.
+ */
+int mains_update(struct mains *m, const int32_t *x, size_t n);
+
+/** Notch @p n samples of a lead in place, a no-op without mains. */
+void mains_notch_process(const struct mains *m, struct mains_notch *f,
+                         int32_t *x, size_t n);
+
+void mains_stats_get(const struct mains *m, struct mains_stats *st);
+
+#endif /* APP_DSP_MAINS_H_ */
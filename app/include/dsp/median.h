@@ -0,0 +1,90 @@
+#ifndef APP_DSP_MEDIAN_H_
+#define APP_DSP_MEDIAN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Sliding window median in O(log n) per sample.
+ *
+ * The window is kept as one array of heaps around the median: a max-heap
+ * of the lower half, the median, and a min-heap of the upper half, with
+ * the position of every ring slot tracked so the outgoing sample is
+ * replaced in place and sifted, never searched for. Storage is supplied
+ * by the caller, MEDIAN_WORDS(n) 32 bit words for a window of n samples.
+ */
+#define MEDIAN_MAX_WINDOW 32767
+
+/** Storage for a window of @p n samples, in 32 bit words. */
+#define MEDIAN_WORDS(n) (2 * (size_t)(n))
+
+struct median {
+    int32_t *data;
+    /* Heap index of every ring slot, and ring slot of every heap index */
+    int16_t *pos;
+    int16_t *heap;
+    uint16_t size;
+    uint16_t count;
+    uint16_t idx;
+};
+
+/**
+ * Initialize a median over windows of @p n samples.
+ *
+ * @param storage MEDIAN_WORDS(@p n) words, used until the median is
+ *                dropped.
+ *
+ * @return 0, or -1 if @p n is 0 or above MEDIAN_MAX_WINDOW.
+ */
+int median_init(struct median *m, uint32_t *storage, size_t n);
+
+/** Add a sample, dropping the oldest once the window is full. */
+void median_add(struct median *m, int32_t x);
+
+/** Median of the samples in the window, the upper one of an even count. */
+static inline int32_t median_get(const struct median *m)
+{
+    return m->data[m->heap[0]];
+}
+
+/** Replace every sample by the median of the window ending at it. */
+void median_process(struct median *m, int32_t *x, size_t n);
+
+/**
+ * Baseline wander removal with two cascaded medians after de Chazal et
+ * al.: 200 ms to drop the QRS, then 600 ms to drop P and T waves, leaving
+ * the baseline. The signal is delayed by the combined median delay,
+ * MEDIAN_BASELINE_DELAY(fs) samples, and the baseline subtracted.
+ */
+#define MEDIAN_BASELINE_W1(fs)    ((size_t)(fs) / 5 | 1)
+#define MEDIAN_BASELINE_W2(fs)    ((size_t)(fs) * 3 / 5 | 1)
+#define MEDIAN_BASELINE_DELAY(fs)                                              \
+    ((MEDIAN_BASELINE_W1(fs) - 1) / 2 + (MEDIAN_BASELINE_W2(fs) - 1) / 2)
+
+/** Storage for a baseline filter at @p fs Hz, in 32 bit words. */
+#define MEDIAN_BASELINE_WORDS(fs)                                              \
+    (MEDIAN_WORDS(MEDIAN_BASELINE_W1(fs)) +                                    \
+     MEDIAN_WORDS(MEDIAN_BASELINE_W2(fs)) + MEDIAN_BASELINE_DELAY(fs))
+
+struct median_baseline {
+    struct median m1;
+    struct median m2;
+    int32_t *delay;
+    uint32_t delay_len;
+    uint32_t delay_pos;
+};
+
+/**
+ * Initialize a baseline filter.
+ *
+ * @param storage At least MEDIAN_BASELINE_WORDS(@p fs_hz) words.
+ *
+ * @return 0, or -1 if @p words is too small.
+ */
+int median_baseline_init(struct median_baseline *b, uint32_t fs_hz,
+                         uint32_t *storage, size_t words);
+
+/** Filter @p n samples in place. */
+void median_baseline_process(struct median_baseline *b, int32_t *x, size_t n);
+
+#endif /* APP_DSP_MEDIAN_H_ */
@@ -0,0 +1,104 @@
+#ifndef APP_DSP_PAT_H_
+#define APP_DSP_PAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dsp/median.h"
+
+/**
+ * Pulse arrival time: from the ECG R peak to the foot of the PPG pulse it
+ * causes, a cuffless blood pressure trend (it shortens as pressure rises).
+ *
+ * The foot is found by the intersecting tangent method on the infrared
+ * PPG: the tangent at the steepest point of the upstroke crosses the
+ * level of the trough before it. The slope is taken over PAT_SLOPE_MS
+ * rather than one sample, so that sensor noise does not pick the
+ * steepest point at higher sample rates. Upstrokes are delimited as in the SpO2
+ * estimator, with a hysteresis of a third of the last pulse.
+ *
+ * R peaks and feet are both timed in microseconds on the common timebase
+ * and queued in arrival order, each pipeline at its own pace. Every R
+ * peak pairs with the first foot at least PAT_MIN_MS after it, provided
+ * that is within PAT_MAX_MS; both queues only ever lose their oldest
+ * entry, so matching is O(1) per event whichever pipeline runs ahead.
+ */
+#define PAT_MIN_MS 80
+#define PAT_MAX_MS 500
+
+#define PAT_SLOPE_MS  20
+#define PAT_SLOPE_MAX 8
+
+/** R peaks or feet waiting for their match, per queue. */
+#define PAT_QUEUE 8
+
+/** Pairs in the median of the reported arrival time. */
+#define PAT_BEATS 9
+
+struct pat_stats {
+    /** Median arrival time of the last PAT_BEATS pairs in us */
+    uint32_t pat_us;
+    /** Arrival time of the last pair, and the time of its R peak */
+    uint32_t last_pat_us;
+    int64_t last_r_us;
+    uint32_t pairs;
+    /** R peaks and feet that found no match */
+    uint32_t r_unpaired;
+    uint32_t feet_unpaired;
+};
+
+struct pat_queue {
+    int64_t t_us[PAT_QUEUE];
+    uint8_t head;
+    uint8_t count;
+};
+
+struct pat {
+    uint32_t fs_hz;
+
+    /* Upstroke search on the infrared PPG, in volume terms (negated) */
+    uint8_t state;
+    int32_t hyst;
+    int32_t hyst_min;
+    int32_t hist[PAT_SLOPE_MAX];
+    uint8_t span;
+    uint8_t hist_pos;
+    int32_t ext;
+    int32_t trough;
+    /* Steepest span of the upstroke: rise, level and time of its middle */
+    int32_t slope;
+    int64_t slope_mid2;
+    int64_t slope_us;
+
+    struct pat_queue r;
+    struct pat_queue feet;
+
+    uint32_t pairs;
+    uint32_t r_unpaired;
+    uint32_t feet_unpaired;
+    uint32_t last_pat_us;
+    int64_t last_r_us;
+    struct median pat_median;
+    uint32_t pat_buf[MEDIAN_WORDS(PAT_BEATS)];
+};
+
+void pat_init(struct pat *p, uint32_t ppg_fs_hz);
+
+/**
+ * Queue an R peak at @p t_us and pair what can be paired.
+ *
+ * @return Number of new pairs.
+ */
+size_t pat_r_peak(struct pat *p, int64_t t_us);
+
+/**
+ * Feed @p n infrared PPG samples, the first one taken at @p t0_us, queue
+ * the feet found and pair what can be paired.
+ *
+ * @return Number of new pairs.
+ */
+size_t pat_ppg(struct pat *p, const int32_t *ir, size_t n, int64_t t0_us);
+
+void pat_stats_get(const struct pat *p, struct pat_stats *st);
+
+#endif /* APP_DSP_PAT_H_ */
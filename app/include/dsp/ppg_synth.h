@@ -0,0 +1,74 @@
+#ifndef APP_DSP_PPG_SYNTH_H_
+#define APP_DSP_PPG_SYNTH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Synthetic red and infrared PPG.
+ *
+ * Produces the raw intensities of a reflective pulse oximeter in ADC
+ * counts: a DC level per channel dipping with every pulse, a systolic
+ * upstroke, a dicrotic wave on the decay, respiratory modulation of the
+ * DC level and sensor noise. The red pulse is scaled against the infrared
+ * one by the ratio of ratios of the set SpO2 on the default calibration
+ * curve. Used as the emulated sensor where no PPG front end is present.
+ *
+ * Pulses follow an internal rhythm like the synthetic ECG, or, once
+ * ppg_synth_pulse() was called, are started by the caller, e.g. a fixed
+ * pulse arrival time after the R peaks of an ecg_synth.
+ */
+#define PPG_SYNTH_RISE_MS 130
+
+/**
+ * The intersecting tangent foot of the smoothstep upstroke, where the
+ * tangent at its steepest point crosses the trough level, in us after the
+ * pulse onset: a sixth of the rise.
+ */
+#define PPG_SYNTH_FOOT_US (PPG_SYNTH_RISE_MS * 1000 / 6)
+
+struct ppg_synth {
+    uint32_t fs_hz;
+    uint32_t seed;
+    /** Mean RR interval and maximum RR jitter in milliseconds. */
+    uint32_t rr_ms;
+    uint32_t rr_jitter_ms;
+    /** DC levels in counts. */
+    int32_t dc_red;
+    int32_t dc_ir;
+    /** Pulse depth as a share of DC, Q16. */
+    uint32_t ac_red_q16;
+    uint32_t ac_ir_q16;
+    /** Peak uniform noise in counts. */
+    int32_t noise;
+
+    /* Generator state */
+    uint64_t n;
+    uint64_t beat_start;
+    uint32_t beat_len;
+    uint8_t triggered;
+};
+
+/**
+ * Initialize a generator at 98 % SpO2 and 2 % perfusion.
+ *
+ * @param seed Seed of the RR variability and the noise.
+ */
+void ppg_synth_init(struct ppg_synth *s, uint32_t fs_hz, uint32_t hr_bpm,
+                    uint32_t seed);
+
+/** Set SpO2 x 10 and the infrared perfusion index in 0.01 %. */
+void ppg_synth_set(struct ppg_synth *s, uint32_t spo2_dpct,
+                   uint32_t pi_cpct);
+
+/**
+ * Start a pulse at the next sample, and from then on only when called.
+ * The pulse decays over the interval since the previous one.
+ */
+void ppg_synth_pulse(struct ppg_synth *s);
+
+/** Generate the next @p n samples of both channels. */
+void ppg_synth_fill(struct ppg_synth *s, int32_t *red, int32_t *ir,
+                    size_t n);
+
+#endif /* APP_DSP_PPG_SYNTH_H_ */
@@ -0,0 +1,71 @@
+#ifndef APP_DSP_QRS_H_
+#define APP_DSP_QRS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dsp/biquad.h"
+#include "dsp/sliding.h"
+
+/**
+ * Streaming QRS detector after Pan and Tompkins.
+ *
+ * 5-15 Hz band-pass, five point derivative, squaring and a 150 ms moving
+ * window integral with adaptive signal/noise thresholds and a 200 ms
+ * refractory period. All state is fixed size, sample rates up to
+ * QRS_MAX_FS_HZ are supported.
+ */
+#define QRS_MAX_FS_HZ 1000
+#define QRS_MWI_MAX   (QRS_MAX_FS_HZ * 150 / 1000)
+
+struct qrs {
+    uint32_t fs_hz;
+    struct biquad hp;
+    struct biquad lp;
+    int32_t d[4];
+
+    /* Moving window integral of the squared derivative */
+    uint32_t sq[QRS_MWI_MAX];
+    uint64_t sq_sum;
+    /* Input magnitude over the same window, to locate the R peak */
+    struct sliding peak;
+    uint32_t peak_buf[SLIDING_WORDS(QRS_MWI_MAX)];
+    uint32_t win;
+    /* Window slot of the current sample */
+    uint32_t pos;
+
+    uint64_t n;
+    uint32_t mwi_prev;
+    int rising;
+
+    /* Adaptive thresholds, learnt over the first two seconds */
+    uint32_t spki;
+    uint32_t npki;
+    uint32_t threshold;
+    uint32_t learn_max;
+    uint64_t learn_sum;
+
+    /* Candidate above threshold */
+    int in_peak;
+    uint32_t peak_mwi;
+    uint64_t peak_r;
+
+    uint64_t last_beat;
+    int have_beat;
+};
+
+void qrs_init(struct qrs *q, uint32_t fs_hz);
+
+/**
+ * Process @p n baseline-filtered samples.
+ *
+ * @param beats     Filled with sample indices (counted from the first
+ *                  sample ever processed) of detected R peaks.
+ * @param max_beats Capacity of @p beats.
+ *
+ * @return Number of beats detected in this call.
+ */
+size_t qrs_process(struct qrs *q, const int32_t *x, size_t n,
+                   uint64_t *beats, size_t max_beats);
+
+#endif /* APP_DSP_QRS_H_ */
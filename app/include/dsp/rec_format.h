@@ -0,0 +1,103 @@
+#ifndef APP_DSP_REC_FORMAT_H_
+#define APP_DSP_REC_FORMAT_H_
+
+#include <stdint.h>
+
+/**
+ * Recorder flash layout.
+ *
+ * The recorder partition is a ring of REC_PAGE_SIZE pages. Each page
+ * starts with a header (little endian): magic u32, seq u32, sample rate
+ * u16, flags u16, nonce u8[8]. ecg_codec frames follow back to back and
+ * never cross a page boundary, the unused tail of a page is 0xFF. The
+ * page with the highest seq is the newest one.
+ *
+ * With REC_PAGE_FLAG_ENCRYPTED everything after the header is encrypted
+ * with AES-128-CTR, the initial counter block being nonce, seq (big
+ * endian) and four zero bytes.
+ *
+ * With REC_PAGE_FLAG_BASELINE the high byte of flags is the baseline
+ * filter of the beat detector while the page was filled, so the host
+ * analysis sees the same beats: 0 for the running medians, otherwise the
+ * high-pass cutoff in 0.01 Hz (saturated at 2.55 Hz).
+ */
+#define REC_PAGE_SIZE     4096
+#define REC_PAGE_MAGIC    0x50474345u /* "ECGP" */
+#define REC_PAGE_HDR_SIZE 20
+#define REC_ERASED        0xFF
+#define REC_NONCE_SIZE    8
+/** AES-128 recorder key */
+#define REC_KEY_SIZE      16
+
+#define REC_PAGE_FLAG_ENCRYPTED 0x0001
+#define REC_PAGE_FLAG_BASELINE  0x0002
+/** Recorded baseline of the medians, any other value is a cutoff */
+#define REC_BASELINE_MEDIAN     0
+
+struct rec_page_hdr {
+    uint32_t magic;
+    uint32_t seq;
+    uint16_t fs_hz;
+    uint16_t flags;
+    uint8_t nonce[REC_NONCE_SIZE];
+};
+
+/** Initial AES-CTR counter block of a page. */
+static inline void rec_page_iv(uint8_t iv[16], const struct rec_page_hdr *h)
+{
+    for (int i = 0; i < REC_NONCE_SIZE; i++) {
+        iv[i] = h->nonce[i];
+    }
+    for (int i = 0; i < 4; i++) {
+        iv[8 + i] = (uint8_t)(h->seq >> (24 - 8 * i));
+        iv[12 + i] = 0;
+    }
+}
+
+/** Record the baseline: REC_BASELINE_MEDIAN or a cutoff in 0.01 Hz. */
+static inline void rec_page_baseline_set(struct rec_page_hdr *h,
+                                         uint16_t baseline)
+{
+    h->flags = (uint16_t)((h->flags & 0xff) | REC_PAGE_FLAG_BASELINE |
+                          ((baseline < 0xff ? baseline : 0xff) << 8));
+}
+
+/** @return the recorded baseline, or -1 if the page does not carry one. */
+static inline int rec_page_baseline(const struct rec_page_hdr *h)
+{
+    return (h->flags & REC_PAGE_FLAG_BASELINE) ? h->flags >> 8 : -1;
+}
+
+static inline void rec_page_hdr_put(uint8_t *p, const struct rec_page_hdr *h)
+{
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(h->magic >> (8 * i));
+        p[4 + i] = (uint8_t)(h->seq >> (8 * i));
+    }
+    p[8] = (uint8_t)h->fs_hz;
+    p[9] = (uint8_t)(h->fs_hz >> 8);
+    p[10] = (uint8_t)h->flags;
+    p[11] = (uint8_t)(h->flags >> 8);
+    for (int i = 0; i < REC_NONCE_SIZE; i++) {
+        p[12 + i] = h->nonce[i];
+    }
+}
+
+/** @return 0 if @p p holds a valid page header, -1 otherwise. */
+static inline int rec_page_hdr_get(const uint8_t *p, struct rec_page_hdr *h)
+{
+    h->magic = 0;
+    h->seq = 0;
+    for (int i = 0; i < 4; i++) {
+        h->magic |= (uint32_t)p[i] << (8 * i);
+        h->seq |= (uint32_t)p[4 + i] << (8 * i);
+    }
+    h->fs_hz = (uint16_t)(p[8] | (p[9] << 8));
+    h->flags = (uint16_t)(p[10] | (p[11] << 8));
+    for (int i = 0; i < REC_NONCE_SIZE; i++) {
+        h->nonce[i] = p[12 + i];
+    }
+    return h->magic == REC_PAGE_MAGIC ? 0 : -1;
+}
+
+#endif /* APP_DSP_REC_FORMAT_H_ */
@@ -0,0 +1,82 @@
+#ifndef APP_DSP_SLIDING_H_
+#define APP_DSP_SLIDING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Sliding window minimum, maximum, mean and variance in O(1) amortized
+ * per sample.
+ *
+ * The last n samples are kept in a ring. Minimum and maximum come from
+ * monotonic deques of ring slots: a new sample drops every older one it
+ * beats from the back, the front leaves when its slot is overwritten, so
+ * the front is always the extreme of the window. Mean and variance come
+ * from exact integer sums, updated by the incoming and the outgoing
+ * sample, so they do not drift. Storage is supplied by the caller,
+ * SLIDING_WORDS(n) 32 bit words for a window of n samples.
+ *
+ * Samples must stay within +-2^23 (24 bit) for the sum of squares to fit.
+ */
+#define SLIDING_MAX_WINDOW 65535
+
+/** Storage for a window of @p n samples, in 32 bit words. */
+#define SLIDING_WORDS(n) (2 * (size_t)(n))
+
+struct sliding {
+    int32_t *ring;
+    /* Ring slots in arrival order, values decreasing and increasing */
+    uint16_t *maxq;
+    uint16_t *minq;
+    uint16_t size;
+    uint16_t count;
+    /* Ring slot of the next sample */
+    uint16_t pos;
+    uint16_t max_head, max_len;
+    uint16_t min_head, min_len;
+    int64_t sum;
+    uint64_t sum_sq;
+};
+
+/**
+ * Initialize a window of @p n samples.
+ *
+ * @param storage SLIDING_WORDS(@p n) words, used until the window is
+ *                dropped.
+ *
+ * @return 0, or -1 if @p n is 0 or above SLIDING_MAX_WINDOW.
+ */
+int sliding_init(struct sliding *s, uint32_t *storage, size_t n);
+
+/** Add a sample, dropping the oldest once the window is full. */
+void sliding_add(struct sliding *s, int32_t x);
+
+/* The getters below need at least one sample in the window. */
+
+static inline int32_t sliding_max(const struct sliding *s)
+{
+    return s->ring[s->maxq[s->max_head]];
+}
+
+static inline int32_t sliding_min(const struct sliding *s)
+{
+    return s->ring[s->minq[s->min_head]];
+}
+
+/** Samples since the maximum, 0 for the newest; the oldest of ties. */
+static inline uint32_t sliding_max_age(const struct sliding *s)
+{
+    return (uint32_t)(s->pos + 2 * s->size - 1 - s->maxq[s->max_head]) %
+           s->size;
+}
+
+/** Mean of the window, rounded toward zero. */
+static inline int32_t sliding_mean(const struct sliding *s)
+{
+    return (int32_t)(s->sum / s->count);
+}
+
+/** Population variance of the window, to within one unit. */
+uint64_t sliding_var(const struct sliding *s);
+
+#endif /* APP_DSP_SLIDING_H_ */
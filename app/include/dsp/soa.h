@@ -0,0 +1,28 @@
+#ifndef APP_DSP_SOA_H_
+#define APP_DSP_SOA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Interleaved front end data to per-lead rows.
+ *
+ * ECG front ends deliver one frame per sample instant with all leads
+ * interleaved. The samples have to be widened from 24 to 32 bits anyway;
+ * writing them transposed in the same pass makes the deinterleave free.
+ */
+
+/**
+ * Unpack @p n frames of @p leads big endian 24 bit two's complement
+ * samples (ADS129x data format, status word already skipped).
+ *
+ * @param out    Lead l, sample i goes to out[l * stride + i].
+ */
+void soa_unpack_s24be(const uint8_t *in, size_t n, size_t leads, int32_t *out,
+                      size_t stride);
+
+/** Pack per-lead rows into frames, the inverse of soa_unpack_s24be(). */
+void soa_pack_s24be(const int32_t *in, size_t n, size_t leads, size_t stride,
+                    uint8_t *out);
+
+#endif /* APP_DSP_SOA_H_ */
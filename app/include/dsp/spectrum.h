@@ -0,0 +1,77 @@
+#ifndef APP_DSP_SPECTRUM_H_
+#define APP_DSP_SPECTRUM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef CONFIG_APP_SPECTRUM_CMSIS
+#include <arm_math.h>
+#endif
+
+/**
+ * Fixed-point real FFT shared by the spectral analyses.
+ *
+ * On Cortex-M with CONFIG_APP_SPECTRUM_CMSIS the transform is CMSIS-DSP
+ * arm_rfft_q31. Elsewhere it is a portable radix-4 (radix-2^2, one
+ * radix-2 stage for odd powers of two) complex FFT of n / 2 points and a
+ * real-to-complex split, both scaled down by 4 per stage so that no input
+ * overflows, and driven by one precomputed Q31 twiddle table in flash, or
+ * in RAM with CONFIG_APP_SPECTRUM_TWIDDLE_RAM. Either way the input is
+ * normalised to the full Q31 range first (block floating point), so small
+ * signals keep their precision.
+ */
+#define SPECTRUM_MIN_N 32
+#define SPECTRUM_MAX_N 4096
+
+/** Fractional bits of spectrum_power() output. */
+#define SPECTRUM_POWER_FRAC 16
+
+/** Working buffer of an @p n point transform, in 32 bit words. */
+#ifdef CONFIG_APP_SPECTRUM_CMSIS
+/* arm_rfft_q31 writes the full complex spectrum behind the input */
+#define SPECTRUM_WORDS(n) (3 * (size_t)(n))
+#else
+#define SPECTRUM_WORDS(n) ((size_t)(n) + 2)
+#endif
+
+struct spectrum {
+    uint32_t n;
+    uint32_t log2n;
+#ifdef CONFIG_APP_SPECTRUM_CMSIS
+    arm_rfft_instance_q31 rfft;
+#endif
+};
+
+/**
+ * Set up an @p n point transform.
+ *
+ * @return 0, or -1 if @p n is not a power of two within SPECTRUM_MIN_N
+ *         and SPECTRUM_MAX_N.
+ */
+int spectrum_init(struct spectrum *s, uint32_t n);
+
+/** Multiply @p n samples by a Hann window, in place. */
+void spectrum_hann(const struct spectrum *s, int32_t *x);
+
+/**
+ * Forward transform in place.
+ *
+ * @param buf SPECTRUM_WORDS(n) words, the n input samples first. Holds
+ *            bins 0 to n / 2 as (re, im) pairs on return, the DFT divided
+ *            by n in the units of the input shifted left by the return
+ *            value.
+ *
+ * @return The normalisation shift, 0 to 31.
+ */
+int spectrum_rfft(const struct spectrum *s, int32_t *buf);
+
+/**
+ * Power spectrum: |DFT / n|^2 of bins 0 to n / 2 in input units squared,
+ * with SPECTRUM_POWER_FRAC fractional bits.
+ *
+ * @param buf   As for spectrum_rfft(), overwritten.
+ * @param power n / 2 + 1 values.
+ */
+void spectrum_power(const struct spectrum *s, int32_t *buf, uint64_t *power);
+
+#endif /* APP_DSP_SPECTRUM_H_ */
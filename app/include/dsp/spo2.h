@@ -0,0 +1,130 @@
+#ifndef APP_DSP_SPO2_H_
+#define APP_DSP_SPO2_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dsp/median.h"
+
+/**
+ * Oxygen saturation and perfusion index from red and infrared PPG.
+ *
+ * The infrared channel is cut into beats at its pulse troughs (intensity
+ * maxima, blood absorbs), found with a hysteresis of a third of the last
+ * pulse amplitude. For every beat both channels give AC, the pulse height
+ * over the trough line drawn between the two troughs, so baseline drift
+ * cancels, and DC, the mean intensity over the beat. The ratio of ratios
+ * R = (AC_red / DC_red) / (AC_ir / DC_ir) of the last SPO2_BEATS valid
+ * beats is median filtered and mapped to SpO2 by a calibration curve
+ * kept in flash.
+ *
+ * Work per sample is fixed and per beat bounded by SPO2_BEATS and the
+ * curve length, so the cost per second only depends on the sample rate.
+ */
+#define SPO2_BEATS 9
+
+/** Beats outside this range of periods are rejected. */
+#define SPO2_PERIOD_MIN_MS 250
+#define SPO2_PERIOD_MAX_MS 2000
+
+/** Infrared perfusion outside this range, in 0.01 %, is rejected. */
+#define SPO2_PI_MIN_CPCT 2
+#define SPO2_PI_MAX_CPCT 2000
+
+/** One calibration point: ratio of ratios in Q16 and SpO2 x 10. */
+struct spo2_point {
+    uint32_t r_q16;
+    uint16_t spo2_dpct;
+};
+
+/** Calibration curve, points by ascending ratio and descending SpO2. */
+struct spo2_curve {
+    const struct spo2_point *points;
+    size_t count;
+};
+
+/** Empirical curve of a generic 660/940 nm sensor. */
+extern const struct spo2_curve spo2_curve_default;
+
+struct spo2_stats {
+    /** SpO2 x 10, 0 until SPO2_BEATS / 2 + 1 beats were accepted */
+    uint32_t spo2_dpct;
+    /** Infrared perfusion index in 0.01 % */
+    uint32_t pi_cpct;
+    /** Pulse rate x 10 */
+    uint32_t pr_dbpm;
+    /** Ratio of ratios in Q16 */
+    uint32_t r_q16;
+    /** Beats accepted and rejected since init */
+    uint32_t beats;
+    uint32_t rejected;
+};
+
+/* Pulse extremes of one channel, in blood volume terms (negated) */
+struct spo2_channel {
+    int32_t trough;
+    int32_t peak;
+    /* Intensity sum since the last trough was found */
+    int64_t sum;
+};
+
+struct spo2 {
+    uint32_t fs_hz;
+    const struct spo2_curve *curve;
+
+    /* Sample counter, and the samples of the infrared extremes */
+    uint64_t n;
+    uint64_t trough_n;
+    uint64_t peak_n;
+    uint64_t ext_n;
+    uint32_t sum_count;
+    uint8_t state;
+    uint8_t have_trough;
+    uint8_t have_peak;
+    /* Hysteresis of the extreme search, and its floor */
+    int32_t hyst;
+    int32_t hyst_min;
+    /* Extreme of the current search, infrared and red at that sample */
+    int32_t ext_ir;
+    int32_t ext_red;
+    struct spo2_channel red;
+    struct spo2_channel ir;
+
+    uint32_t beats;
+    uint32_t rejected;
+    /* Period of the last accepted beat, ended by the trough at trough_n */
+    uint32_t last_period_ms;
+    struct median r_median;
+    struct median pi_median;
+    struct median period_median;
+    uint32_t r_buf[MEDIAN_WORDS(SPO2_BEATS)];
+    uint32_t pi_buf[MEDIAN_WORDS(SPO2_BEATS)];
+    uint32_t period_buf[MEDIAN_WORDS(SPO2_BEATS)];
+};
+
+/**
+ * Initialize an estimator.
+ *
+ * @param curve Calibration, NULL for spo2_curve_default.
+ *
+ * @return 0, or -1 if the curve has fewer than two points.
+ */
+int spo2_init(struct spo2 *o, uint32_t fs_hz, const struct spo2_curve *curve);
+
+/**
+ * Feed @p n simultaneous samples of the red and infrared intensity.
+ *
+ * @return Number of beats completed, accepted or not.
+ */
+size_t spo2_process(struct spo2 *o, const int32_t *red, const int32_t *ir,
+                    size_t n);
+
+void spo2_stats_get(const struct spo2 *o, struct spo2_stats *st);
+
+/** SpO2 x 10 of a ratio of ratios in Q16, clamped to the curve. */
+uint32_t spo2_from_ratio(const struct spo2_curve *curve, uint32_t r_q16);
+
+/** Inverse of spo2_from_ratio(), for emulated sensors. */
+uint32_t spo2_to_ratio(const struct spo2_curve *curve, uint32_t spo2_dpct);
+
+#endif /* APP_DSP_SPO2_H_ */
@@ -0,0 +1,80 @@
+#ifndef APP_DSP_SQI_H_
+#define APP_DSP_SQI_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dsp/sliding.h"
+
+/**
+ * Signal quality of one lead over a sliding window of whole blocks.
+ *
+ * Every block is reduced to its minimum, maximum and mean absolute first
+ * difference, and sliding kernels over the last SQI_WINDOW_MS of blocks
+ * give the window extremes and the noise floor, the first difference of
+ * the quietest block. QRS complexes raise only the blocks they fall in,
+ * so the floor follows broadband noise (muscle, mains, a loose electrode)
+ * and not the heart rate. A block costs one pass over its samples plus
+ * O(1) per kernel; the window costs SQI_WORDS(blocks) words.
+ */
+#define SQI_WINDOW_MS 2000
+/** Peak to peak over the window below this is a flat line or lead off. */
+#define SQI_FLAT_UV   50
+/** Noise floor above this, about 27 uV RMS of white noise, is noisy. */
+#define SQI_NOISE_UV  30
+
+/** Blocks of @p block_samples at @p fs Hz covering SQI_WINDOW_MS. */
+#define SQI_BLOCKS(fs, block_samples)                                          \
+    (((size_t)(fs) * SQI_WINDOW_MS / 1000 + (block_samples) - 1) /             \
+     (block_samples))
+
+/** Storage for a window of @p blocks, in 32 bit words. */
+#define SQI_WORDS(blocks) (3 * SLIDING_WORDS(blocks))
+
+/** Lead states, worst last. */
+enum sqi_state {
+    SQI_GOOD,
+    SQI_NOISY,
+    SQI_FLAT,
+    SQI_SATURATED,
+    SQI_STATES,
+};
+
+/** Blocks per state since sqi_stats_get() was last reset. */
+struct sqi_stats {
+    uint32_t blocks[SQI_STATES];
+    /** Of the last block: window peak to peak and noise floor. */
+    int32_t p2p_uv;
+    int32_t noise_uv;
+};
+
+struct sqi {
+    struct sliding hi;
+    struct sliding lo;
+    struct sliding noise;
+    int32_t rail_uv;
+    int32_t last;
+    uint8_t state;
+    uint32_t blocks[SQI_STATES];
+};
+
+/**
+ * Initialize the quality index of a lead.
+ *
+ * @param blocks  Window length in blocks, see SQI_BLOCKS().
+ * @param rail_uv Input range of the front end; samples within 1/64 of
+ *                +-@p rail_uv count as saturated.
+ * @param storage SQI_WORDS(@p blocks) words, kept in use.
+ *
+ * @return 0, or -1 if @p words is too small or @p blocks out of range.
+ */
+int sqi_init(struct sqi *q, size_t blocks, int32_t rail_uv,
+             uint32_t *storage, size_t words);
+
+/** Account a block of @p n > 0 samples and return the lead state. */
+enum sqi_state sqi_block(struct sqi *q, const int32_t *x, size_t n);
+
+/** Get the block counts, optionally starting over. */
+void sqi_stats_get(struct sqi *q, struct sqi_stats *st, int reset);
+
+#endif /* APP_DSP_SQI_H_ */
@@ -0,0 +1,76 @@
+#ifndef APP_DSP_WIRE_FRAME_H_
+#define APP_DSP_WIRE_FRAME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Framing of the wired byte streams (gateway UART, USB CDC ACM).
+ *
+ * Frame (little endian): sync 0xA5 0x5A, type u8, source u8, length u16,
+ * payload, CRC-16/CCITT-FALSE u16 over type through payload. A receiver
+ * that loses sync skips to the next sync pair; a bad CRC drops the frame.
+ */
+#define WIRE_SYNC0        0xA5
+#define WIRE_SYNC1        0x5A
+#define WIRE_HDR_SIZE     6
+#define WIRE_CRC_SIZE     2
+#define WIRE_PAYLOAD_MAX  4096
+
+/** Bytes on the wire for a payload of @p len bytes. */
+#define WIRE_FRAME_SIZE(len) (WIRE_HDR_SIZE + (size_t)(len) + WIRE_CRC_SIZE)
+
+enum wire_type {
+    /** One ecg_codec frame. */
+    WIRE_TYPE_ECG = 1,
+};
+
+uint16_t wire_crc16(uint16_t crc, const uint8_t *data, size_t len);
+
+/**
+ * Write the header of a frame carrying @p len payload bytes.
+ *
+ * Header and CRC are written separately so that the payload can be
+ * produced in place behind the header.
+ */
+void wire_frame_hdr(uint8_t hdr[WIRE_HDR_SIZE], uint8_t type, uint8_t src,
+                    uint16_t len);
+
+/** CRC of a frame given its header and payload. */
+void wire_frame_crc(uint8_t crc[WIRE_CRC_SIZE],
+                    const uint8_t hdr[WIRE_HDR_SIZE], const uint8_t *payload,
+                    uint16_t len);
+
+/**
+ * Encode a complete frame.
+ *
+ * @return Frame size, 0 if it does not fit into @p cap.
+ */
+size_t wire_frame_encode(uint8_t type, uint8_t src, const uint8_t *payload,
+                         uint16_t len, uint8_t *out, size_t cap);
+
+/** Incremental receiver, fed one byte at a time. */
+struct wire_parser {
+    uint8_t hdr[WIRE_HDR_SIZE];
+    uint8_t crc[WIRE_CRC_SIZE];
+    size_t pos;
+    uint16_t len;
+
+    /** Valid after wire_parser_feed() returned 1. */
+    uint8_t type;
+    uint8_t src;
+    uint16_t payload_len;
+    uint8_t payload[WIRE_PAYLOAD_MAX];
+
+    uint32_t frames;
+    uint32_t crc_errors;
+    /** Bytes skipped while looking for sync. */
+    uint32_t skipped;
+};
+
+void wire_parser_init(struct wire_parser *p);
+
+/** @return 1 when @p byte completed a valid frame, 0 otherwise. */
+int wire_parser_feed(struct wire_parser *p, uint8_t byte);
+
+#endif /* APP_DSP_WIRE_FRAME_H_ */
@@ -0,0 +1,35 @@
+#ifndef APP_ECG_SERVICE_H_
+#define APP_ECG_SERVICE_H_
+
+#include <stdint.h>
+#include <zephyr/bluetooth/uuid.h>
+
+/**
+ * ECG streaming GATT service.
+ *
+ * One notify-only characteristic; every notification carries exactly one
+ * ecg_codec frame (see dsp/ecg_codec.h), so the block sequence number in
+ * the frame header exposes lost notifications to the client.
+ */
+#define BT_UUID_ECG_SERVICE_VAL                                                \
+    BT_UUID_128_ENCODE(0x6b1c0001, 0x4c2e, 0x4d3a, 0x9b7e, 0x2f1a8c3e5d10)
+#define BT_UUID_ECG_STREAM_VAL                                                 \
+    BT_UUID_128_ENCODE(0x6b1c0002, 0x4c2e, 0x4d3a, 0x9b7e, 0x2f1a8c3e5d10)
+
+#define BT_UUID_ECG_SERVICE BT_UUID_DECLARE_128(BT_UUID_ECG_SERVICE_VAL)
+#define BT_UUID_ECG_STREAM  BT_UUID_DECLARE_128(BT_UUID_ECG_STREAM_VAL)
+
+struct sample_block;
+
+/**
+ * Compress a block and queue it for notification.
+ *
+ * Called from the DSP thread. Does nothing without a subscriber and never
+ * waits for the radio: blocks that find no free packet are dropped.
+ */
+void ecg_service_put(const struct sample_block *block);
+
+/** Log notification and drop counters. */
+void ecg_service_stats_log(void);
+
+#endif /* APP_ECG_SERVICE_H_ */
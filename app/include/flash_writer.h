@@ -0,0 +1,63 @@
+#ifndef APP_FLASH_WRITER_H_
+#define APP_FLASH_WRITER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+/**
+ * Double-buffered page writer for the recorder partition.
+ *
+ * Frames are copied into one RAM page while the other one is programmed
+ * by a low priority writer thread. The next flash page is erased right
+ * after a page is programmed, so erase time overlaps with filling the
+ * buffer. flash_writer_append() never waits for flash.
+ */
+
+struct flash_writer_stats {
+    uint32_t pages_written;
+    /** Frames dropped because both RAM pages were waiting for flash. */
+    uint32_t frames_dropped;
+    /** Worst-case time spent in flash_writer_append(). */
+    uint32_t max_append_us;
+    uint32_t max_program_us;
+    uint32_t max_erase_us;
+    /** Page encryption: worst case time, total bytes and total time. */
+    uint32_t max_encrypt_us;
+    uint64_t encrypt_bytes;
+    uint64_t encrypt_us;
+};
+
+/**
+ * Append a frame to the current page.
+ *
+ * @return 0 on success, -EBUSY if the frame was dropped because no RAM
+ *         page is free, -EINVAL if it can never fit into a page.
+ */
+int flash_writer_append(const void *data, size_t len);
+
+/**
+ * Set the beat detector baseline recorded in pages started from now on,
+ * REC_BASELINE_MEDIAN or the high-pass cutoff in 0.01 Hz.
+ *
+ * Must be called from the thread that calls flash_writer_append().
+ */
+void flash_writer_set_baseline(uint16_t baseline);
+
+/**
+ * Seal the partially filled page and wait until the writer thread has
+ * programmed every sealed page.
+ *
+ * Called before a reset so that the last page of ECG is not lost; safe
+ * from any thread. Frames appended meanwhile start a new page.
+ *
+ * @return 0 once the pages are in flash, -EAGAIN on timeout (e.g. the
+ *         recorder key is not provisioned yet).
+ */
+int flash_writer_flush(k_timeout_t timeout);
+
+void flash_writer_stats_get(struct flash_writer_stats *stats);
+
+void flash_writer_stats_log(void);
+
+#endif /* APP_FLASH_WRITER_H_ */
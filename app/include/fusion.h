@@ -0,0 +1,71 @@
+#ifndef APP_FUSION_H_
+#define APP_FUSION_H_
+
+#include <stdint.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "dsp/hr_fusion.h"
+
+/**
+ * Heart rate fused from the ECG, the PPG and the motion context.
+ *
+ * The DSP and PPG threads publish the heart rate of every beat, and an
+ * emulated accelerometer its activity once a second, on zbus channels. A
+ * message subscriber thread feeds them to the filter of dsp/hr_fusion.h
+ * and publishes the estimate on fusion_hr_chan after every beat. Work per
+ * message is O(1) and at most CONFIG_ZBUS_MSG_SUBSCRIBER_NET_BUF_POOL_SIZE
+ * messages wait; publishers never block, a message that finds the pool
+ * empty is counted and lost.
+ *
+ * With CONFIG_APP_HR_FUSION_PPG_OFF the PPG sensor is switched off once
+ * the ECG has been reliable for CONFIG_APP_HR_FUSION_PPG_OFF_S and back on
+ * as soon as it is not.
+ */
+
+/** Heart rate of one beat, timed on the common timebase. */
+struct fusion_beat {
+    int64_t t_us;
+    uint32_t hr_cbpm;
+    /** See hr_fusion_update() */
+    uint8_t degraded;
+};
+
+struct fusion_motion {
+    int64_t t_us;
+    uint32_t activity_mg;
+};
+
+/** Estimate after the beat at t_us. */
+struct fusion_hr {
+    int64_t t_us;
+    uint32_t hr_cbpm;
+    uint32_t sd_cbpm;
+    uint8_t valid;
+    /** Reliable sources, bit per enum hr_source */
+    uint8_t reliable;
+};
+
+ZBUS_CHAN_DECLARE(fusion_ecg_chan, fusion_ppg_chan, fusion_motion_chan,
+                  fusion_hr_chan);
+
+struct fusion_stats {
+    struct hr_fusion_stats hr;
+    /** Messages lost to a full subscriber queue */
+    uint32_t dropped;
+    /** Times the PPG sensor was switched off */
+    uint32_t ppg_off;
+};
+
+/**
+ * Publish the heart rate of a beat. Called from the DSP and PPG threads,
+ * never waits.
+ */
+void fusion_ecg_beat(int64_t t_us, uint32_t hr_cbpm, uint8_t degraded);
+void fusion_ppg_beat(int64_t t_us, uint32_t hr_cbpm, uint8_t degraded);
+
+void fusion_stats_get(struct fusion_stats *st);
+
+/** Log the fused heart rate, the sources and the messages lost. */
+void fusion_stats_log(void);
+
+#endif /* APP_FUSION_H_ */
@@ -0,0 +1,58 @@
+#ifndef APP_PIPELINE_H_
+#define APP_PIPELINE_H_
+
+#include <stdint.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/time_units.h>
+#include <zephyr/toolchain.h>
+
+/**
+ * Shape of the data path, from the kardio,ecg-pipeline devicetree node.
+ *
+ * Everything here is an integer constant expression, so buffers are sized
+ * and per-lead loops bounded at build time.
+ */
+#define PIPELINE_NODE DT_CHOSEN(kardio_ecg_pipeline)
+
+BUILD_ASSERT(DT_NODE_HAS_STATUS_OKAY(PIPELINE_NODE),
+             "no kardio,ecg-pipeline chosen node, include "
+             "<kardio/ecg-pipeline.dtsi> in the board overlay");
+
+/** Sample rate of every lead in Hz. */
+#define PIPELINE_SAMPLE_RATE_HZ DT_PROP(PIPELINE_NODE, sample_rate_hz)
+
+/** Samples per lead in one sample block. */
+#define PIPELINE_BLOCK_SAMPLES DT_PROP(PIPELINE_NODE, block_samples)
+
+/** Leads per sample block, lead 0 is the primary lead. */
+#define PIPELINE_LEADS DT_PROP(PIPELINE_NODE, leads)
+
+/** Input range of the front end, +- this many microvolts. */
+#define PIPELINE_FULL_SCALE_UV DT_PROP(PIPELINE_NODE, full_scale_uv)
+
+/** Initial baseline wander cutoff of the beat detector in 0.01 Hz. */
+#define PIPELINE_BASELINE_CUTOFF_CHZ                                           \
+    DT_PROP(PIPELINE_NODE, baseline_cutoff_centihz)
+
+/** Mains detection and tracking notches on every lead. */
+#define PIPELINE_MAINS_AUTO (DT_ENUM_IDX(PIPELINE_NODE, mains_filter) == 0)
+
+/** Baseline wander removal by running medians instead of the high-pass. */
+#define PIPELINE_BASELINE_MEDIAN                                               \
+    (DT_ENUM_IDX(PIPELINE_NODE, baseline_filter) == 1)
+
+/** Number of conditioning filter stages. */
+#define PIPELINE_FILTERS DT_CHILD_NUM_STATUS_OKAY(PIPELINE_NODE)
+
+/** Filter stage types, in the order of the binding's type enum. */
+#define PIPELINE_FILTER_HIGHPASS 0
+#define PIPELINE_FILTER_LOWPASS  1
+
+BUILD_ASSERT(USEC_PER_SEC % PIPELINE_SAMPLE_RATE_HZ == 0,
+             "sample period must be a whole number of microseconds");
+BUILD_ASSERT(PIPELINE_LEADS >= 1 && PIPELINE_LEADS <= 12,
+             "1 to 12 leads are supported");
+BUILD_ASSERT(PIPELINE_BLOCK_SAMPLES > 0 && PIPELINE_BLOCK_SAMPLES <= UINT16_MAX,
+             "block size out of range");
+
+#endif /* APP_PIPELINE_H_ */
@@ -0,0 +1,57 @@
+#ifndef APP_PPG_H_
+#define APP_PPG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dsp/pat.h"
+#include "dsp/spo2.h"
+
+/**
+ * Pulse oximetry and pulse arrival time on the emulated red and infrared
+ * PPG sensor.
+ *
+ * A thread of its own acquires CONFIG_APP_PPG_BLOCK_SAMPLES of both
+ * channels per block, timestamped on the common timebase like the ECG
+ * blocks, and runs the SpO2 estimator (dsp/spo2.h) and the pulse arrival
+ * time (dsp/pat.h) on them. Their CPU time, counted in cycles of the
+ * timing API, is summed per second of signal against
+ * CONFIG_APP_PPG_US_PER_S.
+ */
+struct ppg_stats {
+    struct spo2_stats spo2;
+    struct pat_stats pat;
+    /** R peaks lost because the PPG thread fell behind. */
+    uint32_t r_dropped;
+    /** Most estimator time in us spent on one second of signal. */
+    uint32_t us_per_s_max;
+    /** Seconds of signal over the cycle budget. */
+    uint32_t over_budget;
+    /** Seconds the sensor was switched off. */
+    uint32_t off_s;
+};
+
+/**
+ * Hand over an R peak detected at @p r_us on the common timebase. Called
+ * from the DSP thread, never waits.
+ */
+void ppg_r_peak(int64_t r_us);
+
+/**
+ * A beat of the emulated ECG with its R peak at @p r_us: the emulated PPG
+ * sensor pulses a fixed arrival time later. Called by the acquisition.
+ */
+void ppg_emul_heartbeat(int64_t r_us);
+
+/**
+ * Switch the sensor on or off. While off, the estimators get no samples
+ * and SpO2 and pulse arrival time keep their last values.
+ */
+void ppg_power(bool on);
+
+void ppg_stats_get(struct ppg_stats *st);
+
+/** Log SpO2, perfusion, pulse rate, arrival time and cycle budget use. */
+void ppg_stats_log(void);
+
+#endif /* APP_PPG_H_ */
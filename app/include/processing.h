@@ -0,0 +1,56 @@
+#ifndef APP_PROCESSING_H_
+#define APP_PROCESSING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_settings.h"
+#include "dsp/delin.h"
+#include "dsp/hrv.h"
+#include "dsp/sqi.h"
+
+/**
+ * Apply calibration and filter settings.
+ *
+ * Takes effect at the next block boundary of the DSP thread.
+ */
+void processing_configure(const struct cal_settings *cal,
+                          const struct filter_settings *filter);
+
+/** Number of blocks processed by the DSP thread. */
+uint32_t processing_blocks(void);
+
+/**
+ * Beats detected so far and HRV over the most recent ones.
+ *
+ * @param hrv Filled with the HRV snapshot of the last beat.
+ */
+uint32_t processing_beats(struct hrv_stats *hrv);
+
+/**
+ * Frequency domain HRV and respiration rate, updated every 16 beats once
+ * HRV_FREQ_MIN_BEATS intervals are in the window; zero until then.
+ */
+void processing_hrv_freq(struct hrv_freq *fr);
+
+/** Interval means (QRS, PR, QT, QTc, ST) over all beats delineated so far. */
+void processing_delin(struct delin_stats *st);
+
+/**
+ * Signal quality of every lead, as of the last block.
+ *
+ * @return Number of leads stored, at most @p max.
+ */
+size_t processing_sqi(struct sqi_stats *st, size_t max);
+
+/**
+ * Log DSP load per block against the block period, the current HRV in
+ * the time and frequency domains, the delineation means and the signal
+ * quality of the leads.
+ *
+ * The load is wall time, so interrupt load (e.g. the BLE controller on a
+ * single core SoC) shows up as the gap between average and maximum.
+ */
+void processing_stats_log(void);
+
+#endif /* APP_PROCESSING_H_ */
@@ -0,0 +1,51 @@
+#ifndef APP_REC_CRYPTO_H_
+#define APP_REC_CRYPTO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/bluetooth/uuid.h>
+
+#include "dsp/rec_format.h"
+
+/**
+ * At-rest encryption of recorder pages with PSA Crypto AES-CTR.
+ *
+ * The AES key is generated by the clinical backend, which keeps it to
+ * decrypt the recordings, and provisioned once into a persistent PSA key
+ * that can encrypt only and never be read back. With
+ * CONFIG_APP_RECORDER_KEY_BLE it is written to the recorder key
+ * characteristic over a link paired with LE Secure Connections and the
+ * strap's own passkey from the UICR (or the image's). With a PSA driver for the nRF52840 CryptoCell (nrf_security)
+ * the cipher runs in hardware, otherwise in the mbedTLS software
+ * implementation.
+ */
+#define BT_UUID_REC_KEY_SERVICE_VAL                                            \
+    BT_UUID_128_ENCODE(0x6b1c0010, 0x4c2e, 0x4d3a, 0x9b7e, 0x2f1a8c3e5d10)
+#define BT_UUID_REC_KEY_VAL                                                    \
+    BT_UUID_128_ENCODE(0x6b1c0011, 0x4c2e, 0x4d3a, 0x9b7e, 0x2f1a8c3e5d10)
+
+#define BT_UUID_REC_KEY_SERVICE BT_UUID_DECLARE_128(BT_UUID_REC_KEY_SERVICE_VAL)
+#define BT_UUID_REC_KEY         BT_UUID_DECLARE_128(BT_UUID_REC_KEY_VAL)
+
+/**
+ * Load the recorder key, waiting until it is provisioned, and draw the
+ * per-boot nonce.
+ *
+ * @param nonce Filled with the nonce to store in every page header.
+ */
+int rec_crypto_init(uint8_t nonce[REC_NONCE_SIZE]);
+
+/**
+ * Store the recorder key. Done once: a key is never replaced, the
+ * recordings made with it would be lost.
+ *
+ * @return 0 on success, -EEXIST if a key is already stored, -EIO on a
+ *         PSA error.
+ */
+int rec_crypto_provision(const uint8_t key[REC_KEY_SIZE]);
+
+/** Encrypt @p len bytes in place, as one AES-CTR stream for the page. */
+int rec_crypto_page(const struct rec_page_hdr *hdr, uint8_t *data,
+                    size_t len);
+
+#endif /* APP_REC_CRYPTO_H_ */
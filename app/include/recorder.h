@@ -0,0 +1,22 @@
+#ifndef APP_RECORDER_H_
+#define APP_RECORDER_H_
+
+#include "blocks.h"
+
+/**
+ * Compress a block and queue it for the recorder partition.
+ *
+ * Called from the DSP thread, does not wait for flash.
+ */
+void recorder_put(const struct sample_block *block);
+
+/**
+ * Record the beat detector baseline with the following blocks, so that a
+ * host analysis of the recording filters as the device did.
+ *
+ * @param baseline_cutoff_chz High-pass cutoff in 0.01 Hz, 0 for the
+ *        running medians.
+ */
+void recorder_set_baseline(uint16_t baseline_cutoff_chz);
+
+#endif /* APP_RECORDER_H_ */
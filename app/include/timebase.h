@@ -0,0 +1,13 @@
+#ifndef APP_TIMEBASE_H_
+#define APP_TIMEBASE_H_
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+/** Common timebase for all pipelines: microseconds since kernel start. */
+static inline int64_t timebase_now_us(void)
+{
+    return (int64_t)k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+#endif /* APP_TIMEBASE_H_ */
@@ -0,0 +1,21 @@
+#ifndef APP_WIRED_H_
+#define APP_WIRED_H_
+
+struct sample_block;
+
+/**
+ * Wired ECG output on the kardio,wire-uart chosen device.
+ *
+ * Every block goes out as one WIRE_TYPE_ECG frame (dsp/wire_frame.h)
+ * carrying an ecg_codec frame. Called from the DSP thread, never waits
+ * for the link: a block that does not fit the filling buffer is dropped
+ * and counted, which happens when the link is slower than the blocks or
+ * a transfer failed to start. A failed start is retried on the next
+ * block; wirecat sees a drop as a gap in the block numbers.
+ */
+void wired_put(const struct sample_block *block);
+
+/** Log throughput, drops and the CPU time spent per block. */
+void wired_stats_log(void);
+
+#endif /* APP_WIRED_H_ */
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""Sum radio-on time per device from BabbleSim 2G4 phy dumps.
+
+Run the phy with -dump; it writes d_2G4_<device>.Tx.csv and .Rx.csv into
+${BSIM_OUT_PATH}/results/<simulation id>. Times in the dumps are in
+microseconds of simulated time.
+"""
+
+import argparse
+import csv
+import glob
+import os
+import re
+import sys
+
+
+def column(row, *names):
+    for name in names:
+        if row.get(name) not in (None, ""):
+            return int(row[name])
+    return None
+
+
+def tx_time(path):
+    total = 0
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            start = column(row, "start_tx_time", "start_time")
+            end = column(row, "end_tx_time", "end_time")
+            total += end - start
+    return total
+
+
+def rx_time(path):
+    """Receiver on from the scan start to the packet end or scan end."""
+    total = 0
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            start = column(row, "start_time")
+            end = start + column(row, "scan_duration")
+            payload_end = column(row, "payload_end", "end_time")
+            if payload_end:
+                end = min(end, payload_end)
+            total += max(end - start, 0)
+    return total
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("results", help="simulation results directory")
+    parser.add_argument("--length-s", type=float,
+                        help="simulated length, prints the duty cycle")
+    args = parser.parse_args()
+
+    devices = {}
+    for path in glob.glob(os.path.join(args.results, "d_2G4_*.[TR]x.csv")):
+        m = re.search(r"d_2G4_(\d+)\.(Tx|Rx)\.csv$", path)
+        if m:
+            devices.setdefault(int(m.group(1)), {})[m.group(2)] = path
+    if not devices:
+        sys.exit("radio_time: no phy dumps in " + args.results)
+
+    for dev, paths in sorted(devices.items()):
+        tx = tx_time(paths["Tx"]) if "Tx" in paths else 0
+        rx = rx_time(paths["Rx"]) if "Rx" in paths else 0
+        line = f"device {dev}: TX {tx / 1e3:.1f} ms, RX {rx / 1e3:.1f} ms"
+        if args.length_s:
+            line += f", duty {100.0 * (tx + rx) / (args.length_s * 1e6):.3f} %"
+        print(line)
+
+
+if __name__ == "__main__":
+    main()
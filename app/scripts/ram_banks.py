@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""Report which nRF52840 RAM sections are used, retained and powered down.
+
+Runs as a post-build step. Fails the build if the image does not fit into
+the retained region.
+"""
+
+import argparse
+import sys
+
+from elftools.elf.elffile import ELFFile
+
+SRAM_BASE = 0x20000000
+SMALL_SECTION = 4 * 1024
+LARGE_SECTION = 32 * 1024
+LARGE_BASE = 64 * 1024
+SRAM_TOTAL = 256 * 1024
+
+
+def sections():
+    """Yield (name, offset, size) for every RAM section."""
+    for n in range(LARGE_BASE // SMALL_SECTION):
+        yield f"RAM{n // 2}.S{n % 2}", n * SMALL_SECTION, SMALL_SECTION
+    for n in range((SRAM_TOTAL - LARGE_BASE) // LARGE_SECTION):
+        yield f"RAM8.S{n}", LARGE_BASE + n * LARGE_SECTION, LARGE_SECTION
+
+
+def image_ram_end(elf_path):
+    with open(elf_path, "rb") as f:
+        symtab = ELFFile(f).get_section_by_name(".symtab")
+        sym = symtab.get_symbol_by_name("_image_ram_end")
+        if not sym:
+            sys.exit("ram_banks: _image_ram_end not found in " + elf_path)
+        return sym[0]["st_value"] - SRAM_BASE
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--elf", required=True)
+    parser.add_argument("--retained-kb", type=int, required=True)
+    args = parser.parse_args()
+
+    used = image_ram_end(args.elf)
+    retained = args.retained_kb * 1024
+
+    print(f"RAM used {used} B, retained {retained // 1024} KB "
+          f"of {SRAM_TOTAL // 1024} KB")
+    for name, offset, size in sections():
+        if offset < used:
+            state = "used"
+        elif offset < retained:
+            state = "retained"
+        else:
+            state = "off"
+        print(f"  {name:8} 0x{SRAM_BASE + offset:08x} {size // 1024:3} KB "
+              f"{state}")
+
+    if used > retained:
+        sys.exit(f"ram_banks: image RAM ({used} B) exceeds retained region")
+
+
+if __name__ == "__main__":
+    main()
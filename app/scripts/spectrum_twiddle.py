@@ -0,0 +1,34 @@
+#!/usr/bin/env python3
+"""Generate the twiddle table of the portable FFT in dsp/spectrum.c.
+
+cos and sin of 2 pi k / N for k below 3 N / 4, N the largest transform,
+in Q31 and interleaved. That covers the radix-4 stages of every complex
+transform up to N / 2 points and the real-to-complex split of N points.
+The output is committed, rerun when SPECTRUM_MAX_N changes:
+
+    scripts/spectrum_twiddle.py 4096 > src/dsp/spectrum_twiddle.inc
+"""
+
+import argparse
+import math
+
+Q31_MAX = (1 << 31) - 1
+
+
+def q31(v):
+    return max(-Q31_MAX - 1, min(Q31_MAX, round(v * (1 << 31))))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("n", type=int, help="largest real transform")
+    args = parser.parse_args()
+
+    print(f"/* Generated by scripts/spectrum_twiddle.py {args.n}, do not edit */")
+    for k in range(3 * args.n // 4):
+        a = 2.0 * math.pi * k / args.n
+        print(f"{q31(math.cos(a))}, {q31(math.sin(a))},")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,166 @@
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/hwinfo.h>
+#include <zephyr/init.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/logging/log.h>
+
+#include "acq.h"
+#include "block_pool.h"
+#include "boot_time.h"
+#include "dsp/ecg_synth.h"
+#include "dsp/soa.h"
+#include "ppg.h"
+#include "timebase.h"
+
+LOG_MODULE_REGISTER(acq, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define ACQ_STACK_SIZE 1024
+#define ACQ_PRIORITY   K_PRIO_COOP(4)
+
+static K_FIFO_DEFINE(acq_fifo);
+static K_TIMER_DEFINE(acq_timer, NULL, NULL);
+static K_THREAD_STACK_DEFINE(acq_stack, ACQ_STACK_SIZE);
+static struct k_thread acq_thread_data;
+
+/*
+ * Gains (Q8) deriving the leads from the synthetic lead II, in the order
+ * II, I, III, aVR, aVL, aVF, V1 .. V6. Lead 0 is the primary lead.
+ */
+static const int16_t lead_gain_q8[] = {
+    256, 154, 102, -205, 26, 179, -77, 128, 230, 307, 282, 205,
+};
+
+BUILD_ASSERT(PIPELINE_LEADS <= ARRAY_SIZE(lead_gain_q8));
+
+static struct ecg_synth synth;
+static uint64_t last_r_peak = UINT64_MAX;
+static uint32_t dropped;
+static uint32_t max_late_us;
+
+/* What a front end DMA leaves behind: one interleaved frame per sample */
+static uint8_t afe_buf[PIPELINE_BLOCK_SAMPLES * PIPELINE_LEADS * 3];
+
+static void afe_fill(void)
+{
+    int32_t base[PIPELINE_BLOCK_SAMPLES];
+    uint8_t *p = afe_buf;
+
+    ecg_synth_fill(&synth, base, ARRAY_SIZE(base));
+    for (size_t i = 0; i < ARRAY_SIZE(base); i++) {
+        for (size_t l = 0; l < PIPELINE_LEADS; l++, p += 3) {
+            uint32_t v = (uint32_t)((base[i] * lead_gain_q8[l]) >> 8);
+
+            p[0] = (uint8_t)(v >> 16);
+            p[1] = (uint8_t)(v >> 8);
+            p[2] = (uint8_t)v;
+        }
+    }
+}
+
+/* The emulated heart drives the emulated PPG sensor as well */
+static void heartbeat(int64_t t0)
+{
+    uint64_t r = ecg_synth_r_peak(&synth);
+
+    if (r < synth.n && r != last_r_peak) {
+        last_r_peak = r;
+        ppg_emul_heartbeat(t0 + (int64_t)r * ACQ_SAMPLE_PERIOD_US);
+    }
+}
+
+static void acq_block(int64_t t0, uint32_t seq)
+{
+    struct sample_block *block;
+    int64_t late_us;
+
+    /* Keep the emulated front end in step with time, even when dropping */
+    afe_fill();
+    if (IS_ENABLED(CONFIG_APP_PPG)) {
+        heartbeat(t0);
+    }
+
+    block = block_pool_alloc(BLOCK_POOL_SAMPLES, K_NO_WAIT);
+    if (block == NULL) {
+        LOG_WRN("sample pool exhausted, block %u dropped", seq);
+        dropped++;
+        return;
+    }
+
+    block->seq = seq;
+    block->timestamp_us = t0 + (int64_t)seq * ACQ_BLOCK_PERIOD_US;
+    block->count = PIPELINE_BLOCK_SAMPLES;
+    /* DMA completion: widen and transpose into per-lead rows in one pass */
+    soa_unpack_s24be(afe_buf, block->count, PIPELINE_LEADS,
+                     &block->samples[0][0], SAMPLE_STRIDE);
+
+    late_us = timebase_now_us() - (block->timestamp_us + ACQ_BLOCK_PERIOD_US);
+    max_late_us = MAX(max_late_us, (uint32_t)CLAMP(late_us, 0, UINT32_MAX));
+
+    k_fifo_put(&acq_fifo, block);
+    /* First-call-wins: only the first block handed off is recorded */
+    boot_time_mark(BOOT_MARK_FIRST_SAMPLE);
+}
+
+static void acq_thread(void *p1, void *p2, void *p3)
+{
+    int64_t t0 = timebase_now_us();
+    uint32_t seq = 0;
+
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    k_timer_start(&acq_timer, K_USEC(ACQ_BLOCK_PERIOD_US),
+                  K_USEC(ACQ_BLOCK_PERIOD_US));
+
+    while (1) {
+        /* Catch up on every period that expired, e.g. while flash stalled */
+        uint32_t periods = k_timer_status_sync(&acq_timer);
+
+        for (uint32_t i = 0; i < periods; i++, seq++) {
+            acq_block(t0, seq);
+        }
+    }
+}
+
+struct sample_block *acq_get(k_timeout_t timeout)
+{
+    return k_fifo_get(&acq_fifo, timeout);
+}
+
+uint32_t acq_dropped(void)
+{
+    return dropped;
+}
+
+uint32_t acq_max_late_us(void)
+{
+    return max_late_us;
+}
+
+/*
+ * Acquisition is the only boot-critical subsystem, it starts before main()
+ * while Bluetooth and storage initialize asynchronously afterwards.
+ */
+static int acq_init(void)
+{
+    uint8_t id[16];
+    uint32_t seed = 1;
+    ssize_t len;
+
+    /* Distinct straps (and simulated devices) produce distinct ECG */
+    len = IS_ENABLED(CONFIG_HWINFO) ? hwinfo_get_device_id(id, sizeof(id))
+                                    : -ENOSYS;
+    if (len > 0) {
+        seed = crc32_ieee(id, len);
+    }
+    ecg_synth_init(&synth, PIPELINE_SAMPLE_RATE_HZ, 72, seed);
+
+    k_thread_create(&acq_thread_data, acq_stack,
+                    K_THREAD_STACK_SIZEOF(acq_stack), acq_thread, NULL, NULL,
+                    NULL, ACQ_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&acq_thread_data, "acq");
+    return 0;
+}
+
+SYS_INIT(acq_init, APPLICATION, 0);
@@ -0,0 +1,201 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+
+#include "app_settings.h"
+#include "pipeline.h"
+#include "timebase.h"
+
+LOG_MODULE_REGISTER(app_settings, CONFIG_LOG_DEFAULT_LEVEL);
+
+struct subtree {
+    const char *name;
+    const char *key;
+    void *val;
+    size_t len;
+    bool loaded;
+    bool dirty;
+};
+
+static struct cal_settings cal = {
+    .gain_q16 = 1 << 16,
+    .offset_uv = 0,
+};
+
+static struct filter_settings filter = {
+    .baseline_cutoff_chz = PIPELINE_BASELINE_CUTOFF_CHZ,
+};
+
+static struct subtree subtrees[APP_SETTINGS_COUNT] = {
+    [APP_SETTINGS_CAL] = {"cal", "app/cal", &cal, sizeof(cal)},
+    [APP_SETTINGS_FILTER] = {"filter", "app/filter", &filter, sizeof(filter)},
+};
+
+static K_MUTEX_DEFINE(lock);
+static struct app_settings_stats stats;
+static bool storage_ready;
+
+static void flush_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(flush_work, flush_handler);
+
+static int app_set(const char *key, size_t len, settings_read_cb read_cb,
+                   void *cb_arg)
+{
+    for (int i = 0; i < APP_SETTINGS_COUNT; i++) {
+        struct subtree *st = &subtrees[i];
+        const char *next;
+        ssize_t rc;
+
+        if (!settings_name_steq(key, st->name, &next) || next != NULL) {
+            continue;
+        }
+        /* Never let a reload overwrite values already in use */
+        if (st->loaded || len != st->len) {
+            return 0;
+        }
+        rc = read_cb(cb_arg, st->val, st->len);
+        return rc < 0 ? (int)rc : 0;
+    }
+    return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(app, "app", NULL, app_set, NULL, NULL);
+
+static int storage_init(void)
+{
+    int ret;
+
+    if (storage_ready) {
+        return 0;
+    }
+
+    ret = settings_subsys_init();
+    if (ret < 0) {
+        LOG_ERR("settings init: %d", ret);
+        return ret;
+    }
+    storage_ready = true;
+    return 0;
+}
+
+static int subtree_load(struct subtree *st)
+{
+    int64_t start;
+    int ret;
+
+    if (st->loaded) {
+        return 0;
+    }
+
+    start = timebase_now_us();
+    ret = storage_init();
+    if (ret == 0) {
+        ret = settings_load_subtree(st->key);
+    }
+    stats.load_us += (uint32_t)(timebase_now_us() - start);
+
+    /* Fall back to defaults rather than retrying on every access */
+    st->loaded = true;
+    return ret;
+}
+
+int app_settings_get(enum app_settings_id id, void *val, size_t len)
+{
+    struct subtree *st;
+    int ret;
+
+    if (id >= APP_SETTINGS_COUNT || len != subtrees[id].len) {
+        return -EINVAL;
+    }
+
+    st = &subtrees[id];
+    k_mutex_lock(&lock, K_FOREVER);
+    ret = subtree_load(st);
+    memcpy(val, st->val, len);
+    k_mutex_unlock(&lock);
+    return ret;
+}
+
+int app_settings_set(enum app_settings_id id, const void *val, size_t len)
+{
+    struct subtree *st;
+
+    if (id >= APP_SETTINGS_COUNT || len != subtrees[id].len) {
+        return -EINVAL;
+    }
+
+    st = &subtrees[id];
+    k_mutex_lock(&lock, K_FOREVER);
+    /* Load first so the stored value cannot overwrite this update later */
+    (void)subtree_load(st);
+    if (st->dirty || memcmp(st->val, val, len) == 0) {
+        stats.coalesced++;
+    }
+    if (memcmp(st->val, val, len) != 0) {
+        memcpy(st->val, val, len);
+        st->dirty = true;
+        k_work_schedule(&flush_work,
+                        K_SECONDS(CONFIG_APP_SETTINGS_FLUSH_DELAY_S));
+    }
+    k_mutex_unlock(&lock);
+    return 0;
+}
+
+int app_settings_flush(void)
+{
+    int ret = 0;
+
+    k_mutex_lock(&lock, K_FOREVER);
+    for (int i = 0; i < APP_SETTINGS_COUNT; i++) {
+        struct subtree *st = &subtrees[i];
+        int err;
+
+        if (!st->dirty) {
+            continue;
+        }
+        err = storage_init();
+        if (err == 0) {
+            err = settings_save_one(st->key, st->val, st->len);
+        }
+        if (err < 0) {
+            LOG_ERR("%s: save failed: %d", st->key, err);
+            ret = err;
+            continue;
+        }
+        st->dirty = false;
+        stats.writes++;
+    }
+    k_mutex_unlock(&lock);
+    return ret;
+}
+
+static void flush_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    if (app_settings_flush() < 0) {
+        k_work_schedule(&flush_work,
+                        K_SECONDS(CONFIG_APP_SETTINGS_FLUSH_DELAY_S));
+    }
+}
+
+void app_settings_stats_get(struct app_settings_stats *out)
+{
+    k_mutex_lock(&lock, K_FOREVER);
+    *out = stats;
+    k_mutex_unlock(&lock);
+}
+
+void app_settings_stats_log(void)
+{
+    struct app_settings_stats s;
+    int64_t uptime_s = k_uptime_get() / MSEC_PER_SEC;
+
+    app_settings_stats_get(&s);
+    LOG_INF("settings: %u writes (%lld/day), %u coalesced, load %u us",
+            s.writes,
+            (long long)(uptime_s > 0 ? s.writes * 86400LL / uptime_s : 0),
+            s.coalesced, s.load_us);
+}
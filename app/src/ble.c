@@ -0,0 +1,200 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+
+#ifdef CONFIG_APP_RECORDER_KEY_PASSKEY_UICR
+#include <soc.h>
+#endif
+
+#include "ble.h"
+#include "boot_time.h"
+#include "ecg_service.h"
+
+LOG_MODULE_REGISTER(ble, CONFIG_LOG_DEFAULT_LEVEL);
+
+/* Connection intervals in 1.25 ms units, supervision timeout in 10 ms */
+#define BLE_FAST_INTERVAL_MIN   6
+#define BLE_FAST_INTERVAL_MAX   12
+#define BLE_SLOW_INTERVAL_MIN   24
+#define BLE_SLOW_INTERVAL_MAX   40
+#define BLE_SUPERVISION_TIMEOUT 400
+
+/* The service UUID lets a gateway pick straps from passive scanning */
+static const struct bt_data ad[] = {
+    BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
+    BT_DATA_BYTES(BT_DATA_UUID128_ALL, BT_UUID_ECG_SERVICE_VAL),
+};
+
+static const struct bt_data sd[] = {
+    BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME,
+            sizeof(CONFIG_BT_DEVICE_NAME) - 1),
+};
+
+static void adv_start(struct k_work *work)
+{
+    int err;
+
+    ARG_UNUSED(work);
+
+    err = bt_le_adv_start(BT_LE_ADV_CONN_FAST_1, ad, ARRAY_SIZE(ad), sd,
+                          ARRAY_SIZE(sd));
+    if (err && err != -EALREADY) {
+        LOG_ERR("Advertising failed to start: %d", err);
+    }
+}
+
+static K_WORK_DEFINE(adv_work, adv_start);
+
+static struct bt_conn *current_conn;
+
+#ifdef CONFIG_APP_RECORDER_KEY_BLE
+/* A passkey shared by every image would let anyone claim the key slot */
+BUILD_ASSERT(IS_ENABLED(CONFIG_APP_RECORDER_KEY_PASSKEY_UICR) ||
+                 CONFIG_APP_RECORDER_KEY_PASSKEY != 0 ||
+                 IS_ENABLED(CONFIG_DEBUG_OPTIMIZATIONS) ||
+                 IS_ENABLED(CONFIG_ARCH_POSIX),
+             "passkey 000000 is for debug images, set "
+             "CONFIG_APP_RECORDER_KEY_PASSKEY or use the UICR passkey");
+
+/* The strap's own passkey from the factory data, else the image's */
+static int recorder_passkey(void)
+{
+#ifdef CONFIG_APP_RECORDER_KEY_PASSKEY_UICR
+    uint32_t word =
+        NRF_UICR->CUSTOMER[CONFIG_APP_RECORDER_KEY_PASSKEY_UICR_WORD];
+
+    /* An erased word reads 0xFFFFFFFF */
+    if (word <= 999999) {
+        return (int)word;
+    }
+    if (!IS_ENABLED(CONFIG_DEBUG_OPTIMIZATIONS)) {
+        return -ENOENT;
+    }
+#endif
+    return CONFIG_APP_RECORDER_KEY_PASSKEY;
+}
+
+/* Display only: the passkey is fixed and printed on the strap */
+static void passkey_display(struct bt_conn *conn, unsigned int passkey)
+{
+    ARG_UNUSED(conn);
+    ARG_UNUSED(passkey);
+
+    LOG_INF("Pairing with the fixed passkey");
+}
+
+static void auth_cancel(struct bt_conn *conn)
+{
+    ARG_UNUSED(conn);
+
+    LOG_WRN("Pairing cancelled");
+}
+
+static struct bt_conn_auth_cb auth_cb = {
+    .passkey_display = passkey_display,
+    .cancel = auth_cancel,
+};
+#endif
+
+static void link_upgrade(struct bt_conn *conn)
+{
+    int err;
+
+    if (IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE)) {
+        err = bt_conn_le_phy_update(conn, BT_CONN_LE_PHY_PARAM_2M);
+        if (err) {
+            LOG_WRN("PHY update: %d", err);
+        }
+    }
+    if (IS_ENABLED(CONFIG_BT_USER_DATA_LEN_UPDATE)) {
+        err = bt_conn_le_data_len_update(conn, BT_LE_DATA_LEN_PARAM_MAX);
+        if (err) {
+            LOG_WRN("Data length update: %d", err);
+        }
+    }
+}
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+    if (err) {
+        LOG_WRN("Connection failed: 0x%02x", err);
+        return;
+    }
+    LOG_INF("Connected");
+    current_conn = bt_conn_ref(conn);
+    link_upgrade(conn);
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    LOG_INF("Disconnected: 0x%02x", reason);
+    if (conn == current_conn) {
+        bt_conn_unref(current_conn);
+        current_conn = NULL;
+    }
+}
+
+static void recycled(void)
+{
+    k_work_submit(&adv_work);
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+    .recycled = recycled,
+};
+
+static void bt_ready(int err)
+{
+#ifdef CONFIG_APP_RECORDER_KEY_BLE
+    int passkey;
+#endif
+
+    if (err) {
+        LOG_ERR("Bluetooth init failed: %d", err);
+        return;
+    }
+
+    /* Identity and bonds, loaded only now that the stack is up */
+    if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
+        settings_load_subtree("bt");
+    }
+#ifdef CONFIG_APP_RECORDER_KEY_BLE
+    /*
+     * Without auth callbacks pairing is Just Works and never
+     * authenticated, so the recorder key characteristic stays closed.
+     */
+    passkey = recorder_passkey();
+    if (passkey < 0) {
+        LOG_ERR("No passkey in the UICR, recorder key not accepted");
+    } else {
+        bt_passkey_set((unsigned int)passkey);
+        bt_conn_auth_cb_register(&auth_cb);
+    }
+#endif
+
+    adv_start(NULL);
+    boot_time_mark(BOOT_MARK_BLE_READY);
+}
+
+int ble_init(void)
+{
+    return bt_enable(bt_ready);
+}
+
+int ble_conn_fast(bool fast)
+{
+    const struct bt_le_conn_param *param =
+        fast ? BT_LE_CONN_PARAM(BLE_FAST_INTERVAL_MIN, BLE_FAST_INTERVAL_MAX,
+                                0, BLE_SUPERVISION_TIMEOUT)
+             : BT_LE_CONN_PARAM(BLE_SLOW_INTERVAL_MIN, BLE_SLOW_INTERVAL_MAX,
+                                0, BLE_SUPERVISION_TIMEOUT);
+
+    if (current_conn == NULL) {
+        return -ENOTCONN;
+    }
+    return bt_conn_le_param_update(current_conn, param);
+}
@@ -0,0 +1,92 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+
+#include "block_pool.h"
+#include "blocks.h"
+
+LOG_MODULE_REGISTER(block_pool, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define POOL_ALIGN          8
+#define POOL_BLOCK_SIZE(t) ROUND_UP(sizeof(t), POOL_ALIGN)
+
+K_MEM_SLAB_DEFINE_STATIC(sample_slab,
+                         ROUND_UP(sizeof(struct sample_block), SAMPLE_ALIGN),
+                         CONFIG_APP_POOL_SAMPLE_BLOCKS, SAMPLE_ALIGN);
+K_MEM_SLAB_DEFINE_STATIC(packet_slab, POOL_BLOCK_SIZE(struct enc_packet),
+                         CONFIG_APP_POOL_PACKETS, POOL_ALIGN);
+K_MEM_SLAB_DEFINE_STATIC(event_slab, POOL_BLOCK_SIZE(struct event_record),
+                         CONFIG_APP_POOL_EVENTS, POOL_ALIGN);
+
+static struct k_mem_slab *const slabs[BLOCK_POOL_COUNT] = {
+    [BLOCK_POOL_SAMPLES] = &sample_slab,
+    [BLOCK_POOL_PACKETS] = &packet_slab,
+    [BLOCK_POOL_EVENTS] = &event_slab,
+};
+
+static const char *const names[BLOCK_POOL_COUNT] = {
+    [BLOCK_POOL_SAMPLES] = "samples",
+    [BLOCK_POOL_PACKETS] = "packets",
+    [BLOCK_POOL_EVENTS] = "events",
+};
+
+static atomic_t alloc_failures[BLOCK_POOL_COUNT];
+
+void *block_pool_alloc(enum block_pool_id id, k_timeout_t timeout)
+{
+    void *block;
+
+    __ASSERT_NO_MSG(id < BLOCK_POOL_COUNT);
+
+    if (k_mem_slab_alloc(slabs[id], &block, timeout) != 0) {
+        atomic_inc(&alloc_failures[id]);
+        return NULL;
+    }
+    return block;
+}
+
+void block_pool_free(enum block_pool_id id, void *block)
+{
+    __ASSERT_NO_MSG(id < BLOCK_POOL_COUNT);
+
+    if (block != NULL) {
+        k_mem_slab_free(slabs[id], block);
+    }
+}
+
+int block_pool_stats_get(enum block_pool_id id, struct block_pool_stats *stats)
+{
+    struct k_mem_slab *slab;
+
+    if (id >= BLOCK_POOL_COUNT || stats == NULL) {
+        return -EINVAL;
+    }
+
+    slab = slabs[id];
+    stats->block_size = slab->info.block_size;
+    stats->num_blocks = slab->info.num_blocks;
+    stats->num_used = k_mem_slab_num_used_get(slab);
+    stats->max_used = k_mem_slab_max_used_get(slab);
+    stats->alloc_failures = atomic_get(&alloc_failures[id]);
+    return 0;
+}
+
+void block_pool_stats_reset(void)
+{
+    for (int i = 0; i < BLOCK_POOL_COUNT; i++) {
+        k_mem_slab_runtime_stats_reset_max(slabs[i]);
+        atomic_clear(&alloc_failures[i]);
+    }
+}
+
+void block_pool_stats_log(void)
+{
+    struct block_pool_stats stats;
+
+    for (int i = 0; i < BLOCK_POOL_COUNT; i++) {
+        block_pool_stats_get(i, &stats);
+        LOG_INF("pool %s: %u/%u used, max %u, %u B blocks, %u failed",
+                names[i], stats.num_used, stats.num_blocks, stats.max_used,
+                stats.block_size, stats.alloc_failures);
+    }
+}
@@ -0,0 +1,62 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+
+#include "boot_time.h"
+#include "timebase.h"
+
+LOG_MODULE_REGISTER(boot_time, CONFIG_LOG_DEFAULT_LEVEL);
+
+static const char *const names[BOOT_MARK_COUNT] = {
+    [BOOT_MARK_MAIN] = "main",
+    [BOOT_MARK_FIRST_SAMPLE] = "first sample",
+    [BOOT_MARK_BLE_READY] = "BLE ready",
+    [BOOT_MARK_SETTINGS] = "settings",
+    [BOOT_MARK_STORAGE] = "storage",
+};
+
+static int64_t marks[BOOT_MARK_COUNT];
+static atomic_t claimed;
+static atomic_t reached;
+
+void boot_time_mark_at(enum boot_mark mark, int64_t t_us)
+{
+    __ASSERT_NO_MSG(mark < BOOT_MARK_COUNT);
+
+    if (atomic_test_and_set_bit(&claimed, mark)) {
+        return;
+    }
+    marks[mark] = t_us;
+    atomic_set_bit(&reached, mark);
+
+    if (mark == BOOT_MARK_FIRST_SAMPLE) {
+        /* Debug images stop here, before the line the twister test expects */
+        __ASSERT(t_us <= CONFIG_APP_BOOT_FIRST_SAMPLE_MAX_MS * USEC_PER_MSEC,
+                 "boot: first sample after %lld us exceeds %d ms",
+                 (long long)t_us, CONFIG_APP_BOOT_FIRST_SAMPLE_MAX_MS);
+        if (t_us > CONFIG_APP_BOOT_FIRST_SAMPLE_MAX_MS * USEC_PER_MSEC) {
+            LOG_ERR("boot: first sample after %lld us exceeds %d ms",
+                    (long long)t_us, CONFIG_APP_BOOT_FIRST_SAMPLE_MAX_MS);
+        }
+    }
+    LOG_INF("boot: %s at %lld us", names[mark], (long long)t_us);
+    if (mark == BOOT_MARK_BLE_READY && boot_time_get_us(BOOT_MARK_MAIN) >= 0) {
+        LOG_INF("boot: main to BLE ready %lld us",
+                (long long)(t_us - marks[BOOT_MARK_MAIN]));
+    }
+}
+
+void boot_time_mark(enum boot_mark mark)
+{
+    boot_time_mark_at(mark, timebase_now_us());
+}
+
+int64_t boot_time_get_us(enum boot_mark mark)
+{
+    __ASSERT_NO_MSG(mark < BOOT_MARK_COUNT);
+
+    if (!atomic_test_bit(&reached, mark)) {
+        return -1;
+    }
+    return marks[mark];
+}
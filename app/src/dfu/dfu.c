@@ -0,0 +1,95 @@
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/mgmt/mcumgr/grp/img_mgmt/img_mgmt.h>
+#include <zephyr/mgmt/mcumgr/mgmt/callbacks.h>
+
+#include "ble.h"
+#include "flash_writer.h"
+#include "timebase.h"
+
+LOG_MODULE_REGISTER(dfu, CONFIG_LOG_DEFAULT_LEVEL);
+
+/* Two sealed pages, each programmed and the next one erased */
+#define RESET_FLUSH_TIMEOUT K_MSEC(500)
+
+static int64_t upload_start_us;
+static size_t upload_size;
+static size_t upload_received;
+
+static enum mgmt_cb_return dfu_event(uint32_t event,
+                                     enum mgmt_cb_return prev_status,
+                                     int32_t *rc, uint16_t *group,
+                                     bool *abort_more, void *data,
+                                     size_t data_size)
+{
+    const struct img_mgmt_upload_check *check = data;
+    int64_t elapsed_us;
+
+    switch (event) {
+    case MGMT_EVT_OP_IMG_MGMT_DFU_STARTED:
+        upload_start_us = timebase_now_us();
+        upload_received = 0;
+        ble_conn_fast(true);
+        LOG_INF("DFU started");
+        break;
+    case MGMT_EVT_OP_IMG_MGMT_UPLOAD:
+        if (check->req->off == 0) {
+            upload_size = check->req->size;
+        }
+        upload_received = check->req->off + check->req->img_data.len;
+        break;
+    case MGMT_EVT_OP_IMG_MGMT_DFU_PENDING:
+        elapsed_us = MAX(timebase_now_us() - upload_start_us, 1);
+        LOG_INF("DFU upload of %zu B in %lld ms, %u B/s", upload_received,
+                (long long)(elapsed_us / USEC_PER_MSEC),
+                (uint32_t)((uint64_t)upload_received * USEC_PER_SEC / elapsed_us));
+        ble_conn_fast(false);
+        break;
+    case MGMT_EVT_OP_IMG_MGMT_DFU_STOPPED:
+        LOG_WRN("DFU stopped at %zu of %zu B", upload_received, upload_size);
+        ble_conn_fast(false);
+        break;
+#ifdef CONFIG_APP_RECORDER
+    case MGMT_EVT_OP_OS_MGMT_RESET:
+        /*
+         * The reset that installs an update, or any other: keep the ECG
+         * still in RAM. The reset goes ahead even if the flush times out.
+         */
+        if (flash_writer_flush(RESET_FLUSH_TIMEOUT) < 0) {
+            LOG_WRN("reset: recorder pages not flushed");
+        }
+        break;
+#endif
+    default:
+        break;
+    }
+    return MGMT_CB_OK;
+}
+
+static struct mgmt_callback dfu_callback = {
+    .callback = dfu_event,
+    .event_id = MGMT_EVT_OP_IMG_MGMT_DFU_STARTED |
+                MGMT_EVT_OP_IMG_MGMT_UPLOAD |
+                MGMT_EVT_OP_IMG_MGMT_DFU_PENDING |
+                MGMT_EVT_OP_IMG_MGMT_DFU_STOPPED,
+};
+
+#ifdef CONFIG_APP_RECORDER
+/* Separate group: OS events cannot be or-ed with image events */
+static struct mgmt_callback reset_callback = {
+    .callback = dfu_event,
+    .event_id = MGMT_EVT_OP_OS_MGMT_RESET,
+};
+#endif
+
+static int dfu_init(void)
+{
+    mgmt_callback_register(&dfu_callback);
+#ifdef CONFIG_APP_RECORDER
+    mgmt_callback_register(&reset_callback);
+#endif
+    return 0;
+}
+
+SYS_INIT(dfu_init, APPLICATION, 0);
@@ -0,0 +1,92 @@
+#include <math.h>
+#include <string.h>
+
+#include "dsp/biquad.h"
+
+#define PI       3.14159265358979323846
+#define SQRT1_2  0.70710678118654752440
+#define Q(v)     ((int32_t)lround((v) * (double)(1 << BIQUAD_COEFF_SHIFT)))
+
+static void biquad_design(struct biquad_coeffs *c, uint32_t fs_hz,
+                          double fc_hz, int highpass)
+{
+    const double w0 = 2.0 * PI * fc_hz / (double)fs_hz;
+    /* Butterworth: Q = 1/sqrt(2), alpha = sin(w0) / (2 * Q) */
+    const double alpha = sin(w0) * SQRT1_2;
+    const double cosw = cos(w0);
+    const double a0 = 1.0 + alpha;
+    const double k = highpass ? (1.0 + cosw) / 2.0 : (1.0 - cosw) / 2.0;
+
+    c->b0 = Q(k / a0);
+    /* Keep the high-pass zero at DC exact after quantization */
+    c->b1 = highpass ? -2 * c->b0 : Q(2.0 * k / a0);
+    c->b2 = c->b0;
+    c->a1 = Q(-2.0 * cosw / a0);
+    c->a2 = Q((1.0 - alpha) / a0);
+}
+
+void biquad_highpass(struct biquad_coeffs *c, uint32_t fs_hz, double fc_hz)
+{
+    biquad_design(c, fs_hz, fc_hz, 1);
+}
+
+void biquad_lowpass(struct biquad_coeffs *c, uint32_t fs_hz, double fc_hz)
+{
+    biquad_design(c, fs_hz, fc_hz, 0);
+}
+
+void biquad_notch(struct biquad_coeffs *c, uint32_t fs_hz, double f0_hz,
+                  double bw_hz)
+{
+    const double w0 = 2.0 * PI * f0_hz / (double)fs_hz;
+    /* alpha = sin(w0) / (2 * Q) with Q = f0 / bw */
+    const double alpha = sin(w0) * bw_hz / (2.0 * f0_hz);
+    const double a0 = 1.0 + alpha;
+
+    c->b0 = Q(1.0 / a0);
+    c->b1 = Q(-2.0 * cos(w0) / a0);
+    c->b2 = c->b0;
+    c->a1 = c->b1;
+    c->a2 = Q((1.0 - alpha) / a0);
+}
+
+void biquad_init(struct biquad *f, const struct biquad_coeffs *c)
+{
+    memset(f, 0, sizeof(*f));
+    f->c = *c;
+}
+
+void biquad_process(struct biquad *f, int32_t *x, size_t n)
+{
+    const struct biquad_coeffs c = f->c;
+    int32_t x1 = f->x1, x2 = f->x2;
+    int32_t y1 = f->y1, y2 = f->y2;
+    int64_t err = f->err;
+
+    for (size_t i = 0; i < n; i++) {
+        int64_t acc = err + (int64_t)c.b0 * x[i] + (int64_t)c.b1 * x1 +
+                      (int64_t)c.b2 * x2 - (int64_t)c.a1 * y1 -
+                      (int64_t)c.a2 * y2;
+        int32_t y = (int32_t)(acc >> BIQUAD_COEFF_SHIFT);
+
+        /*
+         * Carry the truncated fraction into the next sample. Without it
+         * the rounding error is amplified by 1 / (1 + a1 + a2), which at
+         * low cutoffs (0.05 Hz at 250 Hz: ~600000) shifts the output by
+         * millivolts.
+         */
+        err = acc - ((int64_t)y << BIQUAD_COEFF_SHIFT);
+
+        x2 = x1;
+        x1 = x[i];
+        y2 = y1;
+        y1 = y;
+        x[i] = y;
+    }
+
+    f->x1 = x1;
+    f->x2 = x2;
+    f->y1 = y1;
+    f->y2 = y2;
+    f->err = (int32_t)err;
+}
@@ -0,0 +1,354 @@
+#include <string.h>
+
+#include "dsp/delin.h"
+
+#define MS_PER_SAMPLE (1000 / DELIN_FS_HZ)
+#define MS(n)         ((n) / MS_PER_SAMPLE)
+
+/* R peak position within the window */
+#define R_POS (DELIN_LEAD + DELIN_PRE)
+
+/* Delay of the detail scales 2^2 and 2^4, 2^j - 1.5 samples rounded up */
+#define D2 3
+#define D4 15
+
+/* QRS modulus maxima lie within this distance of the R peak */
+#define QRS_SEARCH MS(100)
+
+static uint32_t isqrt32(uint32_t v)
+{
+    uint32_t r = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return r;
+}
+
+static int32_t iabs(int32_t v)
+{
+    return v < 0 ? -v : v;
+}
+
+int delin_init(struct delin *d, uint32_t fs_hz)
+{
+    memset(d, 0, sizeof(*d));
+    if (fs_hz == 0 || fs_hz % DELIN_FS_HZ != 0) {
+        return -1;
+    }
+    d->dec = fs_hz / DELIN_FS_HZ;
+    return 0;
+}
+
+void delin_add_beat(struct delin *d, uint64_t r, uint16_t rr_ms)
+{
+    uint64_t rd = r / d->dec;
+
+    /* Too close to the start, or the window already left the ring */
+    if (rd < R_POS || d->count == DELIN_PENDING ||
+        d->n >= rd - R_POS + DELIN_RING) {
+        d->late++;
+        return;
+    }
+    d->pending[(d->head + d->count) % DELIN_PENDING].r = r;
+    d->pending[(d->head + d->count) % DELIN_PENDING].rr_ms = rr_ms;
+    d->count++;
+}
+
+/*
+ * Quadratic spline wavelet, undecimated: low-pass [1 3 3 1] / 8 and
+ * high-pass [2 -2] with the taps spread 2^(j-1) apart at scale 2^j. Each
+ * level only looks back, so walking the window backwards lets the
+ * approximation be updated in place.
+ */
+static void wavelet(struct delin *d)
+{
+    int32_t *a = d->a;
+
+    for (int j = 1; j <= 4; j++) {
+        int s = 1 << (j - 1);
+        int32_t *w = j == 2 ? d->w2 : j == 4 ? d->w4 : NULL;
+
+        for (int i = DELIN_WIN - 1; i >= 0; i--) {
+            int32_t a1 = a[i >= s ? i - s : 0];
+            int32_t a2 = a[i >= 2 * s ? i - 2 * s : 0];
+            int32_t a3 = a[i >= 3 * s ? i - 3 * s : 0];
+
+            if (w != NULL) {
+                w[i] = 2 * (a[i] - a1);
+            }
+            a[i] = (a[i] + 3 * a1 + 3 * a2 + a3 + 4) >> 3;
+        }
+    }
+}
+
+/* Detail coefficient at window position t, delay compensated */
+static int32_t w_at(const int32_t *w, int delay, int t)
+{
+    return w[t + delay];
+}
+
+/* Largest |w| over [lo, hi] */
+static int32_t w_max_abs(const int32_t *w, int delay, int lo, int hi)
+{
+    int32_t m = 0;
+
+    for (int t = lo; t <= hi; t++) {
+        int32_t v = iabs(w_at(w, delay, t));
+
+        m = v > m ? v : m;
+    }
+    return m;
+}
+
+/* Local maximum of |w| at t above @p thr */
+static int is_modulus_max(const int32_t *w, int delay, int t, int32_t thr)
+{
+    int32_t v = iabs(w_at(w, delay, t));
+
+    return v > thr && v >= iabs(w_at(w, delay, t - 1)) &&
+           v >= iabs(w_at(w, delay, t + 1));
+}
+
+/*
+ * Walk from the modulus maximum at @p t in direction @p step until |w|
+ * drops below pk * num / den or reaches a local minimum, at most to
+ * @p limit.
+ */
+static int walk(const int32_t *w, int delay, int t, int step, int limit,
+                int32_t num, int32_t den)
+{
+    int32_t thr = iabs(w_at(w, delay, t)) * num;
+
+    while (t != limit) {
+        int32_t v = iabs(w_at(w, delay, t));
+
+        if (v * den < thr || iabs(w_at(w, delay, t + step)) > v) {
+            break;
+        }
+        t += step;
+    }
+    return t;
+}
+
+/*
+ * A wave at scale 2^4 within [lo, hi]: the modulus maxima of opposite sign
+ * around its peak. Returns 0 if the wave is not above @p thr.
+ */
+static int wave(const int32_t *w, int lo, int hi, int32_t thr, int *first,
+                int *peak, int *second)
+{
+    int imax = lo, imin = lo;
+
+    if (hi <= lo) {
+        return 0;
+    }
+    for (int t = lo; t <= hi; t++) {
+        int32_t v = w_at(w, D4, t);
+
+        if (v > w_at(w, D4, imax)) {
+            imax = t;
+        }
+        if (v < w_at(w, D4, imin)) {
+            imin = t;
+        }
+    }
+    if (w_at(w, D4, imax) <= thr || -w_at(w, D4, imin) <= thr) {
+        return 0;
+    }
+
+    *first = imax < imin ? imax : imin;
+    *second = imax < imin ? imin : imax;
+    /* The peak is the zero crossing between the two slopes */
+    *peak = *first;
+    while (*peak < *second &&
+           (w_at(w, D4, *peak) > 0) == (w_at(w, D4, *first) > 0)) {
+        (*peak)++;
+    }
+    return 1;
+}
+
+static int32_t x_mean(const struct delin *d, uint64_t w0, int lo, int hi)
+{
+    int32_t sum = 0;
+
+    for (int t = lo; t <= hi; t++) {
+        sum += d->ring[(w0 + (uint64_t)t) % DELIN_RING];
+    }
+    return sum / (hi - lo + 1);
+}
+
+static int16_t rel_ms(int t)
+{
+    return (int16_t)((t - R_POS) * MS_PER_SAMPLE);
+}
+
+static void delineate(struct delin *d, uint64_t r, uint16_t rr_ms,
+                      struct delin_beat *b)
+{
+    const uint64_t w0 = r / d->dec - R_POS;
+    const int rr = rr_ms > 0 ? MS(rr_ms) : MS(1000);
+    int32_t m2, m4, thr;
+    int on, off, first, last, t;
+    int p1, p2, pk;
+
+    memset(b, 0, sizeof(*b));
+    b->r = r;
+    b->rr_ms = rr_ms;
+
+    for (int i = 0; i < DELIN_WIN; i++) {
+        d->a[i] = d->ring[(w0 + (uint64_t)i) % DELIN_RING];
+    }
+    wavelet(d);
+
+    /* QRS: the outermost significant modulus maxima at scale 2^2 */
+    m2 = w_max_abs(d->w2, D2, R_POS - QRS_SEARCH, R_POS + QRS_SEARCH);
+    first = R_POS;
+    for (t = R_POS - QRS_SEARCH + 1; t < R_POS; t++) {
+        if (is_modulus_max(d->w2, D2, t, m2 * 6 / 100)) {
+            first = t;
+            break;
+        }
+    }
+    last = R_POS;
+    for (t = R_POS + QRS_SEARCH - 1; t > R_POS; t--) {
+        if (is_modulus_max(d->w2, D2, t, m2 * 9 / 100)) {
+            last = t;
+            break;
+        }
+    }
+    on = walk(d->w2, D2, first, -1, R_POS - QRS_SEARCH, 5, 100);
+    off = walk(d->w2, D2, last, 1, R_POS + QRS_SEARCH, 125, 1000);
+    b->qrs_on = rel_ms(on);
+    b->qrs_off = rel_ms(off);
+
+    /* P and T waves must stand out against the QRS at scale 2^4 */
+    m4 = w_max_abs(d->w4, D4, on, off);
+    thr = m4 >> 5;
+
+    /* T: after the QRS, within 70% of the RR interval */
+    t = R_POS + (rr * 7 / 10 < DELIN_POST ? rr * 7 / 10 : DELIN_POST);
+    if (wave(d->w4, off + MS(40) > R_POS + MS(100) ? off + MS(40)
+                                                   : R_POS + MS(100),
+             t, thr, &p1, &pk, &p2)) {
+        int end = walk(d->w4, D4, p2, 1, R_POS + DELIN_POST, 4, 10);
+
+        b->flags |= DELIN_T_WAVE;
+        b->t_peak = rel_ms(pk);
+        b->t_end = rel_ms(end);
+        b->qt_ms = (uint16_t)((end - on) * MS_PER_SAMPLE);
+        if (rr_ms > 0) {
+            b->qtc_ms = (uint16_t)(b->qt_ms * isqrt32(1000000000u / rr_ms) /
+                                   1000);
+        }
+    }
+
+    /* P: before the QRS, not reaching back into the previous T wave */
+    t = R_POS - (rr * 45 / 100 < DELIN_PRE ? rr * 45 / 100 : DELIN_PRE);
+    if (wave(d->w4, t, on - MS(40), thr, &p1, &pk, &p2)) {
+        b->flags |= DELIN_P_WAVE;
+        b->p_on = rel_ms(walk(d->w4, D4, p1, -1, t, 5, 10));
+        b->p_peak = rel_ms(pk);
+        b->p_end = rel_ms(walk(d->w4, D4, p2, 1, on, 9, 10));
+    }
+
+    /* ST against the PR segment just before the QRS onset */
+    t = off + (rr_ms > 0 && rr_ms < 600 ? MS(40) : MS(60));
+    b->st_uv = (int16_t)(x_mean(d, w0, t - 1, t + 1) -
+                         x_mean(d, w0, on - MS(20), on - 1));
+}
+
+static void account(struct delin *d, const struct delin_beat *b)
+{
+    d->beats++;
+    d->qrs_sum += b->qrs_off - b->qrs_on;
+    d->st_sum += b->st_uv;
+    if (b->flags & DELIN_P_WAVE) {
+        d->p_waves++;
+        d->pr_sum += b->qrs_on - b->p_on;
+    }
+    if (b->flags & DELIN_T_WAVE) {
+        d->t_waves++;
+        d->qt_sum += b->qt_ms;
+        if (b->qtc_ms > 0) {
+            d->qt_beats++;
+            d->qtc_sum += b->qtc_ms;
+        }
+    }
+}
+
+size_t delin_push(struct delin *d, const int32_t *x, size_t n,
+                  struct delin_beat *out, size_t max)
+{
+    size_t found = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        d->acc += x[i];
+        if (++d->acc_n < d->dec) {
+            continue;
+        }
+        d->ring[d->n % DELIN_RING] = d->acc / (int32_t)d->dec;
+        d->n++;
+        d->acc = 0;
+        d->acc_n = 0;
+
+        while (d->count > 0) {
+            uint64_t r = d->pending[d->head].r;
+            struct delin_beat b;
+
+            if (d->n < r / d->dec - R_POS + DELIN_WIN) {
+                break;
+            }
+            delineate(d, r, d->pending[d->head].rr_ms, &b);
+            account(d, &b);
+            if (found < max) {
+                out[found] = b;
+            }
+            found++;
+            d->head = (d->head + 1) % DELIN_PENDING;
+            d->count--;
+        }
+    }
+    return found;
+}
+
+static int16_t mean(int64_t sum, uint32_t n)
+{
+    return n > 0 ? (int16_t)(sum / (int64_t)n) : 0;
+}
+
+void delin_stats_get(struct delin *d, struct delin_stats *st, int reset)
+{
+    st->beats = d->beats;
+    st->late = d->late;
+    st->p_waves = d->p_waves;
+    st->t_waves = d->t_waves;
+    st->qrs_ms = (uint16_t)mean(d->qrs_sum, d->beats);
+    st->pr_ms = (uint16_t)mean(d->pr_sum, d->p_waves);
+    st->qt_ms = (uint16_t)mean(d->qt_sum, d->t_waves);
+    st->qtc_ms = (uint16_t)mean(d->qtc_sum, d->qt_beats);
+    st->st_uv = mean(d->st_sum, d->beats);
+
+    if (reset) {
+        d->late = 0;
+        d->beats = 0;
+        d->p_waves = 0;
+        d->t_waves = 0;
+        d->qt_beats = 0;
+        d->qrs_sum = 0;
+        d->pr_sum = 0;
+        d->qt_sum = 0;
+        d->qtc_sum = 0;
+        d->st_sum = 0;
+    }
+}
@@ -0,0 +1,95 @@
+#include <string.h>
+
+#include "dsp/ecg_analysis.h"
+
+/*
+ * Detections are at least a refractory period (fs / 5) apart, chunks of
+ * CHUNK_BEATS periods cannot overflow a buffer twice that size.
+ */
+#define CHUNK_BEATS 8
+#define BEATS_MAX   (2 * CHUNK_BEATS)
+
+void ecg_analysis_init(struct ecg_analysis *a, uint32_t fs_hz,
+                       uint16_t baseline_cutoff_chz)
+{
+    struct biquad_coeffs c;
+
+    memset(a, 0, sizeof(*a));
+    a->fs_hz = fs_hz;
+    biquad_highpass(&c, fs_hz, baseline_cutoff_chz / 100.0);
+    biquad_init(&a->baseline, &c);
+    qrs_init(&a->qrs, fs_hz);
+    hrv_init(&a->hrv);
+    a->delin_on = delin_init(&a->delin, fs_hz) == 0;
+}
+
+int ecg_analysis_use_median(struct ecg_analysis *a, uint32_t *storage,
+                            size_t words)
+{
+    if (median_baseline_init(&a->median, a->fs_hz, storage, words) != 0) {
+        return -1;
+    }
+    a->median_on = 1;
+    a->delay = (uint32_t)MEDIAN_BASELINE_DELAY(a->fs_hz);
+    return 0;
+}
+
+void ecg_analysis_set_baseline(struct ecg_analysis *a,
+                               uint16_t baseline_cutoff_chz)
+{
+    biquad_highpass(&a->baseline.c, a->fs_hz, baseline_cutoff_chz / 100.0);
+}
+
+size_t ecg_analysis_process(struct ecg_analysis *a, int32_t *x, size_t n,
+                            uint64_t *beats, size_t max_beats)
+{
+    uint64_t found[BEATS_MAX];
+    size_t count = 0;
+
+    if (a->median_on) {
+        median_baseline_process(&a->median, x, n);
+    } else {
+        biquad_process(&a->baseline, x, n);
+    }
+    a->delineated_count = 0;
+
+    while (n > 0) {
+        size_t chunk = n < a->fs_hz / 5 * CHUNK_BEATS
+                           ? n
+                           : a->fs_hz / 5 * CHUNK_BEATS;
+        size_t k = qrs_process(&a->qrs, x, chunk, found, BEATS_MAX);
+
+        for (size_t i = 0; i < k; i++) {
+            uint32_t rr_ms = 0;
+
+            if (a->beats > 0) {
+                rr_ms = (uint32_t)((found[i] - a->last_beat) * 1000 / a->fs_hz);
+                hrv_add_rr(&a->hrv, rr_ms);
+            }
+            if (a->delin_on) {
+                delin_add_beat(&a->delin, found[i],
+                               rr_ms <= HRV_RR_MAX_MS ? (uint16_t)rr_ms : 0);
+            }
+            a->last_beat = found[i];
+            a->beats++;
+            if (beats != NULL && count < max_beats) {
+                beats[count] = found[i] - a->delay;
+            }
+            count++;
+        }
+        if (a->delin_on) {
+            size_t room = ECG_ANALYSIS_DELIN_MAX - a->delineated_count;
+            size_t m = delin_push(&a->delin, x, chunk,
+                                  a->delineated + a->delineated_count, room);
+
+            m = m < room ? m : room;
+            for (size_t i = 0; i < m; i++) {
+                a->delineated[a->delineated_count + i].r -= a->delay;
+            }
+            a->delineated_count += m;
+        }
+        x += chunk;
+        n -= chunk;
+    }
+    return count;
+}
@@ -0,0 +1,153 @@
+#include <string.h>
+
+#include "dsp/ecg_codec.h"
+
+static void put_le(uint8_t *p, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint64_t get_le(const uint8_t *p, int bytes)
+{
+    uint64_t v = 0;
+
+    for (int i = 0; i < bytes; i++) {
+        v |= (uint64_t)p[i] << (8 * i);
+    }
+    return v;
+}
+
+static uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static size_t encode_delta(const int32_t *x, size_t leads, size_t count,
+                           size_t stride, uint8_t *out, size_t cap)
+{
+    size_t len = 0;
+
+    for (size_t l = 0; l < leads; l++, x += stride) {
+        /* Each lead starts from zero and is decodable on its own */
+        int32_t prev = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            uint32_t v = zigzag((int32_t)((uint32_t)x[i] - (uint32_t)prev));
+
+            prev = x[i];
+            do {
+                if (len == cap) {
+                    return 0;
+                }
+                out[len++] = (uint8_t)((v & 0x7f) | (v > 0x7f ? 0x80 : 0));
+                v >>= 7;
+            } while (v != 0);
+        }
+    }
+    return len;
+}
+
+size_t ecg_codec_encode(const struct ecg_codec_frame *f, const int32_t *x,
+                        uint8_t *out, size_t cap)
+{
+    return ecg_codec_encode_strided(f, x, f->count, out, cap);
+}
+
+size_t ecg_codec_encode_strided(const struct ecg_codec_frame *f,
+                                const int32_t *x, size_t stride, uint8_t *out,
+                                size_t cap)
+{
+    const size_t leads = f->leads > 0 ? f->leads : 1;
+    const size_t n = leads * f->count;
+    const size_t raw_len = 4 * n;
+    uint8_t *payload = out + ECG_CODEC_HDR_SIZE;
+    uint8_t flags = (uint8_t)((leads - 1) << 4);
+    size_t len;
+
+    if (leads > ECG_CODEC_MAX_LEADS || cap < ECG_CODEC_MAX_SIZE(n)) {
+        return 0;
+    }
+
+    /* Stop as soon as the varint stream reaches the raw size */
+    len = n > 0 ? encode_delta(x, leads, f->count, stride, payload, raw_len)
+                : 0;
+    if (len == 0 && n > 0) {
+        for (size_t l = 0; l < leads; l++) {
+            for (size_t i = 0; i < f->count; i++) {
+                put_le(payload + 4 * (l * f->count + i),
+                       (uint32_t)x[l * stride + i], 4);
+            }
+        }
+        len = raw_len;
+        flags |= ECG_CODEC_FLAG_RAW;
+    }
+
+    out[0] = ECG_CODEC_MAGIC;
+    out[1] = flags;
+    put_le(out + 2, f->count, 2);
+    put_le(out + 4, f->seq, 4);
+    put_le(out + 8, (uint64_t)f->timestamp_us, 8);
+    return ECG_CODEC_HDR_SIZE + len;
+}
+
+int ecg_codec_decode(const uint8_t *in, size_t len, struct ecg_codec_frame *f,
+                     int32_t *x, size_t max_samples)
+{
+    size_t pos = ECG_CODEC_HDR_SIZE;
+    int32_t prev = 0;
+    size_t n;
+
+    if (len < ECG_CODEC_HDR_SIZE || in[0] != ECG_CODEC_MAGIC) {
+        return -1;
+    }
+
+    f->count = (uint16_t)get_le(in + 2, 2);
+    f->seq = (uint32_t)get_le(in + 4, 4);
+    f->timestamp_us = (int64_t)get_le(in + 8, 8);
+    f->leads = (uint8_t)((in[1] >> 4) + 1);
+    n = (size_t)f->leads * f->count;
+    if (n > max_samples) {
+        return -1;
+    }
+
+    if (in[1] & ECG_CODEC_FLAG_RAW) {
+        if (len - pos < 4 * n) {
+            return -1;
+        }
+        for (size_t i = 0; i < n; i++, pos += 4) {
+            x[i] = (int32_t)get_le(in + pos, 4);
+        }
+        return (int)pos;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        uint32_t v = 0;
+        int shift = 0;
+        uint8_t b;
+
+        if (i % f->count == 0) {
+            /* Next lead */
+            prev = 0;
+        }
+
+        do {
+            if (pos == len || shift > 28) {
+                return -1;
+            }
+            b = in[pos++];
+            v |= (uint32_t)(b & 0x7f) << shift;
+            shift += 7;
+        } while (b & 0x80);
+
+        prev = (int32_t)((uint32_t)prev + (uint32_t)unzigzag(v));
+        x[i] = prev;
+    }
+    return (int)pos;
+}
@@ -0,0 +1,93 @@
+#include "dsp/ecg_synth.h"
+
+/* Wave position relative to the R peak, half width (ms) and amplitude (uV) */
+struct wave {
+    int32_t center_ms;
+    int32_t half_ms;
+    int32_t amp_uv;
+};
+
+static const struct wave waves[] = {
+    {-200, 50, 150},  /* P */
+    {-30, 10, -150},  /* Q */
+    {0, 20, 1200},    /* R */
+    {30, 12, -300},   /* S */
+    {260, 80, 300},   /* T */
+};
+
+/* The R peak sits this far into each beat */
+#define R_OFFSET_MS 260
+
+#define WANDER_PERIOD_MS 3300
+
+static uint32_t lcg_next(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static void next_beat(struct ecg_synth *s)
+{
+    uint32_t rr = s->rr_ms;
+
+    if (s->rr_jitter_ms > 0) {
+        rr += lcg_next(&s->seed) % (2 * s->rr_jitter_ms + 1);
+        rr -= s->rr_jitter_ms;
+    }
+    s->beat_start += s->beat_len;
+    s->beat_len = rr * s->fs_hz / 1000;
+}
+
+void ecg_synth_init(struct ecg_synth *s, uint32_t fs_hz, uint32_t hr_bpm,
+                    uint32_t seed)
+{
+    s->fs_hz = fs_hz;
+    s->seed = seed;
+    s->rr_ms = 60000 / hr_bpm;
+    s->rr_jitter_ms = s->rr_ms / 20;
+    s->wander_uv = 200;
+    s->n = 0;
+    s->beat_start = 0;
+    s->beat_len = 0;
+    next_beat(s);
+}
+
+static int32_t wander(const struct ecg_synth *s, int64_t t_ms)
+{
+    /* Triangle wave, cheap stand-in for respiration baseline wander */
+    int32_t phase = (int32_t)(t_ms % WANDER_PERIOD_MS);
+    int32_t half = WANDER_PERIOD_MS / 2;
+    int32_t tri = phase < half ? phase : WANDER_PERIOD_MS - phase;
+
+    return (int32_t)((int64_t)s->wander_uv * (2 * tri - half) / half);
+}
+
+void ecg_synth_fill(struct ecg_synth *s, int32_t *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++, s->n++) {
+        int32_t pos_ms;
+        int32_t v;
+
+        while (s->n - s->beat_start >= s->beat_len) {
+            next_beat(s);
+        }
+
+        pos_ms = (int32_t)((s->n - s->beat_start) * 1000 / s->fs_hz) -
+                 R_OFFSET_MS;
+        v = wander(s, (int64_t)(s->n * 1000 / s->fs_hz));
+        for (size_t w = 0; w < sizeof(waves) / sizeof(waves[0]); w++) {
+            int32_t d = pos_ms - waves[w].center_ms;
+            int32_t h = waves[w].half_ms;
+
+            if (d > -h && d < h) {
+                v += waves[w].amp_uv * (h * h - d * d) / (h * h);
+            }
+        }
+        out[i] = v;
+    }
+}
+
+uint64_t ecg_synth_r_peak(const struct ecg_synth *s)
+{
+    return s->beat_start + (uint64_t)R_OFFSET_MS * s->fs_hz / 1000;
+}
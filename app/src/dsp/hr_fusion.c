@@ -0,0 +1,199 @@
+#include <string.h>
+
+#include "dsp/hr_fusion.h"
+
+/* Variance ceiling, (50 bpm)^2: the estimate knows nothing any more */
+#define VAR_MAX ((uint64_t)5000 * 5000)
+
+/* Measurement SD ceiling, 1000 bpm: keeps var * r in range */
+#define NOISE_SD_MAX_CBPM 100000
+
+/* Acceleration beyond this is shaking, not exercise */
+#define ACTIVITY_MAX_MG 4000
+
+/* 600 bpm, keeps the innovation squared in range */
+#define HR_MAX_CBPM 60000
+
+/* One outlier lifts the innovation mean to about twice the threshold */
+#define INNOV_SQ_MAX                                                           \
+    ((uint64_t)HR_FUSION_RELIABLE_CBPM * HR_FUSION_RELIABLE_CBPM *             \
+     (2 << HR_FUSION_INNOV_SHIFT))
+
+static const uint32_t source_sd[HR_SOURCES] = {
+    [HR_SOURCE_ECG] = HR_FUSION_ECG_SD_CBPM,
+    [HR_SOURCE_PPG] = HR_FUSION_PPG_SD_CBPM,
+};
+
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t r = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+void hr_fusion_init(struct hr_fusion *f)
+{
+    memset(f, 0, sizeof(*f));
+}
+
+void hr_fusion_motion(struct hr_fusion *f, uint32_t activity_mg)
+{
+    f->activity_mg = activity_mg < ACTIVITY_MAX_MG ? activity_mg
+                                                   : ACTIVITY_MAX_MG;
+}
+
+/* Variance of the estimate carried forward to t_us */
+static uint64_t predict(const struct hr_fusion *f, int64_t t_us)
+{
+    uint64_t q = (uint64_t)HR_FUSION_Q_REST *
+                 (HR_FUSION_MOTION_MG + f->activity_mg) / HR_FUSION_MOTION_MG;
+    int64_t dt_us = t_us - f->t_us;
+    uint64_t var;
+
+    if (dt_us <= 0) {
+        return f->var;
+    }
+    /* Past a quarter hour the ceiling is reached at any motion */
+    if (dt_us > 900 * 1000000LL) {
+        return VAR_MAX;
+    }
+    var = f->var + q * (uint64_t)dt_us / 1000000;
+    return var < VAR_MAX ? var : VAR_MAX;
+}
+
+/* Measurement variance of a beat of src */
+static uint64_t noise(const struct hr_fusion *f, enum hr_source src,
+                      uint8_t degraded)
+{
+    uint64_t sd = (uint64_t)source_sd[src] << degraded;
+
+    if (src == HR_SOURCE_ECG) {
+        sd = sd * HR_FUSION_ECG_MOTION_MG /
+             (HR_FUSION_ECG_MOTION_MG + f->activity_mg);
+    }
+    if (src == HR_SOURCE_PPG) {
+        /* x (1 + (MAX - 1) a / (a + MG)), saturating */
+        sd = sd * (HR_FUSION_PPG_MOTION_MG +
+                   HR_FUSION_PPG_MOTION_MAX * f->activity_mg) /
+             (HR_FUSION_PPG_MOTION_MG + f->activity_mg);
+    }
+    sd = sd < NOISE_SD_MAX_CBPM ? sd : NOISE_SD_MAX_CBPM;
+    return sd * sd;
+}
+
+static int live(const struct hr_fusion_source *s, int64_t t_us)
+{
+    return s->accepted > 0 &&
+           t_us - s->accepted_us <= (int64_t)HR_FUSION_STALE_MS * 1000;
+}
+
+/* Whether a source other than src was accepted lately */
+static int others_live(const struct hr_fusion *f, enum hr_source src,
+                       int64_t t_us)
+{
+    for (int i = 0; i < HR_SOURCES; i++) {
+        if (i != (int)src && live(&f->src[i], t_us)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int hr_fusion_update(struct hr_fusion *f, enum hr_source src, int64_t t_us,
+                     uint32_t hr_cbpm, uint8_t degraded)
+{
+    struct hr_fusion_source *s = &f->src[src];
+    int64_t t = t_us > f->t_us ? t_us : f->t_us;
+    uint64_t r;
+
+    hr_cbpm = hr_cbpm < HR_MAX_CBPM ? hr_cbpm : HR_MAX_CBPM;
+    degraded = degraded < HR_FUSION_DEGRADED_MAX ? degraded
+                                                 : HR_FUSION_DEGRADED_MAX;
+    r = noise(f, src, degraded);
+    s->degraded = degraded;
+
+    if (!f->started) {
+        f->started = 1;
+        f->hr_cbpm = (int32_t)hr_cbpm;
+        f->var = r;
+    } else {
+        int64_t innov = (int64_t)hr_cbpm - f->hr_cbpm;
+        uint64_t var = predict(f, t);
+        uint64_t sq = (uint64_t)(innov * innov);
+
+        s->innov_sq = (uint64_t)((int64_t)s->innov_sq +
+                                 ((int64_t)(sq < INNOV_SQ_MAX ? sq
+                                                              : INNOV_SQ_MAX) -
+                                  (int64_t)s->innov_sq) /
+                                     (1 << HR_FUSION_INNOV_SHIFT));
+        if (sq >
+            (uint64_t)HR_FUSION_GATE * HR_FUSION_GATE * (var + r)) {
+            if (s->rejected_run < UINT8_MAX) {
+                s->rejected_run++;
+            }
+            if (s->rejected_run < HR_FUSION_REACQUIRE ||
+                others_live(f, src, t)) {
+                s->rejected++;
+                return 0;
+            }
+            /* Only this source is left and it disagrees: believe it */
+            f->hr_cbpm = (int32_t)hr_cbpm;
+            f->var = r;
+            f->restarts++;
+        } else {
+            uint64_t k_q16 = (var << 16) / (var + r);
+
+            f->hr_cbpm += (int32_t)(innov * (int64_t)k_q16 / 65536);
+            f->var = var * r / (var + r);
+        }
+    }
+    f->t_us = t;
+    s->accepted_us = t;
+    s->accepted++;
+    s->rejected_run = 0;
+    return 1;
+}
+
+void hr_fusion_stats_get(const struct hr_fusion *f, int64_t now_us,
+                         struct hr_fusion_stats *st)
+{
+    int any = 0;
+
+    memset(st, 0, sizeof(*st));
+    st->activity_mg = f->activity_mg;
+    st->restarts = f->restarts;
+    for (int i = 0; i < HR_SOURCES; i++) {
+        const struct hr_fusion_source *s = &f->src[i];
+
+        st->accepted[i] = s->accepted;
+        st->rejected[i] = s->rejected;
+        if (!live(s, now_us)) {
+            continue;
+        }
+        any = 1;
+        if (s->rejected_run == 0 && s->degraded == 0 &&
+            s->innov_sq <= (uint64_t)HR_FUSION_RELIABLE_CBPM *
+                               HR_FUSION_RELIABLE_CBPM) {
+            st->reliable |= 1u << i;
+        }
+    }
+    if (!f->started) {
+        return;
+    }
+    st->hr_cbpm = (uint32_t)f->hr_cbpm;
+    st->sd_cbpm = isqrt64(predict(f, now_us));
+    st->valid = any && st->sd_cbpm <= HR_FUSION_SD_MAX_CBPM;
+}
@@ -0,0 +1,222 @@
+#include <string.h>
+
+#include "dsp/hrv.h"
+
+#define HRV_NO_DIFF UINT32_MAX
+
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t r = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+void hrv_init(struct hrv *h)
+{
+    memset(h, 0, sizeof(*h));
+    median_init(&h->rr_median, h->rr_median_buf, HRV_MEDIAN_BEATS);
+}
+
+/* Too far from the running median, once that has a majority to go by */
+static int rr_outlier(struct hrv *h, uint32_t rr_ms)
+{
+    int32_t med;
+    int32_t dev;
+
+    median_add(&h->rr_median, (int32_t)rr_ms);
+    if (h->rr_median.count <= HRV_MEDIAN_BEATS / 2) {
+        return 0;
+    }
+    med = median_get(&h->rr_median);
+    dev = (int32_t)rr_ms - med;
+    return (dev < 0 ? -dev : dev) * 100 > med * HRV_MEDIAN_DEV_PCT;
+}
+
+void hrv_add_rr(struct hrv *h, uint32_t rr_ms)
+{
+    uint16_t rr;
+    uint32_t diff_sq = HRV_NO_DIFF;
+
+    if (rr_ms < HRV_RR_MIN_MS || rr_ms > HRV_RR_MAX_MS ||
+        rr_outlier(h, rr_ms)) {
+        h->rejected++;
+        /* The next interval has no valid predecessor */
+        h->prev_rr = 0;
+        return;
+    }
+    rr = (uint16_t)rr_ms;
+
+    if (h->count == HRV_WINDOW) {
+        uint16_t old = h->rr[h->head];
+
+        h->sum -= old;
+        h->sum_sq -= (uint32_t)old * old;
+        if (h->diff_sq[h->head] != HRV_NO_DIFF) {
+            h->sum_diff_sq -= h->diff_sq[h->head];
+            h->diffs--;
+        }
+    } else {
+        h->count++;
+    }
+
+    if (h->prev_rr != 0) {
+        int32_t d = (int32_t)rr - h->prev_rr;
+
+        diff_sq = (uint32_t)(d * d);
+        h->sum_diff_sq += diff_sq;
+        h->diffs++;
+    }
+
+    h->rr[h->head] = rr;
+    h->diff_sq[h->head] = diff_sq;
+    h->sum += rr;
+    h->sum_sq += (uint32_t)rr * rr;
+    h->prev_rr = rr;
+    h->head = (h->head + 1) % HRV_WINDOW;
+}
+
+void hrv_get(const struct hrv *h, struct hrv_stats *st)
+{
+    memset(st, 0, sizeof(*st));
+    st->count = h->count;
+    st->rejected = h->rejected;
+    if (h->count == 0) {
+        return;
+    }
+
+    st->mean_rr_ms = (uint32_t)(h->sum / h->count);
+    st->hr_dbpm = (uint32_t)(600000ULL * h->count / h->sum);
+    if (h->count > 1) {
+        uint64_t n = h->count;
+        uint64_t var = (h->sum_sq * n - h->sum * h->sum) / (n * (n - 1));
+
+        st->sdnn_ms = isqrt64(var);
+    }
+    if (h->diffs > 0) {
+        st->rmssd_ms = isqrt64(h->sum_diff_sq / h->diffs);
+    }
+}
+
+/* Band edges in mHz */
+#define LF_LO_MHZ 40
+#define LF_HI_MHZ 150
+#define HF_HI_MHZ 400
+
+/*
+ * RR interval j of the window plots at the end of that interval, so the
+ * series is sampled at the beats and resampled by linear interpolation
+ * between them, in microseconds.
+ */
+static void resample(const struct hrv *h, int32_t *x, uint32_t span_ms)
+{
+    const uint32_t first = (h->head + HRV_WINDOW - h->count) % HRV_WINDOW;
+    uint32_t j = 0;
+    uint64_t beat_us = 0;
+
+    for (uint32_t m = 0; m < HRV_FREQ_N; m++) {
+        uint64_t t_us = (uint64_t)m * span_ms * 1000 / HRV_FREQ_N;
+        int32_t rr, next;
+
+        /* Advance to the last beat at or before t */
+        while (j + 1 < h->count) {
+            uint64_t end_us =
+                beat_us + h->rr[(first + j + 1) % HRV_WINDOW] * 1000ULL;
+
+            if (end_us > t_us) {
+                break;
+            }
+            beat_us = end_us;
+            j++;
+        }
+        rr = h->rr[(first + j) % HRV_WINDOW];
+        if (j + 1 == h->count) {
+            x[m] = rr * 1000;
+            continue;
+        }
+        next = h->rr[(first + j + 1) % HRV_WINDOW];
+        x[m] = rr * 1000 +
+               (int32_t)((int64_t)(next - rr) * (int64_t)(t_us - beat_us) /
+                         next);
+    }
+}
+
+int hrv_freq_get(const struct hrv *h, const struct spectrum *s, int32_t *buf,
+                 uint64_t *power, struct hrv_freq *fr)
+{
+    const uint32_t first = (h->head + HRV_WINDOW - h->count) % HRV_WINDOW;
+    uint32_t span_ms;
+    int64_t mean = 0;
+    uint64_t lf = 0, hf = 0;
+    uint32_t peak = 0;
+
+    memset(fr, 0, sizeof(*fr));
+    if (h->count < HRV_FREQ_MIN_BEATS || s->n != HRV_FREQ_N) {
+        return -1;
+    }
+    /* From the end of the first interval to the end of the last */
+    span_ms = (uint32_t)(h->sum - h->rr[first]);
+
+    resample(h, buf, span_ms);
+    for (uint32_t m = 0; m < HRV_FREQ_N; m++) {
+        mean += buf[m];
+    }
+    mean /= HRV_FREQ_N;
+    for (uint32_t m = 0; m < HRV_FREQ_N; m++) {
+        buf[m] -= (int32_t)mean;
+    }
+    spectrum_hann(s, buf);
+    spectrum_power(s, buf, power);
+
+    /* Bin k is k / span Hz */
+    for (uint32_t k = 1; k < HRV_FREQ_N / 2; k++) {
+        uint64_t f_mhz = (uint64_t)k * 1000000 / span_ms;
+
+        if (f_mhz >= LF_LO_MHZ && f_mhz < LF_HI_MHZ) {
+            lf += power[k];
+        } else if (f_mhz >= LF_HI_MHZ && f_mhz < HF_HI_MHZ) {
+            hf += power[k];
+            if (peak == 0 || power[k] > power[peak]) {
+                peak = k;
+            }
+        }
+    }
+
+    /*
+     * One-sided bins count twice, and the Hann window keeps 3/8 of the
+     * power: x 16 / 3, from us^2 with SPECTRUM_POWER_FRAC bits to ms^2.
+     */
+    lf = (lf * 16 / 3 >> SPECTRUM_POWER_FRAC) / 1000000;
+    hf = (hf * 16 / 3 >> SPECTRUM_POWER_FRAC) / 1000000;
+    fr->lf_ms2 = lf > UINT32_MAX ? UINT32_MAX : (uint32_t)lf;
+    fr->hf_ms2 = hf > UINT32_MAX ? UINT32_MAX : (uint32_t)hf;
+    if (fr->hf_ms2 > 0) {
+        fr->lf_hf_pct = (uint32_t)((uint64_t)fr->lf_ms2 * 100 / fr->hf_ms2);
+    }
+
+    if (peak != 0 && power[peak] > 0) {
+        /* Parabola through the peak magnitudes, in 1/1000 bin */
+        int64_t lo = isqrt64(power[peak - 1]);
+        int64_t mid = isqrt64(power[peak]);
+        int64_t hi = isqrt64(power[peak + 1]);
+        int64_t den = 2 * mid - lo - hi;
+        int64_t delta = den > 0 ? 500 * (hi - lo) / den : 0;
+
+        delta = delta > 500 ? 500 : delta < -500 ? -500 : delta;
+        fr->resp_dbrpm =
+            (uint32_t)(((int64_t)peak * 1000 + delta) * 600 / span_ms);
+    }
+    return 0;
+}
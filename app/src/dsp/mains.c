@@ -0,0 +1,343 @@
+#include <math.h>
+#include <string.h>
+
+#include "dsp/mains.h"
+
+#define PI 3.14159265358979323846
+
+/* Goertzel coefficients 2 cos(w) in Q2.30 */
+#define COEF_SHIFT 30
+
+/*
+ * The window sees the first difference of the input, which drops the
+ * electrode offset and baseline wander that would otherwise leak into the
+ * bins, clipped so that no bin state can overflow: MAINS_WINDOW_MAX
+ * samples of 2^15 resonating in a bin above 40 Hz stay below 2^28.
+ */
+#define MAINS_WINDOW_MAX 2048
+#define DIFF_MAX         32767
+
+/* Frequency moves that retune the notches, and that count as drift */
+#define RETUNE_MHZ 10
+#define STABLE_MHZ 25
+
+/* Tracking stays within this distance of the nominal frequency */
+#define TRACK_RANGE_MHZ 1500
+
+static const uint32_t candidates_mhz[] = {50000, 60000};
+
+#define CANDIDATES (sizeof(candidates_mhz) / sizeof(candidates_mhz[0]))
+
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t r = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+static uint32_t ms_to_samples(const struct mains *m, uint32_t ms)
+{
+    return (uint32_t)((uint64_t)m->fs_hz * ms / 1000);
+}
+
+/* Harmonic and its reference bins well below Nyquist */
+static int usable(const struct mains *m, uint32_t f_mhz)
+{
+    return (uint64_t)f_mhz + MAINS_REF_HZ * 1000 <
+           (uint64_t)m->fs_hz * 1000 * 45 / 100;
+}
+
+static void add_bin(struct mains *m, uint32_t f_mhz)
+{
+    double w = 2.0 * PI * f_mhz / 1000.0 / (double)m->fs_hz;
+
+    m->bins[m->nbins].coef = (int32_t)lround(2.0 * cos(w) * (1 << COEF_SHIFT));
+    m->bins[m->nbins].s1 = 0;
+    m->bins[m->nbins].s2 = 0;
+    m->bins[m->nbins].freq_mhz = f_mhz;
+    m->nbins++;
+}
+
+static void add_harmonic(struct mains *m, uint32_t f_mhz)
+{
+    add_bin(m, f_mhz);
+    add_bin(m, f_mhz - MAINS_REF_HZ * 1000);
+    add_bin(m, f_mhz + MAINS_REF_HZ * 1000);
+}
+
+/* Lay out the bins of the next window */
+static void window_start(struct mains *m)
+{
+    m->nbins = 0;
+    if (m->freq_mhz == 0) {
+        for (size_t c = 0; c < CANDIDATES; c++) {
+            for (uint32_t h = 1; h <= MAINS_HARMONICS; h++) {
+                if (usable(m, h * candidates_mhz[c])) {
+                    add_harmonic(m, h * candidates_mhz[c]);
+                }
+            }
+        }
+    } else {
+        for (uint32_t h = 1; h <= MAINS_HARMONICS; h++) {
+            if (usable(m, h * m->freq_mhz)) {
+                add_harmonic(m, h * m->freq_mhz);
+            }
+        }
+        add_bin(m, m->freq_mhz - MAINS_STEP_MHZ);
+        add_bin(m, m->freq_mhz + MAINS_STEP_MHZ);
+    }
+}
+
+static uint64_t power(const struct mains *m, uint32_t f_mhz)
+{
+    for (size_t i = 0; i < m->nbins; i++) {
+        if (m->bins[i].freq_mhz == f_mhz) {
+            int64_t s1 = m->bins[i].s1;
+            int64_t s2 = m->bins[i].s2;
+            int64_t p = s1 * s1 + s2 * s2 -
+                        ((m->bins[i].coef * s1) >> COEF_SHIFT) * s2;
+
+            return p > 0 ? (uint64_t)p : 0;
+        }
+    }
+    return 0;
+}
+
+/* Power over the reference floor, 0 if not above MAINS_SNR */
+static uint64_t snr(const struct mains *m, uint32_t f_mhz)
+{
+    uint64_t p = power(m, f_mhz);
+    uint64_t floor = (power(m, f_mhz - MAINS_REF_HZ * 1000) +
+                      power(m, f_mhz + MAINS_REF_HZ * 1000)) /
+                         2 +
+                     1;
+
+    return p / floor >= MAINS_SNR ? p / floor : 0;
+}
+
+static void retune(struct mains *m, uint8_t harmonics)
+{
+    for (uint32_t h = 1; h <= MAINS_HARMONICS; h++) {
+        if (harmonics & (1u << (h - 1))) {
+            biquad_notch(&m->notch[h - 1], m->fs_hz,
+                         h * m->freq_mhz / 1000.0,
+                         MAINS_NOTCH_BW_CHZ / 100.0);
+        }
+    }
+    m->harmonics = harmonics;
+    m->generation++;
+    m->retunes++;
+}
+
+static uint8_t present(const struct mains *m)
+{
+    uint8_t harmonics = 0;
+
+    for (uint32_t h = 1; h <= MAINS_HARMONICS; h++) {
+        if (usable(m, h * m->freq_mhz) && snr(m, h * m->freq_mhz) > 0) {
+            harmonics |= (uint8_t)(1u << (h - 1));
+        }
+    }
+    return harmonics;
+}
+
+/* Pick 50 or 60 Hz, return whether either is there */
+static int search(struct mains *m)
+{
+    uint64_t best = 0;
+
+    for (size_t c = 0; c < CANDIDATES; c++) {
+        uint64_t r = snr(m, candidates_mhz[c]);
+
+        if (r > best) {
+            best = r;
+            m->freq_mhz = candidates_mhz[c];
+        }
+    }
+    if (best == 0) {
+        return 0;
+    }
+    /* The harmonics were measured at the nominal frequency too */
+    retune(m, present(m));
+    m->misses = 0;
+    return 1;
+}
+
+/*
+ * Follow the fundamental, return the frequency change in mHz. The bins
+ * either side see the sinc main lobe; a parabola through the three
+ * magnitudes peaks at the frequency error, exactly so once centred.
+ */
+static int32_t track(struct mains *m)
+{
+    uint8_t harmonics = present(m);
+    int64_t lo, mid, hi, den, delta = 0;
+    uint32_t nominal;
+
+    if (!(harmonics & 1)) {
+        /* Gone for two windows in a row: notches off, search again */
+        if (++m->misses >= 2) {
+            m->freq_mhz = 0;
+            retune(m, 0);
+        }
+        return STABLE_MHZ;
+    }
+    m->misses = 0;
+
+    lo = isqrt64(power(m, m->freq_mhz - MAINS_STEP_MHZ));
+    mid = isqrt64(power(m, m->freq_mhz));
+    hi = isqrt64(power(m, m->freq_mhz + MAINS_STEP_MHZ));
+    den = 2 * mid - lo - hi;
+    if (den > 0) {
+        delta = MAINS_STEP_MHZ * (hi - lo) / (2 * den);
+    }
+    if (den <= 0 || delta > MAINS_STEP_MHZ || delta < -MAINS_STEP_MHZ) {
+        /* Off the top of the lobe, step toward the larger side */
+        delta = hi > lo ? MAINS_STEP_MHZ : -MAINS_STEP_MHZ;
+    }
+
+    nominal = m->freq_mhz < 55000 ? 50000 : 60000;
+    m->freq_mhz = (uint32_t)((int64_t)m->freq_mhz + delta);
+    if (m->freq_mhz > nominal + TRACK_RANGE_MHZ) {
+        m->freq_mhz = nominal + TRACK_RANGE_MHZ;
+    } else if (m->freq_mhz < nominal - TRACK_RANGE_MHZ) {
+        m->freq_mhz = nominal - TRACK_RANGE_MHZ;
+    }
+
+    if (delta >= RETUNE_MHZ || delta <= -RETUNE_MHZ ||
+        harmonics != m->harmonics) {
+        retune(m, harmonics);
+    }
+    return (int32_t)delta;
+}
+
+void mains_init(struct mains *m, uint32_t fs_hz)
+{
+    memset(m, 0, sizeof(*m));
+    m->fs_hz = fs_hz;
+    m->window = ms_to_samples(m, MAINS_WINDOW_MS);
+    if (m->window > MAINS_WINDOW_MAX) {
+        m->window = MAINS_WINDOW_MAX;
+    }
+    m->interval = ms_to_samples(m, MAINS_INTERVAL_MIN_MS);
+    /* First window right away */
+    window_start(m);
+}
+
+/* Window complete: estimate and schedule the next one */
+static int window_end(struct mains *m)
+{
+    uint32_t generation = m->generation;
+    int32_t delta;
+
+    m->estimates++;
+    if (m->freq_mhz == 0) {
+        delta = search(m) ? STABLE_MHZ : 0;
+    } else {
+        delta = track(m);
+    }
+
+    if (delta < STABLE_MHZ && delta > -STABLE_MHZ) {
+        m->interval *= 2;
+        if (m->interval > ms_to_samples(m, MAINS_INTERVAL_MAX_MS)) {
+            m->interval = ms_to_samples(m, MAINS_INTERVAL_MAX_MS);
+        }
+    } else {
+        m->interval = ms_to_samples(m, MAINS_INTERVAL_MIN_MS);
+    }
+    m->wait = m->interval;
+    m->n = 0;
+    return m->generation != generation;
+}
+
+int mains_update(struct mains *m, const int32_t *x, size_t n)
+{
+    int changed = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        int32_t d;
+
+        if (m->wait > 0) {
+            /* Between windows: skip ahead, keeping the last sample */
+            size_t skip = n - i < m->wait ? n - i : m->wait;
+
+            m->wait -= (uint32_t)skip;
+            i += skip - 1;
+            m->prev = x[i];
+            if (m->wait == 0) {
+                window_start(m);
+            }
+            continue;
+        }
+
+        d = x[i] - m->prev;
+        d = d > DIFF_MAX ? DIFF_MAX : d < -DIFF_MAX ? -DIFF_MAX : d;
+        m->prev = x[i];
+        /* The first sample only primes the difference */
+        if (m->n++ == 0) {
+            continue;
+        }
+        for (size_t b = 0; b < m->nbins; b++) {
+            int32_t s = d +
+                        (int32_t)(((int64_t)m->bins[b].coef * m->bins[b].s1) >>
+                                  COEF_SHIFT) -
+                        m->bins[b].s2;
+
+            m->bins[b].s2 = m->bins[b].s1;
+            m->bins[b].s1 = s;
+        }
+        if (m->n == m->window) {
+            changed |= window_end(m);
+        }
+    }
+    return changed;
+}
+
+void mains_notch_process(const struct mains *m, struct mains_notch *f,
+                         int32_t *x, size_t n)
+{
+    if (f->generation != m->generation) {
+        for (size_t h = 0; h < MAINS_HARMONICS; h++) {
+            uint8_t bit = (uint8_t)(1u << h);
+
+            if (!(m->harmonics & bit)) {
+                continue;
+            }
+            if (f->harmonics & bit) {
+                /* Retuned: keep the state, as with the baseline cutoff */
+                f->section[h].c = m->notch[h];
+            } else {
+                biquad_init(&f->section[h], &m->notch[h]);
+            }
+        }
+        f->harmonics = m->harmonics;
+        f->generation = m->generation;
+    }
+    for (size_t h = 0; h < MAINS_HARMONICS; h++) {
+        if (f->harmonics & (1u << h)) {
+            biquad_process(&f->section[h], x, n);
+        }
+    }
+}
+
+void mains_stats_get(const struct mains *m, struct mains_stats *st)
+{
+    st->freq_mhz = m->freq_mhz;
+    st->harmonics = m->harmonics;
+    st->estimates = m->estimates;
+    st->retunes = m->retunes;
+    st->interval = m->interval;
+}
@@ -0,0 +1,177 @@
+#include <string.h>
+
+#include "dsp/median.h"
+
+/*
+ * Heap indices run from -maxct to minct around the median at 0. The
+ * children of i are 2i and 2i + 1 in the min-heap, 2i and 2i - 1 in the
+ * max-heap, so the parent of either is i / 2 with C division.
+ */
+static int minct(const struct median *m)
+{
+    return (m->count - 1) / 2;
+}
+
+static int maxct(const struct median *m)
+{
+    return m->count / 2;
+}
+
+static int less(const struct median *m, int i, int j)
+{
+    return m->data[m->heap[i]] < m->data[m->heap[j]];
+}
+
+/* Swap heap entries i and j if the value at i is less, return whether */
+static int cmp_exch(struct median *m, int i, int j)
+{
+    int16_t t;
+
+    if (!less(m, i, j)) {
+        return 0;
+    }
+    t = m->heap[i];
+    m->heap[i] = m->heap[j];
+    m->heap[j] = t;
+    m->pos[m->heap[i]] = (int16_t)i;
+    m->pos[m->heap[j]] = (int16_t)j;
+    return 1;
+}
+
+/* Sift down from child i of the min-heap */
+static void min_sort_down(struct median *m, int i)
+{
+    for (; i <= minct(m); i *= 2) {
+        if (i > 1 && i < minct(m) && less(m, i + 1, i)) {
+            i++;
+        }
+        if (!cmp_exch(m, i, i / 2)) {
+            break;
+        }
+    }
+}
+
+/* Sift down from child i of the max-heap */
+static void max_sort_down(struct median *m, int i)
+{
+    for (; i >= -maxct(m); i *= 2) {
+        if (i < -1 && i > -maxct(m) && less(m, i, i - 1)) {
+            i--;
+        }
+        if (!cmp_exch(m, i / 2, i)) {
+            break;
+        }
+    }
+}
+
+/* Sift up, return whether the entry reached the median */
+static int min_sort_up(struct median *m, int i)
+{
+    while (i > 0 && cmp_exch(m, i, i / 2)) {
+        i /= 2;
+    }
+    return i == 0;
+}
+
+static int max_sort_up(struct median *m, int i)
+{
+    while (i < 0 && cmp_exch(m, i / 2, i)) {
+        i /= 2;
+    }
+    return i == 0;
+}
+
+int median_init(struct median *m, uint32_t *storage, size_t n)
+{
+    if (n == 0 || n > MEDIAN_MAX_WINDOW) {
+        return -1;
+    }
+    m->data = (int32_t *)storage;
+    m->pos = (int16_t *)(storage + n);
+    m->heap = m->pos + n + n / 2;
+    m->size = (uint16_t)n;
+    m->count = 0;
+    m->idx = 0;
+
+    /* Slots alternate between the heaps, 0 at the median */
+    for (size_t i = 0; i < n; i++) {
+        int p = (int)((i + 1) / 2) * ((i & 1) ? -1 : 1);
+
+        m->data[i] = 0;
+        m->pos[i] = (int16_t)p;
+        m->heap[p] = (int16_t)i;
+    }
+    return 0;
+}
+
+void median_add(struct median *m, int32_t x)
+{
+    int fresh = m->count < m->size;
+    int p = m->pos[m->idx];
+    int32_t old = m->data[m->idx];
+
+    m->data[m->idx] = x;
+    m->idx = (uint16_t)((m->idx + 1) % m->size);
+    m->count += fresh;
+
+    if (p > 0) {
+        if (!fresh && old < x) {
+            min_sort_down(m, p * 2);
+        } else if (min_sort_up(m, p)) {
+            max_sort_down(m, -1);
+        }
+    } else if (p < 0) {
+        if (!fresh && x < old) {
+            max_sort_down(m, p * 2);
+        } else if (max_sort_up(m, p)) {
+            min_sort_down(m, 1);
+        }
+    } else {
+        if (maxct(m) > 0) {
+            max_sort_down(m, -1);
+        }
+        if (minct(m) > 0) {
+            min_sort_down(m, 1);
+        }
+    }
+}
+
+void median_process(struct median *m, int32_t *x, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        median_add(m, x[i]);
+        x[i] = median_get(m);
+    }
+}
+
+int median_baseline_init(struct median_baseline *b, uint32_t fs_hz,
+                         uint32_t *storage, size_t words)
+{
+    size_t w1 = MEDIAN_BASELINE_W1(fs_hz);
+    size_t w2 = MEDIAN_BASELINE_W2(fs_hz);
+
+    if (words < MEDIAN_BASELINE_WORDS(fs_hz) ||
+        median_init(&b->m1, storage, w1) != 0 ||
+        median_init(&b->m2, storage + MEDIAN_WORDS(w1), w2) != 0) {
+        return -1;
+    }
+    b->delay = (int32_t *)(storage + MEDIAN_WORDS(w1) + MEDIAN_WORDS(w2));
+    b->delay_len = (uint32_t)MEDIAN_BASELINE_DELAY(fs_hz);
+    b->delay_pos = 0;
+    memset(b->delay, 0, b->delay_len * sizeof(*b->delay));
+    return 0;
+}
+
+void median_baseline_process(struct median_baseline *b, int32_t *x, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        int32_t v = x[i];
+        int32_t delayed = b->delay[b->delay_pos];
+
+        median_add(&b->m1, v);
+        median_add(&b->m2, median_get(&b->m1));
+        b->delay[b->delay_pos] = v;
+        b->delay_pos = (b->delay_pos + 1) % b->delay_len;
+        x[i] = delayed - median_get(&b->m2);
+    }
+}
@@ -0,0 +1,184 @@
+#include <string.h>
+
+#include "dsp/pat.h"
+
+/* States of the upstroke search, as in the SpO2 estimator */
+#define SEARCH_START  0
+#define SEARCH_TROUGH 1
+#define SEARCH_PEAK   2
+
+#define HYST_START_SHIFT 12
+#define HYST_MIN_SHIFT   13
+
+void pat_init(struct pat *p, uint32_t ppg_fs_hz)
+{
+    memset(p, 0, sizeof(*p));
+    p->fs_hz = ppg_fs_hz;
+    p->span = (uint8_t)(ppg_fs_hz * PAT_SLOPE_MS / 1000);
+    if (p->span < 1) {
+        p->span = 1;
+    } else if (p->span > PAT_SLOPE_MAX) {
+        p->span = PAT_SLOPE_MAX;
+    }
+    median_init(&p->pat_median, p->pat_buf, PAT_BEATS);
+}
+
+/* Append, dropping the oldest entry of a full queue */
+static void queue_push(struct pat_queue *q, int64_t t_us, uint32_t *lost)
+{
+    if (q->count == PAT_QUEUE) {
+        q->head = (q->head + 1) % PAT_QUEUE;
+        q->count--;
+        (*lost)++;
+    }
+    q->t_us[(q->head + q->count) % PAT_QUEUE] = t_us;
+    q->count++;
+}
+
+static int64_t queue_pop(struct pat_queue *q)
+{
+    int64_t t_us = q->t_us[q->head];
+
+    q->head = (q->head + 1) % PAT_QUEUE;
+    q->count--;
+    return t_us;
+}
+
+/*
+ * Both queues are in time order. A foot too close after the oldest R peak
+ * is too close after every later one as well; the oldest R peak with the
+ * next foot too far has none. Either way the oldest entry goes, so every
+ * event costs O(1) amortised.
+ */
+static size_t match(struct pat *p)
+{
+    size_t pairs = 0;
+
+    while (p->r.count > 0 && p->feet.count > 0) {
+        int64_t r_us = p->r.t_us[p->r.head];
+        int64_t d_us = p->feet.t_us[p->feet.head] - r_us;
+
+        if (d_us < PAT_MIN_MS * 1000) {
+            queue_pop(&p->feet);
+            p->feet_unpaired++;
+            continue;
+        }
+        queue_pop(&p->r);
+        if (d_us > PAT_MAX_MS * 1000) {
+            p->r_unpaired++;
+            continue;
+        }
+        queue_pop(&p->feet);
+        p->last_r_us = r_us;
+        p->last_pat_us = (uint32_t)d_us;
+        median_add(&p->pat_median, (int32_t)d_us);
+        p->pairs++;
+        pairs++;
+    }
+    return pairs;
+}
+
+size_t pat_r_peak(struct pat *p, int64_t t_us)
+{
+    queue_push(&p->r, t_us, &p->r_unpaired);
+    return match(p);
+}
+
+/* Track the steepest span of the upstroke, timed at its middle */
+static void upstroke(struct pat *p, int32_t v, int64_t t_us)
+{
+    /* The oldest of the last span samples, before v goes in */
+    int32_t old = p->hist[p->hist_pos];
+    int32_t d = v - old;
+
+    if (d > p->slope) {
+        p->slope = d;
+        p->slope_mid2 = (int64_t)v + old;
+        p->slope_us = t_us - (int64_t)p->span * 500000 / p->fs_hz;
+    }
+}
+
+/* Tangent at the steepest span down to the trough level */
+static void foot(struct pat *p)
+{
+    int64_t rise2 = p->slope_mid2 - 2 * (int64_t)p->trough;
+    int64_t foot_us = p->slope_us - rise2 * p->span * 1000000 /
+                                        ((int64_t)2 * p->slope * p->fs_hz);
+
+    queue_push(&p->feet, foot_us, &p->feet_unpaired);
+}
+
+size_t pat_ppg(struct pat *p, const int32_t *ir, size_t n, int64_t t0_us)
+{
+    size_t pairs = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        int64_t t_us = t0_us + (int64_t)i * 1000000 / p->fs_hz;
+        /* Blood absorbs: more volume, less light */
+        int32_t v = -ir[i];
+
+        switch (p->state) {
+        case SEARCH_START:
+            p->hyst_min = (ir[i] < 0 ? -ir[i] : ir[i]) >> HYST_START_SHIFT;
+            p->hyst_min += 1;
+            p->hyst = p->hyst_min;
+            p->ext = v;
+            for (size_t k = 0; k < PAT_SLOPE_MAX; k++) {
+                p->hist[k] = v;
+            }
+            p->state = SEARCH_TROUGH;
+            break;
+        case SEARCH_TROUGH:
+            if (v <= p->ext) {
+                /* Lower still, the upstroke starts over */
+                p->ext = v;
+                p->slope = 0;
+                break;
+            }
+            upstroke(p, v, t_us);
+            if (v - p->ext > p->hyst) {
+                p->trough = p->ext;
+                p->ext = v;
+                p->state = SEARCH_PEAK;
+            }
+            break;
+        case SEARCH_PEAK:
+            upstroke(p, v, t_us);
+            if (v >= p->ext) {
+                p->ext = v;
+            } else if (p->ext - v > p->hyst) {
+                int32_t amp = p->ext - p->trough;
+
+                if (p->slope > 0) {
+                    foot(p);
+                    pairs += match(p);
+                }
+                if (p->trough < 0) {
+                    p->hyst_min = (-p->trough >> HYST_MIN_SHIFT) + 1;
+                }
+                /* A third of the pulse skips the dicrotic notch */
+                p->hyst = amp / 3 > p->hyst_min ? amp / 3 : p->hyst_min;
+                p->ext = v;
+                p->slope = 0;
+                p->state = SEARCH_TROUGH;
+            }
+            break;
+        }
+        p->hist[p->hist_pos] = v;
+        p->hist_pos = (uint8_t)((p->hist_pos + 1) % p->span);
+    }
+    return pairs;
+}
+
+void pat_stats_get(const struct pat *p, struct pat_stats *st)
+{
+    memset(st, 0, sizeof(*st));
+    st->pairs = p->pairs;
+    st->r_unpaired = p->r_unpaired;
+    st->feet_unpaired = p->feet_unpaired;
+    st->last_pat_us = p->last_pat_us;
+    st->last_r_us = p->last_r_us;
+    if (p->pat_median.count > PAT_BEATS / 2) {
+        st->pat_us = (uint32_t)median_get(&p->pat_median);
+    }
+}
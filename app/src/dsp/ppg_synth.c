@@ -0,0 +1,132 @@
+#include "dsp/ppg_synth.h"
+#include "dsp/spo2.h"
+
+/* Systolic rise time and the dicrotic wave, position and half width */
+#define RISE_MS          PPG_SYNTH_RISE_MS
+#define DICROTIC_MS      330
+#define DICROTIC_HALF_MS 60
+/* Dicrotic wave and respiratory modulation against the pulse, Q15 */
+#define DICROTIC_Q15     5000
+#define RESP_Q15         9830
+#define RESP_PERIOD_MS   4000
+
+static uint32_t lcg_next(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static void next_beat(struct ppg_synth *s)
+{
+    uint32_t rr = s->rr_ms;
+
+    if (s->rr_jitter_ms > 0) {
+        rr += lcg_next(&s->seed) % (2 * s->rr_jitter_ms + 1);
+        rr -= s->rr_jitter_ms;
+    }
+    s->beat_start += s->beat_len;
+    s->beat_len = rr * s->fs_hz / 1000;
+}
+
+void ppg_synth_init(struct ppg_synth *s, uint32_t fs_hz, uint32_t hr_bpm,
+                    uint32_t seed)
+{
+    s->fs_hz = fs_hz;
+    s->seed = seed;
+    s->rr_ms = 60000 / hr_bpm;
+    s->rr_jitter_ms = s->rr_ms / 20;
+    /* Mid range of an 18 bit sensor ADC */
+    s->dc_red = 90000;
+    s->dc_ir = 120000;
+    s->noise = 8;
+    s->n = 0;
+    s->beat_start = 0;
+    s->beat_len = 0;
+    s->triggered = 0;
+    ppg_synth_set(s, 980, 200);
+    next_beat(s);
+}
+
+void ppg_synth_set(struct ppg_synth *s, uint32_t spo2_dpct, uint32_t pi_cpct)
+{
+    uint32_t r_q16 = spo2_to_ratio(&spo2_curve_default, spo2_dpct);
+
+    s->ac_ir_q16 = (uint32_t)((uint64_t)pi_cpct * 65536 / 10000);
+    s->ac_red_q16 = (uint32_t)((uint64_t)s->ac_ir_q16 * r_q16 >> 16);
+}
+
+void ppg_synth_pulse(struct ppg_synth *s)
+{
+    if (s->n > s->beat_start) {
+        s->beat_len = (uint32_t)(s->n - s->beat_start);
+    }
+    s->beat_start = s->n;
+    s->triggered = 1;
+}
+
+/* Blood volume over the beat in Q15, 0 at the foot and 1 at the peak */
+static int32_t pulse(int32_t pos_ms, int32_t len_ms)
+{
+    int64_t v;
+
+    if (pos_ms < RISE_MS) {
+        /* Smoothstep upstroke */
+        int64_t u = (int64_t)pos_ms * 32768 / RISE_MS;
+
+        return (int32_t)((3 * u * u * 32768 - 2 * u * u * u) >> 30);
+    }
+    /* Quadratic decay to the next foot, with the dicrotic wave on it */
+    v = 32768 - (int64_t)(pos_ms - RISE_MS) * 32768 / (len_ms - RISE_MS);
+    v = v * v >> 15;
+    if (pos_ms > DICROTIC_MS - DICROTIC_HALF_MS &&
+        pos_ms < DICROTIC_MS + DICROTIC_HALF_MS) {
+        int64_t d = pos_ms - DICROTIC_MS;
+        int64_t h = DICROTIC_HALF_MS;
+
+        v += DICROTIC_Q15 * (h * h - d * d) / (h * h);
+    }
+    return (int32_t)v;
+}
+
+static int32_t channel(int32_t dc, uint32_t ac_q16, int32_t vol)
+{
+    /* dc (1 - ac vol) */
+    int64_t depth = (int64_t)ac_q16 * vol >> 15;
+
+    return (int32_t)(dc - ((int64_t)dc * depth >> 16));
+}
+
+void ppg_synth_fill(struct ppg_synth *s, int32_t *red, int32_t *ir, size_t n)
+{
+    for (size_t i = 0; i < n; i++, s->n++) {
+        int32_t pos_ms, len_ms, vol, resp, phase, tri;
+        int32_t half = RESP_PERIOD_MS / 2;
+
+        while (!s->triggered && s->n - s->beat_start >= s->beat_len) {
+            next_beat(s);
+        }
+
+        pos_ms = (int32_t)((s->n - s->beat_start) * 1000 / s->fs_hz);
+        len_ms = (int32_t)((uint64_t)s->beat_len * 1000 / s->fs_hz);
+        /* A late trigger leaves the volume at the foot */
+        if (len_ms <= RISE_MS) {
+            len_ms = RISE_MS + 1;
+        }
+        if (pos_ms > len_ms) {
+            pos_ms = len_ms;
+        }
+
+        /* Triangle wave, as the baseline wander of the synthetic ECG */
+        phase = (int32_t)(s->n * 1000 / s->fs_hz % RESP_PERIOD_MS);
+        tri = phase < half ? phase : RESP_PERIOD_MS - phase;
+        resp = RESP_Q15 * (2 * tri - half) / half;
+        /* Venous volume moves with respiration, as a share of the pulse */
+        vol = pulse(pos_ms, len_ms) + resp;
+
+        red[i] = channel(s->dc_red, s->ac_red_q16, vol) +
+                 (int32_t)(lcg_next(&s->seed) % (2 * s->noise + 1)) -
+                 s->noise;
+        ir[i] = channel(s->dc_ir, s->ac_ir_q16, vol) +
+                (int32_t)(lcg_next(&s->seed) % (2 * s->noise + 1)) - s->noise;
+    }
+}
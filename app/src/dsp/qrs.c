@@ -0,0 +1,136 @@
+#include <string.h>
+
+#include "dsp/qrs.h"
+
+#define QRS_HP_HZ        5.0
+#define QRS_LP_HZ        15.0
+#define QRS_REFRACTORY_MS 200
+#define QRS_LEARN_MS      2000
+
+void qrs_init(struct qrs *q, uint32_t fs_hz)
+{
+    struct biquad_coeffs c;
+
+    memset(q, 0, sizeof(*q));
+    q->fs_hz = fs_hz;
+    q->win = fs_hz * 150 / 1000;
+    if (q->win > QRS_MWI_MAX) {
+        q->win = QRS_MWI_MAX;
+    }
+    if (q->win == 0) {
+        q->win = 1;
+    }
+
+    sliding_init(&q->peak, q->peak_buf, q->win);
+
+    biquad_highpass(&c, fs_hz, QRS_HP_HZ);
+    biquad_init(&q->hp, &c);
+    biquad_lowpass(&c, fs_hz, QRS_LP_HZ);
+    biquad_init(&q->lp, &c);
+}
+
+static void update_threshold(struct qrs *q)
+{
+    q->threshold = q->npki + (q->spki - q->npki) / 4;
+}
+
+/*
+ * Sample index of the largest input magnitude in the window. The band-pass
+ * delays the integral by tens of milliseconds, the input does not.
+ */
+static uint64_t locate_r(const struct qrs *q)
+{
+    return q->n - sliding_max_age(&q->peak);
+}
+
+static int peak_end(struct qrs *q, uint64_t *beat)
+{
+    const uint64_t refractory = (uint64_t)q->fs_hz * QRS_REFRACTORY_MS / 1000;
+
+    if (q->have_beat && q->peak_r < q->last_beat + refractory) {
+        /* T wave or noise inside the refractory period */
+        q->npki = q->npki - q->npki / 8 + q->peak_mwi / 8;
+        update_threshold(q);
+        return 0;
+    }
+
+    q->spki = q->spki - q->spki / 8 + q->peak_mwi / 8;
+    update_threshold(q);
+    q->last_beat = q->peak_r;
+    q->have_beat = 1;
+    *beat = q->peak_r;
+    return 1;
+}
+
+size_t qrs_process(struct qrs *q, const int32_t *x, size_t n,
+                   uint64_t *beats, size_t max_beats)
+{
+    const uint64_t learn = (uint64_t)q->fs_hz * QRS_LEARN_MS / 1000;
+    size_t found = 0;
+
+    for (size_t i = 0; i < n;
+         i++, q->n++, q->pos = q->pos + 1 == q->win ? 0 : q->pos + 1) {
+        int32_t s = x[i];
+        int32_t d;
+        uint32_t sq;
+        uint32_t mwi;
+
+        biquad_process(&q->hp, &s, 1);
+        biquad_process(&q->lp, &s, 1);
+
+        /* y = (2x[n] + x[n-1] - x[n-3] - 2x[n-4]) / 8 */
+        d = (2 * s + q->d[0] - q->d[2] - 2 * q->d[3]) / 8;
+        q->d[3] = q->d[2];
+        q->d[2] = q->d[1];
+        q->d[1] = q->d[0];
+        q->d[0] = s;
+
+        sq = (uint32_t)((int64_t)d * d > UINT32_MAX ? UINT32_MAX
+                                                     : (int64_t)d * d);
+        q->sq_sum += sq;
+        q->sq_sum -= q->sq[q->pos];
+        q->sq[q->pos] = sq;
+        sliding_add(&q->peak, x[i] < 0 ? -x[i] : x[i]);
+        mwi = (uint32_t)(q->sq_sum / q->win);
+
+        if (q->n < learn) {
+            q->learn_max = mwi > q->learn_max ? mwi : q->learn_max;
+            q->learn_sum += mwi;
+            if (q->n + 1 == learn) {
+                q->spki = q->learn_max / 3;
+                q->npki = (uint32_t)(q->learn_sum / learn / 2);
+                update_threshold(q);
+            }
+            q->mwi_prev = mwi;
+            continue;
+        }
+
+        if (!q->in_peak) {
+            if (mwi > q->threshold) {
+                q->in_peak = 1;
+                q->peak_mwi = 0;
+            } else if (q->rising && mwi < q->mwi_prev) {
+                /* Local maximum below threshold: noise peak */
+                q->npki = q->npki - q->npki / 8 + q->mwi_prev / 8;
+                update_threshold(q);
+            }
+        }
+        if (q->in_peak) {
+            if (mwi >= q->peak_mwi) {
+                q->peak_mwi = mwi;
+                q->peak_r = locate_r(q);
+            } else if (mwi < q->peak_mwi / 2) {
+                uint64_t beat;
+
+                q->in_peak = 0;
+                if (peak_end(q, &beat) && found < max_beats) {
+                    beats[found++] = beat;
+                }
+            }
+        }
+
+        q->rising = mwi > q->mwi_prev;
+        q->mwi_prev = mwi;
+    }
+    return found;
+}
@@ -0,0 +1,83 @@
+#include "dsp/sliding.h"
+
+int sliding_init(struct sliding *s, uint32_t *storage, size_t n)
+{
+    if (n == 0 || n > SLIDING_MAX_WINDOW) {
+        return -1;
+    }
+    s->ring = (int32_t *)storage;
+    s->maxq = (uint16_t *)(storage + n);
+    s->minq = s->maxq + n;
+    s->size = (uint16_t)n;
+    s->count = 0;
+    s->pos = 0;
+    s->max_head = 0;
+    s->max_len = 0;
+    s->min_head = 0;
+    s->min_len = 0;
+    s->sum = 0;
+    s->sum_sq = 0;
+    return 0;
+}
+
+/* Deque slot @p i <= size places from the head, without a division */
+static uint16_t at(const struct sliding *s, uint16_t head, uint32_t i)
+{
+    i += head;
+    return (uint16_t)(i >= s->size ? i - s->size : i);
+}
+
+void sliding_add(struct sliding *s, int32_t x)
+{
+    const uint16_t p = s->pos;
+
+    if (s->count == s->size) {
+        int32_t old = s->ring[p];
+
+        s->sum -= old;
+        s->sum_sq -= (uint64_t)((int64_t)old * old);
+        /* Only a front can be the oldest sample */
+        if (s->maxq[s->max_head] == p) {
+            s->max_head = at(s, s->max_head, 1);
+            s->max_len--;
+        }
+        if (s->minq[s->min_head] == p) {
+            s->min_head = at(s, s->min_head, 1);
+            s->min_len--;
+        }
+    } else {
+        s->count++;
+    }
+
+    s->ring[p] = x;
+    s->sum += x;
+    s->sum_sq += (uint64_t)((int64_t)x * x);
+
+    /* Strict comparisons keep the oldest of equal samples at the front */
+    while (s->max_len > 0 &&
+           s->ring[s->maxq[at(s, s->max_head, s->max_len - 1u)]] < x) {
+        s->max_len--;
+    }
+    s->maxq[at(s, s->max_head, s->max_len++)] = p;
+    while (s->min_len > 0 &&
+           s->ring[s->minq[at(s, s->min_head, s->min_len - 1u)]] > x) {
+        s->min_len--;
+    }
+    s->minq[at(s, s->min_head, s->min_len++)] = p;
+
+    s->pos = p + 1u == s->size ? 0 : (uint16_t)(p + 1u);
+}
+
+uint64_t sliding_var(const struct sliding *s)
+{
+    /*
+     * (sum_sq - sum^2 / n) / n with sum = q n + r, so that no term
+     * overflows: sum^2 / n = q sum + q r + r^2 / n.
+     */
+    int64_t n = s->count;
+    int64_t q = s->sum / n;
+    int64_t r = s->sum - q * n;
+    int64_t v = ((int64_t)s->sum_sq - q * s->sum - q * r - r * r / n) / n;
+
+    return v > 0 ? (uint64_t)v : 0;
+}
@@ -0,0 +1,29 @@
+#include "dsp/soa.h"
+
+void soa_unpack_s24be(const uint8_t *in, size_t n, size_t leads, int32_t *out,
+                      size_t stride)
+{
+    for (size_t i = 0; i < n; i++) {
+        for (size_t l = 0; l < leads; l++, in += 3) {
+            /* Sign extend through the top byte of a 32 bit word */
+            uint32_t v = (uint32_t)in[0] << 24 | (uint32_t)in[1] << 16 |
+                         (uint32_t)in[2] << 8;
+
+            out[l * stride + i] = (int32_t)v >> 8;
+        }
+    }
+}
+
+void soa_pack_s24be(const int32_t *in, size_t n, size_t leads, size_t stride,
+                    uint8_t *out)
+{
+    for (size_t i = 0; i < n; i++) {
+        for (size_t l = 0; l < leads; l++, out += 3) {
+            uint32_t v = (uint32_t)in[l * stride + i];
+
+            out[0] = (uint8_t)(v >> 16);
+            out[1] = (uint8_t)(v >> 8);
+            out[2] = (uint8_t)v;
+        }
+    }
+}
@@ -0,0 +1,269 @@
+#include <string.h>
+
+#include "dsp/spectrum.h"
+
+#ifdef CONFIG_APP_SPECTRUM_TWIDDLE_RAM
+#define TWIDDLE_STORAGE
+#else
+#define TWIDDLE_STORAGE const
+#endif
+
+#ifndef CONFIG_APP_SPECTRUM_CMSIS
+/* Angle steps of 2 pi / SPECTRUM_MAX_N, and table entries */
+#define TW_TURN    SPECTRUM_MAX_N
+#define TW_ENTRIES (3 * TW_TURN / 4)
+
+/* cos and sin of 2 pi k / SPECTRUM_MAX_N in Q31, k below 3/4 turn */
+static TWIDDLE_STORAGE int32_t twiddle[2 * TW_ENTRIES] = {
+#include "spectrum_twiddle.inc"
+};
+#endif
+
+/* Largest |x| brought just below 2^30, leaving a bit for the first sums */
+static int normalise(int32_t *x, uint32_t n)
+{
+    uint32_t peak = 0;
+    int shift = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        /* Magnitude, with INT32_MIN as 2^31 */
+        peak |= x[i] < 0 ? 0u - (uint32_t)x[i] : (uint32_t)x[i];
+    }
+    if (peak == 0) {
+        return 0;
+    }
+    while ((peak << shift) < (1u << 29)) {
+        shift++;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        x[i] = (int32_t)((uint32_t)x[i] << shift);
+    }
+    return shift;
+}
+
+int spectrum_init(struct spectrum *s, uint32_t n)
+{
+    memset(s, 0, sizeof(*s));
+    if (n < SPECTRUM_MIN_N || n > SPECTRUM_MAX_N || (n & (n - 1)) != 0) {
+        return -1;
+    }
+    s->n = n;
+    while ((1u << s->log2n) < n) {
+        s->log2n++;
+    }
+#ifdef CONFIG_APP_SPECTRUM_CMSIS
+    if (arm_rfft_init_q31(&s->rfft, n, 0, 1) != ARM_MATH_SUCCESS) {
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+#ifdef CONFIG_APP_SPECTRUM_CMSIS
+
+/* cos(2 pi i / n) */
+static int32_t cos_turn(const struct spectrum *s, uint32_t i)
+{
+    return arm_cos_q31((q31_t)(i << (31 - s->log2n)));
+}
+
+/*
+ * arm_rfft_q31 documents its output format as (log2 n).(32 - log2 n) for
+ * 1.31 input, e.g. 5.27 for n = 32: the DFT scaled by 2 / n, not 1 / n.
+ * The same words read with one more fractional bit are the DFT / n.
+ */
+#define CMSIS_RFFT_SHIFT 1
+
+int spectrum_rfft(const struct spectrum *s, int32_t *buf)
+{
+    int shift = normalise(buf, s->n);
+
+    arm_rfft_q31(&s->rfft, buf, buf + s->n);
+    /* Bins 0 to n / 2 of the full spectrum */
+    memmove(buf, buf + s->n, (s->n + 2) * sizeof(*buf));
+    return shift + CMSIS_RFFT_SHIFT;
+}
+
+#else
+
+static int32_t cos_turn(const struct spectrum *s, uint32_t i)
+{
+    uint32_t k = i * (TW_TURN / s->n);
+
+    /* The table ends at 3/4 turn, the window is symmetric */
+    if (k > TW_TURN / 2) {
+        k = TW_TURN - k;
+    }
+    return twiddle[2 * k];
+}
+
+/* (re, im) * (c - j s) in Q31, the forward twiddle */
+static void rotate(int32_t *re, int32_t *im, const int32_t *w)
+{
+    int64_t c = w[0], sn = w[1];
+    int64_t r = *re, i = *im;
+
+    *re = (int32_t)((r * c + i * sn) >> 31);
+    *im = (int32_t)((i * c - r * sn) >> 31);
+}
+
+/*
+ * Decimation in frequency, radix 4 with the middle outputs of every
+ * butterfly swapped (radix 2^2), so that the result is in plain bit
+ * reversed order and an odd power of two only needs a last radix 2
+ * stage. Every stage divides by its radix.
+ */
+static void cfft(int32_t *x, uint32_t len)
+{
+    uint32_t n2;
+
+    for (n2 = len; n2 >= 4; n2 /= 4) {
+        const uint32_t n4 = n2 / 4;
+        const uint32_t stride = TW_TURN / n2;
+
+        for (uint32_t j = 0; j < n4; j++) {
+            const int32_t *w1 = &twiddle[2 * (j * stride)];
+            const int32_t *w2 = &twiddle[2 * (2 * j * stride)];
+            const int32_t *w3 = &twiddle[2 * (3 * j * stride)];
+
+            for (uint32_t i = j; i < len; i += n2) {
+                int32_t *a = &x[2 * i];
+                int32_t *b = &x[2 * (i + n4)];
+                int32_t *c = &x[2 * (i + 2 * n4)];
+                int32_t *d = &x[2 * (i + 3 * n4)];
+                int32_t t0r = (a[0] >> 2) + (c[0] >> 2);
+                int32_t t0i = (a[1] >> 2) + (c[1] >> 2);
+                int32_t t1r = (a[0] >> 2) - (c[0] >> 2);
+                int32_t t1i = (a[1] >> 2) - (c[1] >> 2);
+                int32_t t2r = (b[0] >> 2) + (d[0] >> 2);
+                int32_t t2i = (b[1] >> 2) + (d[1] >> 2);
+                int32_t t3r = (b[0] >> 2) - (d[0] >> 2);
+                int32_t t3i = (b[1] >> 2) - (d[1] >> 2);
+                /* y1 = t1 - j t3, y2 = t0 - t2, y3 = t1 + j t3 */
+                int32_t y1r = t1r + t3i, y1i = t1i - t3r;
+                int32_t y2r = t0r - t2r, y2i = t0i - t2i;
+                int32_t y3r = t1r - t3i, y3i = t1i + t3r;
+
+                a[0] = t0r + t2r;
+                a[1] = t0i + t2i;
+                if (j != 0) {
+                    rotate(&y1r, &y1i, w1);
+                    rotate(&y2r, &y2i, w2);
+                    rotate(&y3r, &y3i, w3);
+                }
+                b[0] = y2r;
+                b[1] = y2i;
+                c[0] = y1r;
+                c[1] = y1i;
+                d[0] = y3r;
+                d[1] = y3i;
+            }
+        }
+    }
+    if (n2 == 2) {
+        for (uint32_t i = 0; i < len; i += 2) {
+            int32_t *a = &x[2 * i], *b = &x[2 * i + 2];
+            int32_t ar = a[0] >> 1, ai = a[1] >> 1;
+            int32_t br = b[0] >> 1, bi = b[1] >> 1;
+
+            a[0] = ar + br;
+            a[1] = ai + bi;
+            b[0] = ar - br;
+            b[1] = ai - bi;
+        }
+    }
+
+    for (uint32_t i = 0, r = 0; i < len; i++) {
+        uint32_t bit = len >> 1;
+
+        if (r > i) {
+            int32_t tr = x[2 * i], ti = x[2 * i + 1];
+
+            x[2 * i] = x[2 * r];
+            x[2 * i + 1] = x[2 * r + 1];
+            x[2 * r] = tr;
+            x[2 * r + 1] = ti;
+        }
+        /* Count r up in bit reversed order */
+        while (r & bit) {
+            r ^= bit;
+            bit >>= 1;
+        }
+        r |= bit;
+    }
+}
+
+/*
+ * The n real samples are transformed as n / 2 complex ones, even samples
+ * real and odd imaginary, and the two interleaved spectra separated:
+ * X[k] = (Z[k] + Z*[L-k]) / 2 - j W^k (Z[k] - Z*[L-k]) / 2, halved once
+ * more to scale by 1 / n.
+ */
+int spectrum_rfft(const struct spectrum *s, int32_t *buf)
+{
+    const uint32_t len = s->n / 2;
+    const uint32_t stride = TW_TURN / s->n;
+    int shift = normalise(buf, s->n);
+    int32_t z0r, z0i;
+
+    cfft(buf, len);
+
+    z0r = buf[0] >> 1;
+    z0i = buf[1] >> 1;
+    buf[0] = z0r + z0i;
+    buf[1] = 0;
+    buf[2 * len] = z0r - z0i;
+    buf[2 * len + 1] = 0;
+
+    for (uint32_t k = 1; k <= len / 2; k++) {
+        int32_t *p = &buf[2 * k], *q = &buf[2 * (len - k)];
+        /* Sum and difference of Z[k] and conj(Z[L-k]), both halved */
+        int32_t sr = (p[0] >> 2) + (q[0] >> 2);
+        int32_t si = (p[1] >> 2) - (q[1] >> 2);
+        int32_t dr = (p[0] >> 2) - (q[0] >> 2);
+        int32_t di = (p[1] >> 2) + (q[1] >> 2);
+        /* -j d, then W^k */
+        int32_t er = di, ei = -dr;
+        int32_t fr, fi;
+
+        rotate(&er, &ei, &twiddle[2 * (k * stride)]);
+        /* X[L-k] = conj(S - E) as W^(L-k) = -W^-k */
+        fr = sr - er;
+        fi = -(si - ei);
+        p[0] = sr + er;
+        p[1] = si + ei;
+        q[0] = fr;
+        q[1] = fi;
+    }
+    return shift;
+}
+
+#endif
+
+void spectrum_hann(const struct spectrum *s, int32_t *x)
+{
+    for (uint32_t i = 0; i < s->n; i++) {
+        /* (1 - cos) / 2 in Q31 */
+        int64_t w = ((int64_t)INT32_MAX - cos_turn(s, i)) >> 1;
+
+        x[i] = (int32_t)((x[i] * w) >> 31);
+    }
+}
+
+void spectrum_power(const struct spectrum *s, int32_t *buf, uint64_t *power)
+{
+    int shift = spectrum_rfft(s, buf);
+    /* |X|^2 carries 2 shift fractional bits, keep SPECTRUM_POWER_FRAC */
+    int down = 2 * shift - SPECTRUM_POWER_FRAC;
+
+    for (uint32_t k = 0; k <= s->n / 2; k++) {
+        int64_t re = buf[2 * k], im = buf[2 * k + 1];
+        uint64_t p = (uint64_t)(re * re) + (uint64_t)(im * im);
+
+        if (down >= 0) {
+            power[k] = p >> down;
+        } else {
+            power[k] = p > UINT64_MAX >> -down ? UINT64_MAX : p << -down;
+        }
+    }
+}
@@ -0,0 +1,232 @@
+#include <string.h>
+
+#include "dsp/spo2.h"
+
+/* States of the extreme search on the infrared channel */
+#define SEARCH_START  0
+#define SEARCH_TROUGH 1
+#define SEARCH_PEAK   2
+
+/*
+ * Hysteresis before the first pulse and its floor as a share of DC,
+ * 1/4096 and 1/8192: below SPO2_PI_MIN_CPCT, above the sensor noise.
+ */
+#define HYST_START_SHIFT 12
+#define HYST_MIN_SHIFT   13
+
+static const struct spo2_point default_points[] = {
+    {26214, 1000},  {32768, 990},  {39322, 970},  {45875, 945},
+    {52429, 915},   {58982, 880},  {65536, 845},  {78643, 775},
+    {91750, 705},   {104858, 635}, {117965, 565}, {131072, 500},
+};
+
+const struct spo2_curve spo2_curve_default = {
+    .points = default_points,
+    .count = sizeof(default_points) / sizeof(default_points[0]),
+};
+
+int spo2_init(struct spo2 *o, uint32_t fs_hz, const struct spo2_curve *curve)
+{
+    memset(o, 0, sizeof(*o));
+    o->fs_hz = fs_hz;
+    o->curve = curve != NULL ? curve : &spo2_curve_default;
+    if (o->curve->count < 2) {
+        return -1;
+    }
+    median_init(&o->r_median, o->r_buf, SPO2_BEATS);
+    median_init(&o->pi_median, o->pi_buf, SPO2_BEATS);
+    median_init(&o->period_median, o->period_buf, SPO2_BEATS);
+    return 0;
+}
+
+/* Pulse height over the line between the troughs at either side */
+static int32_t pulse_ac(const struct spo2_channel *c, int32_t next_trough,
+                        uint64_t rise, uint64_t period)
+{
+    int64_t base = c->trough +
+                   ((int64_t)next_trough - c->trough) * (int64_t)rise /
+                       (int64_t)period;
+
+    return (int32_t)(c->peak - base);
+}
+
+/* AC over DC in Q32, 0 unless 0 < AC < DC */
+static uint64_t perfusion_q32(int32_t ac, int64_t dc)
+{
+    if (ac <= 0 || dc <= ac) {
+        return 0;
+    }
+    return ((uint64_t)ac << 32) / (uint64_t)dc;
+}
+
+/* The next trough completes a beat started by the previous one */
+static void beat_end(struct spo2 *o, int32_t next_ir, int32_t next_red)
+{
+    uint64_t period = o->ext_n - o->trough_n;
+    uint64_t rise = o->peak_n - o->trough_n;
+    uint32_t period_ms = (uint32_t)(period * 1000 / o->fs_hz);
+    int64_t dc_ir = o->ir.sum / o->sum_count;
+    int64_t dc_red = o->red.sum / o->sum_count;
+    uint64_t p_ir = perfusion_q32(pulse_ac(&o->ir, next_ir, rise, period),
+                                  dc_ir);
+    uint64_t p_red = perfusion_q32(pulse_ac(&o->red, next_red, rise, period),
+                                   dc_red);
+    uint32_t pi_cpct = (uint32_t)((p_ir * 10000) >> 32);
+    uint64_t r_q16;
+
+    if (dc_ir > 0) {
+        o->hyst_min = (int32_t)(dc_ir >> HYST_MIN_SHIFT) + 1;
+    }
+    if (period_ms < SPO2_PERIOD_MIN_MS || period_ms > SPO2_PERIOD_MAX_MS ||
+        p_ir == 0 || p_red == 0 || pi_cpct < SPO2_PI_MIN_CPCT ||
+        pi_cpct > SPO2_PI_MAX_CPCT) {
+        o->rejected++;
+        return;
+    }
+
+    /* Red below 2^32 and infrared above SPO2_PI_MIN_CPCT: R fits */
+    r_q16 = (p_red << 16) / p_ir;
+    o->beats++;
+    o->last_period_ms = period_ms;
+    median_add(&o->r_median, r_q16 > INT32_MAX ? INT32_MAX : (int32_t)r_q16);
+    median_add(&o->pi_median, (int32_t)pi_cpct);
+    median_add(&o->period_median, (int32_t)period_ms);
+}
+
+/* Infrared trough confirmed at ext_n */
+static size_t trough_found(struct spo2 *o)
+{
+    size_t beats = 0;
+
+    if (o->have_trough && o->have_peak && o->sum_count > 0) {
+        beat_end(o, o->ext_ir, o->ext_red);
+        beats = 1;
+    }
+    o->ir.trough = o->ext_ir;
+    o->red.trough = o->ext_red;
+    o->trough_n = o->ext_n;
+    o->have_trough = 1;
+    o->have_peak = 0;
+    o->ir.sum = 0;
+    o->red.sum = 0;
+    o->sum_count = 0;
+    return beats;
+}
+
+static void peak_found(struct spo2 *o)
+{
+    o->ir.peak = o->ext_ir;
+    o->red.peak = o->ext_red;
+    o->peak_n = o->ext_n;
+    o->have_peak = o->have_trough;
+    if (o->have_trough) {
+        /* A third of the pulse skips the dicrotic notch */
+        int32_t amp = o->ir.peak - o->ir.trough;
+
+        o->hyst = amp / 3 > o->hyst_min ? amp / 3 : o->hyst_min;
+    }
+}
+
+size_t spo2_process(struct spo2 *o, const int32_t *red, const int32_t *ir,
+                    size_t n)
+{
+    size_t beats = 0;
+
+    for (size_t i = 0; i < n; i++, o->n++) {
+        /* Blood absorbs: more volume, less light */
+        int32_t v_ir = -ir[i];
+        int32_t v_red = -red[i];
+
+        o->ir.sum += ir[i];
+        o->red.sum += red[i];
+        o->sum_count++;
+
+        switch (o->state) {
+        case SEARCH_START:
+            o->hyst_min = (ir[i] < 0 ? -ir[i] : ir[i]) >> HYST_START_SHIFT;
+            o->hyst_min += 1;
+            o->hyst = o->hyst_min;
+            o->state = SEARCH_TROUGH;
+            break;
+        case SEARCH_TROUGH:
+            if (v_ir <= o->ext_ir) {
+                break;
+            }
+            if (v_ir - o->ext_ir > o->hyst) {
+                beats += trough_found(o);
+                o->state = SEARCH_PEAK;
+                break;
+            }
+            continue;
+        case SEARCH_PEAK:
+            if (v_ir >= o->ext_ir) {
+                break;
+            }
+            if (o->ext_ir - v_ir > o->hyst) {
+                peak_found(o);
+                o->state = SEARCH_TROUGH;
+                break;
+            }
+            continue;
+        }
+        /* A new extreme, or the first sample of the next search */
+        o->ext_ir = v_ir;
+        o->ext_red = v_red;
+        o->ext_n = o->n;
+    }
+    return beats;
+}
+
+void spo2_stats_get(const struct spo2 *o, struct spo2_stats *st)
+{
+    memset(st, 0, sizeof(*st));
+    st->beats = o->beats;
+    st->rejected = o->rejected;
+    if (o->r_median.count <= SPO2_BEATS / 2) {
+        return;
+    }
+    st->r_q16 = (uint32_t)median_get(&o->r_median);
+    st->spo2_dpct = spo2_from_ratio(o->curve, st->r_q16);
+    st->pi_cpct = (uint32_t)median_get(&o->pi_median);
+    st->pr_dbpm = 600000 / (uint32_t)median_get(&o->period_median);
+}
+
+uint32_t spo2_from_ratio(const struct spo2_curve *curve, uint32_t r_q16)
+{
+    const struct spo2_point *p = curve->points;
+    size_t i = 1;
+
+    if (r_q16 <= p[0].r_q16) {
+        return p[0].spo2_dpct;
+    }
+    while (i < curve->count - 1 && r_q16 > p[i].r_q16) {
+        i++;
+    }
+    if (r_q16 >= p[i].r_q16) {
+        return p[i].spo2_dpct;
+    }
+    return p[i - 1].spo2_dpct -
+           (uint32_t)((uint64_t)(p[i - 1].spo2_dpct - p[i].spo2_dpct) *
+                      (r_q16 - p[i - 1].r_q16) /
+                      (p[i].r_q16 - p[i - 1].r_q16));
+}
+
+uint32_t spo2_to_ratio(const struct spo2_curve *curve, uint32_t spo2_dpct)
+{
+    const struct spo2_point *p = curve->points;
+    size_t i = 1;
+
+    if (spo2_dpct >= p[0].spo2_dpct) {
+        return p[0].r_q16;
+    }
+    while (i < curve->count - 1 && spo2_dpct < p[i].spo2_dpct) {
+        i++;
+    }
+    if (spo2_dpct <= p[i].spo2_dpct) {
+        return p[i].r_q16;
+    }
+    return p[i - 1].r_q16 +
+           (uint32_t)((uint64_t)(p[i].r_q16 - p[i - 1].r_q16) *
+                      (p[i - 1].spo2_dpct - spo2_dpct) /
+                      (p[i - 1].spo2_dpct - p[i].spo2_dpct));
+}
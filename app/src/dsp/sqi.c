@@ -0,0 +1,67 @@
+#include <string.h>
+
+#include "dsp/sqi.h"
+
+int sqi_init(struct sqi *q, size_t blocks, int32_t rail_uv,
+             uint32_t *storage, size_t words)
+{
+    memset(q, 0, sizeof(*q));
+    if (words < SQI_WORDS(blocks) ||
+        sliding_init(&q->hi, storage, blocks) != 0 ||
+        sliding_init(&q->lo, storage + SLIDING_WORDS(blocks), blocks) != 0 ||
+        sliding_init(&q->noise, storage + 2 * SLIDING_WORDS(blocks),
+                     blocks) != 0) {
+        return -1;
+    }
+    /* Calibration moves the clipped level a little off the rail */
+    q->rail_uv = rail_uv - rail_uv / 64;
+    return 0;
+}
+
+enum sqi_state sqi_block(struct sqi *q, const int32_t *x, size_t n)
+{
+    int32_t mn = x[0], mx = x[0];
+    int32_t prev = q->noise.count > 0 ? q->last : x[0];
+    int64_t diff = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        int32_t d = x[i] - prev;
+
+        mn = x[i] < mn ? x[i] : mn;
+        mx = x[i] > mx ? x[i] : mx;
+        diff += d < 0 ? -d : d;
+        prev = x[i];
+    }
+    q->last = prev;
+
+    sliding_add(&q->hi, mx);
+    sliding_add(&q->lo, mn);
+    sliding_add(&q->noise, (int32_t)(diff / (int64_t)n));
+
+    if (sliding_max(&q->hi) >= q->rail_uv ||
+        sliding_min(&q->lo) <= -q->rail_uv) {
+        q->state = SQI_SATURATED;
+    } else if (sliding_max(&q->hi) - sliding_min(&q->lo) < SQI_FLAT_UV) {
+        q->state = SQI_FLAT;
+    } else if (sliding_min(&q->noise) > SQI_NOISE_UV) {
+        q->state = SQI_NOISY;
+    } else {
+        q->state = SQI_GOOD;
+    }
+    q->blocks[q->state]++;
+    return (enum sqi_state)q->state;
+}
+
+void sqi_stats_get(struct sqi *q, struct sqi_stats *st, int reset)
+{
+    memcpy(st->blocks, q->blocks, sizeof(st->blocks));
+    st->p2p_uv = 0;
+    st->noise_uv = 0;
+    if (q->noise.count > 0) {
+        st->p2p_uv = sliding_max(&q->hi) - sliding_min(&q->lo);
+        st->noise_uv = sliding_min(&q->noise);
+    }
+    if (reset) {
+        memset(q->blocks, 0, sizeof(q->blocks));
+    }
+}
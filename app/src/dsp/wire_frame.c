@@ -0,0 +1,105 @@
+#include <string.h>
+
+#include "dsp/wire_frame.h"
+
+uint16_t wire_crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        /* Byte-wise CCITT without a table */
+        uint16_t x = (uint16_t)((crc >> 8) ^ data[i]);
+
+        x ^= x >> 4;
+        crc = (uint16_t)((crc << 8) ^ (x << 12) ^ (x << 5) ^ x);
+    }
+    return crc;
+}
+
+void wire_frame_hdr(uint8_t hdr[WIRE_HDR_SIZE], uint8_t type, uint8_t src,
+                    uint16_t len)
+{
+    hdr[0] = WIRE_SYNC0;
+    hdr[1] = WIRE_SYNC1;
+    hdr[2] = type;
+    hdr[3] = src;
+    hdr[4] = (uint8_t)len;
+    hdr[5] = (uint8_t)(len >> 8);
+}
+
+void wire_frame_crc(uint8_t crc[WIRE_CRC_SIZE],
+                    const uint8_t hdr[WIRE_HDR_SIZE], const uint8_t *payload,
+                    uint16_t len)
+{
+    uint16_t c = wire_crc16(0xFFFF, &hdr[2], WIRE_HDR_SIZE - 2);
+
+    c = wire_crc16(c, payload, len);
+    crc[0] = (uint8_t)c;
+    crc[1] = (uint8_t)(c >> 8);
+}
+
+size_t wire_frame_encode(uint8_t type, uint8_t src, const uint8_t *payload,
+                         uint16_t len, uint8_t *out, size_t cap)
+{
+    if (cap < WIRE_FRAME_SIZE(len)) {
+        return 0;
+    }
+    wire_frame_hdr(out, type, src, len);
+    memcpy(&out[WIRE_HDR_SIZE], payload, len);
+    wire_frame_crc(&out[WIRE_HDR_SIZE + len], out, payload, len);
+    return WIRE_FRAME_SIZE(len);
+}
+
+void wire_parser_init(struct wire_parser *p)
+{
+    memset(p, 0, sizeof(*p));
+}
+
+int wire_parser_feed(struct wire_parser *p, uint8_t byte)
+{
+    uint8_t crc[WIRE_CRC_SIZE];
+
+    if (p->pos < WIRE_HDR_SIZE) {
+        if ((p->pos == 0 && byte != WIRE_SYNC0) ||
+            (p->pos == 1 && byte != WIRE_SYNC1)) {
+            p->skipped += p->pos + 1;
+            /* A stray 0xA5 may still start the next frame */
+            p->pos = byte == WIRE_SYNC0 ? 1 : 0;
+            p->skipped -= p->pos;
+            if (p->pos == 1) {
+                p->hdr[0] = byte;
+            }
+            return 0;
+        }
+        p->hdr[p->pos++] = byte;
+        if (p->pos == WIRE_HDR_SIZE) {
+            p->len = (uint16_t)(p->hdr[4] | p->hdr[5] << 8);
+            if (p->len > WIRE_PAYLOAD_MAX) {
+                /* Cannot be a frame, look for sync again */
+                p->skipped += WIRE_HDR_SIZE;
+                p->pos = 0;
+            }
+        }
+        return 0;
+    }
+
+    if (p->pos < (size_t)WIRE_HDR_SIZE + p->len) {
+        p->payload[p->pos++ - WIRE_HDR_SIZE] = byte;
+        return 0;
+    }
+
+    p->crc[p->pos++ - WIRE_HDR_SIZE - p->len] = byte;
+    if (p->pos < WIRE_FRAME_SIZE(p->len)) {
+        return 0;
+    }
+
+    p->pos = 0;
+    wire_frame_crc(crc, p->hdr, p->payload, p->len);
+    if (memcmp(crc, p->crc, sizeof(crc)) != 0) {
+        p->crc_errors++;
+        return 0;
+    }
+    p->type = p->hdr[2];
+    p->src = p->hdr[3];
+    p->payload_len = p->len;
+    p->frames++;
+    return 1;
+}
@@ -0,0 +1,201 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/zbus/zbus.h>
+
+#include "dsp/hr_fusion.h"
+#include "fusion.h"
+#include "ppg.h"
+#include "timebase.h"
+
+LOG_MODULE_REGISTER(fusion, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define FUSION_STACK_SIZE 1024
+#define FUSION_PRIORITY   K_PRIO_PREEMPT(4)
+
+/* The subscriber copies every message into a buffer of the static pool */
+BUILD_ASSERT(sizeof(struct fusion_beat) <=
+             CONFIG_ZBUS_MSG_SUBSCRIBER_NET_BUF_STATIC_DATA_SIZE);
+BUILD_ASSERT(sizeof(struct fusion_motion) <=
+             CONFIG_ZBUS_MSG_SUBSCRIBER_NET_BUF_STATIC_DATA_SIZE);
+
+ZBUS_MSG_SUBSCRIBER_DEFINE(fusion_sub);
+
+ZBUS_CHAN_DEFINE(fusion_ecg_chan, struct fusion_beat, NULL, NULL,
+                 ZBUS_OBSERVERS(fusion_sub), ZBUS_MSG_INIT(0));
+ZBUS_CHAN_DEFINE(fusion_ppg_chan, struct fusion_beat, NULL, NULL,
+                 ZBUS_OBSERVERS(fusion_sub), ZBUS_MSG_INIT(0));
+ZBUS_CHAN_DEFINE(fusion_motion_chan, struct fusion_motion, NULL, NULL,
+                 ZBUS_OBSERVERS(fusion_sub), ZBUS_MSG_INIT(0));
+ZBUS_CHAN_DEFINE(fusion_hr_chan, struct fusion_hr, NULL, NULL,
+                 ZBUS_OBSERVERS_EMPTY, ZBUS_MSG_INIT(0));
+
+/*
+ * Emulated accelerometer: activity once a second, at rest with a walk of
+ * two minutes every ten.
+ */
+#define MOTION_CYCLE_S 600
+#define MOTION_WALK_S  120
+#define MOTION_REST_MG 20
+#define MOTION_WALK_MG 250
+
+static struct hr_fusion fusion;
+static atomic_t dropped;
+
+/* Since when the ECG has been reliable, INT64_MAX while it is not */
+static int64_t ecg_reliable_us = INT64_MAX;
+static bool ppg_on = true;
+
+static struct k_spinlock lock;
+static struct fusion_stats snapshot;
+
+static void publish(const struct zbus_channel *chan, const void *msg)
+{
+    if (zbus_chan_pub(chan, msg, K_NO_WAIT) != 0) {
+        atomic_inc(&dropped);
+    }
+}
+
+static void motion_expiry(struct k_timer *timer)
+{
+    struct fusion_motion m = {
+        .t_us = timebase_now_us(),
+    };
+    uint32_t s = (uint32_t)(m.t_us / USEC_PER_SEC);
+
+    ARG_UNUSED(timer);
+
+    m.activity_mg = s % MOTION_CYCLE_S >= MOTION_CYCLE_S - MOTION_WALK_S
+                        ? MOTION_WALK_MG
+                        : MOTION_REST_MG;
+    publish(&fusion_motion_chan, &m);
+}
+
+static K_TIMER_DEFINE(motion_timer, motion_expiry, NULL);
+
+/* The PPG sensor is only needed while the ECG alone is not reliable */
+static void ppg_gate(const struct hr_fusion_stats *st, int64_t now_us)
+{
+    bool on;
+
+    if (!(st->reliable & BIT(HR_SOURCE_ECG))) {
+        ecg_reliable_us = INT64_MAX;
+        on = true;
+    } else {
+        if (ecg_reliable_us == INT64_MAX) {
+            ecg_reliable_us = now_us;
+        }
+        on = now_us - ecg_reliable_us <
+             (int64_t)CONFIG_APP_HR_FUSION_PPG_OFF_S * USEC_PER_SEC;
+    }
+    if (on == ppg_on) {
+        return;
+    }
+    ppg_on = on;
+    ppg_power(on);
+    if (!on) {
+        K_SPINLOCK(&lock) {
+            snapshot.ppg_off++;
+        }
+    }
+}
+
+static void fusion_thread(void)
+{
+    const struct zbus_channel *chan;
+    union {
+        struct fusion_beat beat;
+        struct fusion_motion motion;
+    } msg;
+
+    hr_fusion_init(&fusion);
+    k_timer_start(&motion_timer, K_SECONDS(1), K_SECONDS(1));
+
+    while (zbus_sub_wait_msg(&fusion_sub, &chan, &msg, K_FOREVER) == 0) {
+        int64_t now_us = timebase_now_us();
+        struct hr_fusion_stats st;
+
+        if (chan == &fusion_motion_chan) {
+            hr_fusion_motion(&fusion, msg.motion.activity_mg);
+        } else {
+            hr_fusion_update(&fusion,
+                             chan == &fusion_ecg_chan ? HR_SOURCE_ECG
+                                                      : HR_SOURCE_PPG,
+                             msg.beat.t_us, msg.beat.hr_cbpm,
+                             msg.beat.degraded);
+        }
+
+        /* Motion ticks too, so that lost sources show within a second */
+        hr_fusion_stats_get(&fusion, now_us, &st);
+        K_SPINLOCK(&lock) {
+            snapshot.hr = st;
+        }
+        if (IS_ENABLED(CONFIG_APP_HR_FUSION_PPG_OFF)) {
+            ppg_gate(&st, now_us);
+        }
+        if (chan != &fusion_motion_chan) {
+            struct fusion_hr out = {
+                .t_us = msg.beat.t_us,
+                .hr_cbpm = st.hr_cbpm,
+                .sd_cbpm = st.sd_cbpm,
+                .valid = st.valid,
+                .reliable = st.reliable,
+            };
+
+            (void)zbus_chan_pub(&fusion_hr_chan, &out, K_NO_WAIT);
+        }
+    }
+}
+
+K_THREAD_DEFINE(fusion_tid, FUSION_STACK_SIZE, fusion_thread, NULL, NULL, NULL,
+                FUSION_PRIORITY, 0, 0);
+
+void fusion_ecg_beat(int64_t t_us, uint32_t hr_cbpm, uint8_t degraded)
+{
+    struct fusion_beat b = {
+        .t_us = t_us,
+        .hr_cbpm = hr_cbpm,
+        .degraded = degraded,
+    };
+
+    publish(&fusion_ecg_chan, &b);
+}
+
+void fusion_ppg_beat(int64_t t_us, uint32_t hr_cbpm, uint8_t degraded)
+{
+    struct fusion_beat b = {
+        .t_us = t_us,
+        .hr_cbpm = hr_cbpm,
+        .degraded = degraded,
+    };
+
+    publish(&fusion_ppg_chan, &b);
+}
+
+void fusion_stats_get(struct fusion_stats *st)
+{
+    K_SPINLOCK(&lock) {
+        *st = snapshot;
+    }
+    st->dropped = (uint32_t)atomic_get(&dropped);
+}
+
+void fusion_stats_log(void)
+{
+    struct fusion_stats st;
+    const struct hr_fusion_stats *hr = &st.hr;
+
+    fusion_stats_get(&st);
+    LOG_INF("fusion: HR %u.%02u bpm, SD %u.%02u bpm, %s, reliable%s%s, "
+            "activity %u mg",
+            hr->hr_cbpm / 100, hr->hr_cbpm % 100, hr->sd_cbpm / 100,
+            hr->sd_cbpm % 100, hr->valid ? "valid" : "not valid",
+            hr->reliable & BIT(HR_SOURCE_ECG) ? " ECG" : "",
+            hr->reliable & BIT(HR_SOURCE_PPG) ? " PPG" : "", hr->activity_mg);
+    LOG_INF("fusion: ECG %u accepted, %u rejected, PPG %u accepted, "
+            "%u rejected, %u restarts, %u messages lost, PPG off %u times",
+            hr->accepted[HR_SOURCE_ECG], hr->rejected[HR_SOURCE_ECG],
+            hr->accepted[HR_SOURCE_PPG], hr->rejected[HR_SOURCE_PPG],
+            hr->restarts, st.dropped, st.ppg_off);
+}
@@ -3,14 +3,77 @@
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/logging/log.h>
 
+#include "acq.h"
+#include "app_settings.h"
+#include "ble.h"
+#include "block_pool.h"
+#include "boot_time.h"
+#include "console_pm.h"
+#include "ecg_service.h"
+#include "flash_writer.h"
+#include "fusion.h"
+#include "ppg.h"
+#include "processing.h"
+#include "wired.h"
+
 LOG_MODULE_REGISTER(main, CONFIG_LOG_DEFAULT_LEVEL);
 
 static const struct gpio_dt_spec led = GPIO_DT_SPEC_GET(DT_ALIAS(led0), gpios);
 
+static void settings_apply(void)
+{
+    struct cal_settings cal;
+    struct filter_settings filter;
+
+    app_settings_get(APP_SETTINGS_CAL, &cal, sizeof(cal));
+    app_settings_get(APP_SETTINGS_FILTER, &filter, sizeof(filter));
+    processing_configure(&cal, &filter);
+    boot_time_mark(BOOT_MARK_SETTINGS);
+}
+
+static void stats_log(void)
+{
+    LOG_INF("acq: %u blocks processed, %u dropped, late max %u us",
+            processing_blocks(), acq_dropped(), acq_max_late_us());
+    processing_stats_log();
+    if (IS_ENABLED(CONFIG_APP_PPG)) {
+        ppg_stats_log();
+    }
+    if (IS_ENABLED(CONFIG_APP_HR_FUSION)) {
+        fusion_stats_log();
+    }
+    block_pool_stats_log();
+    app_settings_stats_log();
+    if (IS_ENABLED(CONFIG_APP_STREAM)) {
+        ecg_service_stats_log();
+    }
+    if (IS_ENABLED(CONFIG_APP_WIRED)) {
+        wired_stats_log();
+    }
+    if (IS_ENABLED(CONFIG_APP_RECORDER)) {
+        flash_writer_stats_log();
+    }
+    if (IS_ENABLED(CONFIG_APP_CONSOLE_PM)) {
+        console_pm_stats_log();
+    }
+}
+
 int main(void)
 {
     int ret = 0;
     bool led_state = true;
+    int64_t stats_next = k_uptime_get() + CONFIG_APP_STATS_INTERVAL_S * MSEC_PER_SEC;
+
+    /* Acquisition is already running, see acq_init() */
+    boot_time_mark(BOOT_MARK_MAIN);
+
+    ret = ble_init();
+    if (ret < 0) {
+        LOG_ERR("Bluetooth: %s", strerror(-ret));
+    }
+
+    settings_apply();
+
     if (!gpio_is_ready_dt(&led)) {
         LOG_ERR("%s is not ready! Exit.", led.port->name);
         return -1;
@@ -31,6 +94,10 @@ int main(void)
         }
         led_state = !led_state;
         LOG_INF("LED state: %s", led_state ? "ON" : "OFF");
+        if (CONFIG_APP_STATS_INTERVAL_S > 0 && k_uptime_get() >= stats_next) {
+            stats_log();
+            stats_next += CONFIG_APP_STATS_INTERVAL_S * MSEC_PER_SEC;
+        }
         k_msleep(500);
     }
     return 0;
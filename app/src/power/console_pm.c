@@ -0,0 +1,146 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/logging/log_ctrl.h>
+#include <zephyr/pm/device_runtime.h>
+
+#include "console_pm.h"
+
+LOG_MODULE_REGISTER(console_pm, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define USER_NODE DT_PATH(zephyr_user)
+
+BUILD_ASSERT(DT_NODE_HAS_PROP(USER_NODE, console_rx_gpios),
+             "console-rx-gpios must be set in the zephyr,user node");
+
+static const struct device *const console =
+    DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+static const struct gpio_dt_spec rx_wake =
+    GPIO_DT_SPEC_GET(USER_NODE, console_rx_gpios);
+
+static struct gpio_callback rx_wake_cb;
+static K_SEM_DEFINE(wake_sem, 0, 1);
+
+static int64_t suspended_at;
+static int64_t suspended_total;
+static uint32_t suspend_count;
+
+static void rx_wake_handler(const struct device *port, struct gpio_callback *cb,
+                            gpio_port_pins_t pins)
+{
+    gpio_pin_interrupt_configure_dt(&rx_wake, GPIO_INT_DISABLE);
+    k_sem_give(&wake_sem);
+}
+
+static int console_suspend(void)
+{
+    int ret;
+
+    ret = pm_device_runtime_put(console);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = gpio_pin_configure_dt(&rx_wake, GPIO_INPUT);
+    if (ret == 0) {
+        ret = gpio_pin_interrupt_configure_dt(&rx_wake,
+                                              GPIO_INT_EDGE_TO_ACTIVE);
+    }
+    if (ret < 0) {
+        pm_device_runtime_get(console);
+        return ret;
+    }
+
+    suspended_at = k_uptime_get();
+    suspend_count++;
+    return 0;
+}
+
+static void console_resume(void)
+{
+    gpio_pin_interrupt_configure_dt(&rx_wake, GPIO_INT_DISABLE);
+    gpio_pin_configure_dt(&rx_wake, GPIO_DISCONNECTED);
+    pm_device_runtime_get(console);
+    suspended_total += k_uptime_get() - suspended_at;
+    suspended_at = 0;
+}
+
+static FUNC_NORETURN void log_flush_loop(void)
+{
+    while (1) {
+        while (log_process()) {
+        }
+        k_msleep(CONFIG_APP_CONSOLE_POLL_MS);
+    }
+}
+
+static void console_pm_thread(void)
+{
+    int64_t last_rx;
+    unsigned char c;
+    int ret;
+
+    if (!device_is_ready(console) || !gpio_is_ready_dt(&rx_wake)) {
+        log_flush_loop();
+    }
+
+    gpio_init_callback(&rx_wake_cb, rx_wake_handler, BIT(rx_wake.pin));
+    ret = gpio_add_callback_dt(&rx_wake, &rx_wake_cb);
+    if (ret == 0) {
+        ret = pm_device_runtime_enable(console);
+    }
+    if (ret == 0) {
+        ret = pm_device_runtime_get(console);
+    }
+    if (ret < 0) {
+        LOG_ERR("%s: %s", console->name, strerror(-ret));
+        /* Keep the console usable without power management */
+        log_flush_loop();
+    }
+
+    last_rx = k_uptime_get();
+    while (1) {
+        while (uart_poll_in(console, &c) == 0) {
+            last_rx = k_uptime_get();
+        }
+        while (log_process()) {
+        }
+
+        if (k_uptime_get() - last_rx <
+            CONFIG_APP_CONSOLE_IDLE_TIMEOUT_S * MSEC_PER_SEC) {
+            k_msleep(CONFIG_APP_CONSOLE_POLL_MS);
+            continue;
+        }
+
+        if (console_suspend() < 0) {
+            last_rx = k_uptime_get();
+            continue;
+        }
+        k_sem_take(&wake_sem, K_FOREVER);
+        console_resume();
+        last_rx = k_uptime_get();
+    }
+}
+
+K_THREAD_DEFINE(console_pm, 1024, console_pm_thread, NULL, NULL, NULL,
+                K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
+
+int64_t console_pm_suspended_ms(void)
+{
+    int64_t total = suspended_total;
+
+    if (suspended_at != 0) {
+        total += k_uptime_get() - suspended_at;
+    }
+    return total;
+}
+
+void console_pm_stats_log(void)
+{
+    LOG_INF("console: suspended %lld of %lld ms, %u suspends",
+            (long long)console_pm_suspended_ms(), (long long)k_uptime_get(),
+            suspend_count);
+}
@@ -0,0 +1,49 @@
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/init.h>
+
+#include <nrf.h>
+
+/*
+ * nRF52840 RAM layout: RAM0..RAM7 hold two 4 KB sections each
+ * (0x20000000..0x2000FFFF), RAM8 holds six 32 KB sections
+ * (0x20010000..0x2003FFFF).
+ */
+#define SMALL_BLOCKS        8
+#define SMALL_SECTIONS      2
+#define SMALL_SECTION_SIZE  KB(4)
+#define LARGE_BLOCK         8
+#define LARGE_SECTION_SIZE  KB(32)
+#define LARGE_BASE_OFFSET   (SMALL_BLOCKS * SMALL_SECTIONS * SMALL_SECTION_SIZE)
+
+#define SRAM_TOTAL_SIZE DT_REG_SIZE(DT_CHOSEN(zephyr_sram))
+#define RETAINED_SIZE   KB(CONFIG_APP_RAM_RETAINED_SIZE)
+
+BUILD_ASSERT(RETAINED_SIZE <= SRAM_TOTAL_SIZE);
+BUILD_ASSERT(RETAINED_SIZE > LARGE_BASE_OFFSET
+                 ? (RETAINED_SIZE - LARGE_BASE_OFFSET) % LARGE_SECTION_SIZE == 0
+                 : RETAINED_SIZE % SMALL_SECTION_SIZE == 0,
+             "APP_RAM_RETAINED_SIZE must end on a RAM section boundary");
+
+static int ram_power_down(void)
+{
+    size_t offset;
+
+    for (offset = RETAINED_SIZE; offset < SRAM_TOTAL_SIZE;) {
+        if (offset < LARGE_BASE_OFFSET) {
+            size_t section = offset / SMALL_SECTION_SIZE;
+
+            NRF_POWER->RAM[section / SMALL_SECTIONS].POWERCLR =
+                BIT(section % SMALL_SECTIONS);
+            offset += SMALL_SECTION_SIZE;
+        } else {
+            size_t section = (offset - LARGE_BASE_OFFSET) / LARGE_SECTION_SIZE;
+
+            NRF_POWER->RAM[LARGE_BLOCK].POWERCLR = BIT(section);
+            offset += LARGE_SECTION_SIZE;
+        }
+    }
+    return 0;
+}
+
+SYS_INIT(ram_power_down, PRE_KERNEL_1, 0);
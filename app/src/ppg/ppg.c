@@ -0,0 +1,292 @@
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/timing/timing.h>
+
+#include "dsp/pat.h"
+#include "dsp/ppg_synth.h"
+#include "dsp/spo2.h"
+#include "fusion.h"
+#include "ppg.h"
+#include "timebase.h"
+
+LOG_MODULE_REGISTER(ppg, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define PPG_STACK_SIZE 1024
+#define PPG_PRIORITY   K_PRIO_PREEMPT(3)
+
+#define PPG_SAMPLE_PERIOD_US (USEC_PER_SEC / CONFIG_APP_PPG_SAMPLE_RATE_HZ)
+#define PPG_BLOCK_SAMPLES    CONFIG_APP_PPG_BLOCK_SAMPLES
+#define PPG_BLOCK_PERIOD_US  (PPG_BLOCK_SAMPLES * PPG_SAMPLE_PERIOD_US)
+
+BUILD_ASSERT(USEC_PER_SEC % CONFIG_APP_PPG_SAMPLE_RATE_HZ == 0,
+             "PPG sample period must be a whole number of microseconds");
+
+/*
+ * The emulated sensor pulses a fixed arrival time after the emulated ECG
+ * beats. Its FIFO is read this long after each block ends, as a sensor
+ * interrupting at a FIFO watermark would be, so that the R peak behind
+ * every pulse onset has been generated by then.
+ */
+#define PPG_EMUL_PAT_US 250000
+#define PPG_EMUL_LAG_US 200000
+
+/* Pulse rate of beats weaker than this is marked degraded for the fusion */
+#define PPG_PI_WEAK_CPCT 50
+
+/* Emulated beats and detected R peaks on the common timebase */
+K_MSGQ_DEFINE(ppg_heartbeat_msgq, sizeof(int64_t), 8, 8);
+K_MSGQ_DEFINE(ppg_r_peak_msgq, sizeof(int64_t), 8, 8);
+
+static K_TIMER_DEFINE(ppg_timer, NULL, NULL);
+static K_THREAD_STACK_DEFINE(ppg_stack, PPG_STACK_SIZE);
+static struct k_thread ppg_thread_data;
+
+static struct ppg_synth synth;
+static struct spo2 spo2;
+static struct pat pat;
+
+/* Next pulse onset of the emulated sensor, INT64_MAX while none is due */
+static int64_t onset_us = INT64_MAX;
+
+static atomic_t powered = ATOMIC_INIT(1);
+static uint32_t off_blocks;
+
+/* Estimator time in ns and samples of the second of signal in progress */
+static uint32_t second_ns;
+static uint32_t second_samples;
+
+static struct k_spinlock lock;
+static struct ppg_stats snapshot;
+
+/*
+ * A pass takes microseconds: k_cycle_get_32() is the 32 kHz RTC on nRF52,
+ * the timing API counts CPU cycles (DWT on Cortex-M). Without it, the
+ * system clock is all there is.
+ */
+#ifdef CONFIG_TIMING_FUNCTIONS
+typedef timing_t busy_t;
+
+static inline busy_t busy_get(void)
+{
+    return timing_counter_get();
+}
+
+static inline uint32_t busy_ns(busy_t start, busy_t end)
+{
+    return (uint32_t)timing_cycles_to_ns(timing_cycles_get(&start, &end));
+}
+#else
+typedef uint32_t busy_t;
+
+static inline busy_t busy_get(void)
+{
+    return k_cycle_get_32();
+}
+
+static inline uint32_t busy_ns(busy_t start, busy_t end)
+{
+    return (uint32_t)k_cyc_to_ns_floor64(end - start);
+}
+#endif
+
+/* What the sensor FIFO holds for the block starting at t0_us */
+static void sensor_read(int32_t *red, int32_t *ir, int64_t t0_us)
+{
+    size_t i = 0;
+
+    while (i < PPG_BLOCK_SAMPLES) {
+        int64_t t_us = t0_us + (int64_t)i * PPG_SAMPLE_PERIOD_US;
+        size_t n = PPG_BLOCK_SAMPLES - i;
+        int64_t r_us;
+
+        if (onset_us == INT64_MAX &&
+            k_msgq_get(&ppg_heartbeat_msgq, &r_us, K_NO_WAIT) == 0) {
+            onset_us = r_us + PPG_EMUL_PAT_US - PPG_SYNTH_FOOT_US;
+        }
+        if (onset_us <= t_us) {
+            ppg_synth_pulse(&synth);
+            onset_us = INT64_MAX;
+            continue;
+        }
+        if (onset_us != INT64_MAX) {
+            /* Up to the sample the pulse starts on */
+            n = MIN(n, (size_t)((onset_us - t_us + PPG_SAMPLE_PERIOD_US - 1) /
+                                PPG_SAMPLE_PERIOD_US));
+        }
+        ppg_synth_fill(&synth, &red[i], &ir[i], n);
+        i += n;
+    }
+}
+
+/* Pulse rate of the beat the estimator accepted last, to the fusion */
+static void beat_put(int64_t t0_us, const struct spo2_stats *st)
+{
+    /* The trough that ended the beat, relative to the block */
+    int64_t offset = (int64_t)spo2.trough_n -
+                     (int64_t)(spo2.n - PPG_BLOCK_SAMPLES);
+
+    fusion_ppg_beat(t0_us + offset * PPG_SAMPLE_PERIOD_US,
+                    6000000 / spo2.last_period_ms,
+                    st->pi_cpct < PPG_PI_WEAK_CPCT);
+}
+
+static void ppg_block(int64_t t0_us)
+{
+    int32_t red[PPG_BLOCK_SAMPLES];
+    int32_t ir[PPG_BLOCK_SAMPLES];
+    int64_t r_us;
+    busy_t start;
+    uint32_t second_us;
+    uint32_t accepted = spo2.beats;
+    size_t beats;
+    size_t pairs = 0;
+
+    /* The emulation runs on while off, its pulses stay with the ECG */
+    sensor_read(red, ir, t0_us);
+    if (!atomic_get(&powered)) {
+        /* No feet to pair the R peaks with */
+        k_msgq_purge(&ppg_r_peak_msgq);
+        off_blocks++;
+        K_SPINLOCK(&lock) {
+            snapshot.off_s = (uint32_t)((uint64_t)off_blocks *
+                                        PPG_BLOCK_PERIOD_US / USEC_PER_SEC);
+        }
+        return;
+    }
+
+    start = busy_get();
+    beats = spo2_process(&spo2, red, ir, PPG_BLOCK_SAMPLES);
+    while (k_msgq_get(&ppg_r_peak_msgq, &r_us, K_NO_WAIT) == 0) {
+        pairs += pat_r_peak(&pat, r_us);
+    }
+    pairs += pat_ppg(&pat, ir, PPG_BLOCK_SAMPLES, t0_us);
+    second_ns += busy_ns(start, busy_get());
+    second_samples += PPG_BLOCK_SAMPLES;
+
+    if (beats > 0 || pairs > 0) {
+        struct spo2_stats st;
+        struct pat_stats pt;
+
+        spo2_stats_get(&spo2, &st);
+        pat_stats_get(&pat, &pt);
+        K_SPINLOCK(&lock) {
+            snapshot.spo2 = st;
+            snapshot.pat = pt;
+        }
+        if (IS_ENABLED(CONFIG_APP_HR_FUSION) && spo2.beats != accepted) {
+            beat_put(t0_us, &st);
+        }
+    }
+    if (second_samples < CONFIG_APP_PPG_SAMPLE_RATE_HZ) {
+        return;
+    }
+
+    second_us = second_ns / NSEC_PER_USEC;
+    K_SPINLOCK(&lock) {
+        snapshot.us_per_s_max = MAX(snapshot.us_per_s_max, second_us);
+        if (second_us > CONFIG_APP_PPG_US_PER_S) {
+            snapshot.over_budget++;
+        }
+    }
+    if (second_us > CONFIG_APP_PPG_US_PER_S) {
+        LOG_WRN("spo2: %u us in 1 s, budget %u us", second_us,
+                CONFIG_APP_PPG_US_PER_S);
+    }
+    second_ns = 0;
+    second_samples -= CONFIG_APP_PPG_SAMPLE_RATE_HZ;
+}
+
+static void ppg_thread(void *p1, void *p2, void *p3)
+{
+    int64_t t0 = timebase_now_us();
+    uint32_t seq = 0;
+
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    k_timer_start(&ppg_timer, K_USEC(PPG_BLOCK_PERIOD_US + PPG_EMUL_LAG_US),
+                  K_USEC(PPG_BLOCK_PERIOD_US));
+
+    while (1) {
+        /* Every expired period, the emulated FIFO keeps filling */
+        uint32_t periods = k_timer_status_sync(&ppg_timer);
+
+        for (uint32_t i = 0; i < periods; i++, seq++) {
+            ppg_block(t0 + (int64_t)seq * PPG_BLOCK_PERIOD_US);
+        }
+    }
+}
+
+void ppg_emul_heartbeat(int64_t r_us)
+{
+    /* Full only if the PPG thread stalled, the pulse is then skipped */
+    (void)k_msgq_put(&ppg_heartbeat_msgq, &r_us, K_NO_WAIT);
+}
+
+void ppg_r_peak(int64_t r_us)
+{
+    if (k_msgq_put(&ppg_r_peak_msgq, &r_us, K_NO_WAIT) != 0) {
+        K_SPINLOCK(&lock) {
+            snapshot.r_dropped++;
+        }
+    }
+}
+
+void ppg_power(bool on)
+{
+    if (atomic_set(&powered, on) != on) {
+        LOG_INF("ppg: sensor %s", on ? "on" : "off");
+    }
+}
+
+void ppg_stats_get(struct ppg_stats *st)
+{
+    K_SPINLOCK(&lock) {
+        *st = snapshot;
+    }
+}
+
+void ppg_stats_log(void)
+{
+    struct ppg_stats st;
+
+    ppg_stats_get(&st);
+    LOG_INF("spo2: %u.%u %%, PI %u.%02u %%, PR %u.%u bpm, %u beats, "
+            "%u rejected",
+            st.spo2.spo2_dpct / 10, st.spo2.spo2_dpct % 10,
+            st.spo2.pi_cpct / 100, st.spo2.pi_cpct % 100,
+            st.spo2.pr_dbpm / 10, st.spo2.pr_dbpm % 10, st.spo2.beats,
+            st.spo2.rejected);
+    LOG_INF("pat: %u.%u ms, last %u.%u ms, %u pairs, %u R and %u feet "
+            "unpaired, %u R dropped",
+            st.pat.pat_us / 1000, st.pat.pat_us % 1000 / 100,
+            st.pat.last_pat_us / 1000, st.pat.last_pat_us % 1000 / 100,
+            st.pat.pairs, st.pat.r_unpaired, st.pat.feet_unpaired,
+            st.r_dropped);
+    LOG_INF("spo2: %u us/s max, budget %u us, %u s over, sensor off %u s",
+            st.us_per_s_max, CONFIG_APP_PPG_US_PER_S, st.over_budget,
+            st.off_s);
+}
+
+static int ppg_init(void)
+{
+    ppg_synth_init(&synth, CONFIG_APP_PPG_SAMPLE_RATE_HZ, 72, 1);
+    spo2_init(&spo2, CONFIG_APP_PPG_SAMPLE_RATE_HZ, NULL);
+    pat_init(&pat, CONFIG_APP_PPG_SAMPLE_RATE_HZ);
+#ifdef CONFIG_TIMING_FUNCTIONS
+    timing_init();
+    timing_start();
+#endif
+
+    k_thread_create(&ppg_thread_data, ppg_stack,
+                    K_THREAD_STACK_SIZEOF(ppg_stack), ppg_thread, NULL, NULL,
+                    NULL, PPG_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&ppg_thread_data, "ppg");
+    return 0;
+}
+
+SYS_INIT(ppg_init, APPLICATION, 1);
@@ -0,0 +1,425 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/atomic.h>
+
+#include "acq.h"
+#include "block_pool.h"
+#include "dsp/biquad.h"
+#include "dsp/ecg_analysis.h"
+#include "dsp/mains.h"
+#include "dsp/rec_format.h"
+#include "dsp/spectrum.h"
+#include "dsp/sqi.h"
+#include "ecg_service.h"
+#include "fusion.h"
+#include "pipeline.h"
+#include "ppg.h"
+#include "processing.h"
+#include "recorder.h"
+#include "wired.h"
+
+LOG_MODULE_REGISTER(processing, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define DSP_STACK_SIZE 2048
+#define DSP_PRIORITY   K_PRIO_PREEMPT(2)
+
+struct filter_spec {
+    uint8_t type;
+    uint32_t cutoff_chz;
+};
+
+#define FILTER_SPEC(node)                                                      \
+    {                                                                          \
+        .type = DT_ENUM_IDX(node, type),                                       \
+        .cutoff_chz = DT_PROP(node, cutoff_centihz),                           \
+    },
+
+/* Conditioning chain, the pipeline node's children in order */
+static const struct filter_spec filter_chain[] = {
+    DT_FOREACH_CHILD_STATUS_OKAY(PIPELINE_NODE, FILTER_SPEC)
+};
+
+#define FILTER_CHECK(node)                                                     \
+    BUILD_ASSERT(DT_PROP(node, cutoff_centihz) < PIPELINE_SAMPLE_RATE_HZ * 50, \
+                 "filter cutoff above Nyquist");
+
+DT_FOREACH_CHILD_STATUS_OKAY(PIPELINE_NODE, FILTER_CHECK)
+
+static struct biquad conditioning[PIPELINE_LEADS][PIPELINE_FILTERS];
+
+/* Estimated on lead 0, notched on all */
+static struct mains mains;
+static struct mains_notch mains_notch[PIPELINE_LEADS];
+
+#define SQI_WINDOW_BLOCKS                                                      \
+    SQI_BLOCKS(PIPELINE_SAMPLE_RATE_HZ, PIPELINE_BLOCK_SAMPLES)
+
+/* Input quality of every lead, before conditioning hides clipping */
+static struct sqi quality[PIPELINE_LEADS];
+static uint32_t quality_buf[PIPELINE_LEADS][SQI_WORDS(SQI_WINDOW_BLOCKS)];
+
+static uint32_t blocks;
+/* Wall time per block, includes preemption by radio and other ISRs */
+static uint32_t busy_us_max;
+static uint64_t busy_us_total;
+
+static struct ecg_analysis analysis;
+#if PIPELINE_BASELINE_MEDIAN
+static uint32_t baseline_buf[MEDIAN_BASELINE_WORDS(PIPELINE_SAMPLE_RATE_HZ)];
+#endif
+/* Frequency domain HRV, recomputed every HRV_FREQ_EVERY beats */
+#define HRV_FREQ_EVERY 16
+
+static struct spectrum hrv_spectrum;
+static int32_t hrv_freq_buf[HRV_FREQ_WORDS];
+static uint64_t hrv_freq_power[HRV_FREQ_N / 2 + 1];
+static uint32_t hrv_freq_beats;
+
+static struct k_spinlock hrv_lock;
+static struct hrv_stats hrv_snapshot;
+static struct hrv_freq hrv_freq_snapshot;
+static struct delin_stats delin_snapshot;
+static struct sqi_stats sqi_snapshot[PIPELINE_LEADS];
+static struct mains_stats mains_snapshot;
+static uint32_t beats;
+/* Samples through the beat detector, for the times of its R peaks */
+static uint64_t analysed;
+static int64_t last_r_us = INT64_MIN;
+
+static struct k_spinlock config_lock;
+static atomic_t config_pending;
+static struct cal_settings config_cal;
+static struct filter_settings config_filter;
+
+static struct cal_settings cal = {
+    .gain_q16 = 1 << 16,
+};
+
+void processing_configure(const struct cal_settings *new_cal,
+                          const struct filter_settings *new_filter)
+{
+    K_SPINLOCK(&config_lock) {
+        config_cal = *new_cal;
+        config_filter = *new_filter;
+    }
+    atomic_set(&config_pending, 1);
+}
+
+static void apply_config(void)
+{
+    struct filter_settings filter;
+
+    K_SPINLOCK(&config_lock) {
+        cal = config_cal;
+        filter = config_filter;
+    }
+
+    /* Keep the filter state, only the response changes */
+    ecg_analysis_set_baseline(&analysis, filter.baseline_cutoff_chz);
+    if (IS_ENABLED(CONFIG_APP_RECORDER) && !PIPELINE_BASELINE_MEDIAN) {
+        recorder_set_baseline(filter.baseline_cutoff_chz);
+    }
+}
+
+static void calibrate(struct sample_block *block)
+{
+    /* Contiguous rows of one lead each, the inner loop vectorizes */
+    for (size_t l = 0; l < PIPELINE_LEADS; l++) {
+        int32_t *x = block->samples[l];
+
+        for (size_t i = 0; i < PIPELINE_BLOCK_SAMPLES; i++) {
+            x[i] = (int32_t)(((int64_t)x[i] * cal.gain_q16) >> 16) +
+                   cal.offset_uv;
+        }
+    }
+}
+
+static void condition_init(void)
+{
+    for (size_t s = 0; s < PIPELINE_FILTERS; s++) {
+        const struct filter_spec *spec = &filter_chain[s];
+        struct biquad_coeffs c;
+
+        if (spec->type == PIPELINE_FILTER_HIGHPASS) {
+            biquad_highpass(&c, PIPELINE_SAMPLE_RATE_HZ,
+                            spec->cutoff_chz / 100.0);
+        } else {
+            biquad_lowpass(&c, PIPELINE_SAMPLE_RATE_HZ,
+                           spec->cutoff_chz / 100.0);
+        }
+        for (size_t l = 0; l < PIPELINE_LEADS; l++) {
+            biquad_init(&conditioning[l][s], &c);
+        }
+    }
+}
+
+static void condition(struct sample_block *block)
+{
+    /* Both bounds are constants, an empty chain compiles to nothing */
+    for (size_t l = 0; l < PIPELINE_LEADS; l++) {
+        if (PIPELINE_MAINS_AUTO) {
+            mains_notch_process(&mains, &mains_notch[l], block->samples[l],
+                                PIPELINE_BLOCK_SAMPLES);
+        }
+        for (size_t s = 0; s < PIPELINE_FILTERS; s++) {
+            biquad_process(&conditioning[l][s], block->samples[l],
+                           PIPELINE_BLOCK_SAMPLES);
+        }
+    }
+}
+
+static void assess(const struct sample_block *block)
+{
+    struct sqi_stats st[PIPELINE_LEADS];
+    struct mains_stats ms = {0};
+
+    for (size_t l = 0; l < PIPELINE_LEADS; l++) {
+        sqi_block(&quality[l], block->samples[l], block->count);
+        sqi_stats_get(&quality[l], &st[l], 0);
+    }
+    if (PIPELINE_MAINS_AUTO) {
+        /* Ahead of the notches, which would hide what they track */
+        mains_update(&mains, block->samples[0], block->count);
+        mains_stats_get(&mains, &ms);
+    }
+    K_SPINLOCK(&hrv_lock) {
+        memcpy(sqi_snapshot, st, sizeof(st));
+        mains_snapshot = ms;
+    }
+}
+
+/* Heart rate of the beat ending at r_us to the fusion, if the lead allows */
+static void beat_put(int64_t r_us)
+{
+    int64_t rr_us = r_us - last_r_us;
+    uint8_t state = quality[0].state;
+
+    if (last_r_us == INT64_MIN || rr_us < HRV_RR_MIN_MS * 1000 ||
+        rr_us > HRV_RR_MAX_MS * 1000 || state > SQI_NOISY) {
+        return;
+    }
+    /* Noise makes extra and missed beats likely, not just jitter */
+    fusion_ecg_beat(r_us, (uint32_t)(6000000000LL / rr_us),
+                    state == SQI_NOISY ? 2 : 0);
+}
+
+/*
+ * R peaks to the pulse arrival time and the heart rate fusion, on the
+ * common timebase. Peaks are sample indices of the analysis, which only
+ * sees the blocks that were not lost, so they are timed from the block at
+ * hand.
+ */
+static void r_peaks_put(const struct sample_block *block,
+                        const uint64_t *r_peaks, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        int64_t offset = (int64_t)r_peaks[i] - (int64_t)analysed;
+        int64_t r_us = block->timestamp_us + offset * ACQ_SAMPLE_PERIOD_US;
+
+        if (IS_ENABLED(CONFIG_APP_PPG)) {
+            ppg_r_peak(r_us);
+        }
+        if (IS_ENABLED(CONFIG_APP_HR_FUSION)) {
+            beat_put(r_us);
+        }
+        last_r_us = r_us;
+    }
+}
+
+static void dsp_thread(void)
+{
+    uint32_t expected_seq = 0;
+
+    condition_init();
+    mains_init(&mains, PIPELINE_SAMPLE_RATE_HZ);
+    for (size_t l = 0; l < PIPELINE_LEADS; l++) {
+        sqi_init(&quality[l], SQI_WINDOW_BLOCKS, PIPELINE_FULL_SCALE_UV,
+                 quality_buf[l], ARRAY_SIZE(quality_buf[l]));
+    }
+    ecg_analysis_init(&analysis, PIPELINE_SAMPLE_RATE_HZ,
+                      PIPELINE_BASELINE_CUTOFF_CHZ);
+    spectrum_init(&hrv_spectrum, HRV_FREQ_N);
+#if PIPELINE_BASELINE_MEDIAN
+    ecg_analysis_use_median(&analysis, baseline_buf, ARRAY_SIZE(baseline_buf));
+#endif
+    if (IS_ENABLED(CONFIG_APP_RECORDER)) {
+        recorder_set_baseline(PIPELINE_BASELINE_MEDIAN
+                                  ? REC_BASELINE_MEDIAN
+                                  : PIPELINE_BASELINE_CUTOFF_CHZ);
+    }
+
+    while (1) {
+        struct sample_block *block = acq_get(K_FOREVER);
+        uint64_t r_peaks[4];
+        size_t n;
+        uint32_t start;
+        uint32_t busy_us;
+
+        if (block->seq != expected_seq) {
+            LOG_WRN("blocks %u..%u lost", expected_seq, block->seq - 1);
+        }
+        expected_seq = block->seq + 1;
+
+        if (atomic_cas(&config_pending, 1, 0)) {
+            apply_config();
+        }
+
+        start = k_cycle_get_32();
+        calibrate(block);
+        assess(block);
+        condition(block);
+        if (IS_ENABLED(CONFIG_APP_RECORDER)) {
+            recorder_put(block);
+        }
+        if (IS_ENABLED(CONFIG_APP_STREAM)) {
+            ecg_service_put(block);
+        }
+        if (IS_ENABLED(CONFIG_APP_WIRED)) {
+            wired_put(block);
+        }
+        n = ecg_analysis_process(&analysis, block->samples[0], block->count,
+                                 r_peaks, ARRAY_SIZE(r_peaks));
+        if (IS_ENABLED(CONFIG_APP_PPG) || IS_ENABLED(CONFIG_APP_HR_FUSION)) {
+            r_peaks_put(block, r_peaks, MIN(n, ARRAY_SIZE(r_peaks)));
+        }
+        analysed += block->count;
+        if (n > 0) {
+            struct hrv_stats st;
+
+            hrv_get(&analysis.hrv, &st);
+            K_SPINLOCK(&hrv_lock) {
+                hrv_snapshot = st;
+                beats = analysis.beats;
+            }
+        }
+        if (analysis.beats - hrv_freq_beats >= HRV_FREQ_EVERY) {
+            struct hrv_freq fr;
+
+            hrv_freq_beats = analysis.beats;
+            if (hrv_freq_get(&analysis.hrv, &hrv_spectrum, hrv_freq_buf,
+                             hrv_freq_power, &fr) == 0) {
+                K_SPINLOCK(&hrv_lock) {
+                    hrv_freq_snapshot = fr;
+                }
+            }
+        }
+        if (analysis.delineated_count > 0) {
+            struct delin_stats st;
+
+            delin_stats_get(&analysis.delin, &st, 0);
+            K_SPINLOCK(&hrv_lock) {
+                delin_snapshot = st;
+            }
+        }
+        busy_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+        busy_us_max = MAX(busy_us_max, busy_us);
+        busy_us_total += busy_us;
+        blocks++;
+
+        block_pool_free(BLOCK_POOL_SAMPLES, block);
+    }
+}
+
+K_THREAD_DEFINE(dsp, DSP_STACK_SIZE, dsp_thread, NULL, NULL, NULL,
+                DSP_PRIORITY, 0, 0);
+
+uint32_t processing_blocks(void)
+{
+    return blocks;
+}
+
+uint32_t processing_beats(struct hrv_stats *hrv)
+{
+    uint32_t n;
+
+    K_SPINLOCK(&hrv_lock) {
+        *hrv = hrv_snapshot;
+        n = beats;
+    }
+    return n;
+}
+
+void processing_hrv_freq(struct hrv_freq *fr)
+{
+    K_SPINLOCK(&hrv_lock) {
+        *fr = hrv_freq_snapshot;
+    }
+}
+
+void processing_delin(struct delin_stats *st)
+{
+    K_SPINLOCK(&hrv_lock) {
+        *st = delin_snapshot;
+    }
+}
+
+size_t processing_sqi(struct sqi_stats *st, size_t max)
+{
+    size_t n = MIN(max, PIPELINE_LEADS);
+
+    K_SPINLOCK(&hrv_lock) {
+        memcpy(st, sqi_snapshot, n * sizeof(*st));
+    }
+    return n;
+}
+
+void processing_stats_log(void)
+{
+    struct hrv_stats hrv;
+    struct hrv_freq fr;
+    struct delin_stats delin;
+    struct sqi_stats sqi[PIPELINE_LEADS];
+    uint32_t n = processing_beats(&hrv);
+    uint32_t avg_us = blocks > 0 ? (uint32_t)(busy_us_total / blocks) : 0;
+
+    LOG_INF("dsp: %u us avg, %u us max per block, %u.%u%% of the %u us "
+            "block period",
+            avg_us, busy_us_max, avg_us * 1000 / ACQ_BLOCK_PERIOD_US / 10,
+            avg_us * 1000 / ACQ_BLOCK_PERIOD_US % 10, ACQ_BLOCK_PERIOD_US);
+    LOG_INF("hrv: %u beats, HR %u.%u bpm, SDNN %u ms, RMSSD %u ms over %u RR, "
+            "%u rejected",
+            n, hrv.hr_dbpm / 10, hrv.hr_dbpm % 10, hrv.sdnn_ms, hrv.rmssd_ms,
+            hrv.count, hrv.rejected);
+
+    processing_hrv_freq(&fr);
+    LOG_INF("hrv: LF %u ms2, HF %u ms2, LF/HF %u.%02u, respiration %u.%u "
+            "/min",
+            fr.lf_ms2, fr.hf_ms2, fr.lf_hf_pct / 100, fr.lf_hf_pct % 100,
+            fr.resp_dbrpm / 10, fr.resp_dbrpm % 10);
+
+    processing_delin(&delin);
+    LOG_INF("delin: %u beats (%u P, %u T, %u late), QRS %u ms, PR %u ms, "
+            "QT %u ms, QTc %u ms, ST %d uV",
+            delin.beats, delin.p_waves, delin.t_waves, delin.late,
+            delin.qrs_ms, delin.pr_ms, delin.qt_ms, delin.qtc_ms, delin.st_uv);
+
+    if (PIPELINE_MAINS_AUTO) {
+        struct mains_stats ms;
+
+        K_SPINLOCK(&hrv_lock) {
+            ms = mains_snapshot;
+        }
+        LOG_INF("mains: %u.%03u Hz, harmonics 0x%x, %u estimates, %u retunes, "
+                "next in %u ms",
+                ms.freq_mhz / 1000, ms.freq_mhz % 1000, ms.harmonics,
+                ms.estimates, ms.retunes,
+                (uint32_t)((uint64_t)ms.interval * 1000 /
+                           PIPELINE_SAMPLE_RATE_HZ));
+    }
+
+    /* Lead 0 always, the others once they had a bad block */
+    processing_sqi(sqi, ARRAY_SIZE(sqi));
+    for (size_t l = 0; l < PIPELINE_LEADS; l++) {
+        const uint32_t *b = sqi[l].blocks;
+
+        if (l > 0 && b[SQI_NOISY] + b[SQI_FLAT] + b[SQI_SATURATED] == 0) {
+            continue;
+        }
+        LOG_INF("sqi: lead %zu %u good, %u noisy, %u flat, %u saturated "
+                "blocks, %d uV p-p, noise %d uV",
+                l, b[SQI_GOOD], b[SQI_NOISY], b[SQI_FLAT], b[SQI_SATURATED],
+                sqi[l].p2p_uv, sqi[l].noise_uv);
+    }
+}
@@ -0,0 +1,284 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/atomic.h>
+
+#ifdef CONFIG_MBEDTLS_MEMORY_DEBUG
+#include <mbedtls/memory_buffer_alloc.h>
+#endif
+
+#include "boot_time.h"
+#include "dsp/rec_format.h"
+#include "flash_writer.h"
+#include "pipeline.h"
+#include "rec_crypto.h"
+#include "timebase.h"
+
+LOG_MODULE_REGISTER(flash_writer, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define WRITER_STACK_SIZE 1024
+#define WRITER_PRIORITY   K_LOWEST_APPLICATION_THREAD_PRIO
+
+#define RECORDER_PARTITION FIXED_PARTITION_ID(recorder_partition)
+
+BUILD_ASSERT(FIXED_PARTITION_SIZE(recorder_partition) % REC_PAGE_SIZE == 0,
+             "recorder partition must be a whole number of pages");
+
+struct page {
+    uint8_t data[REC_PAGE_SIZE];
+    size_t used;
+    /* Beat detector baseline when the page was started */
+    uint16_t baseline;
+    atomic_t full;
+};
+
+static struct page pages[2];
+/* Page filled by flash_writer_append(), sealed early by a flush */
+static int fill;
+static K_MUTEX_DEFINE(fill_mutex);
+static K_SEM_DEFINE(sealed_sem, 0, ARRAY_SIZE(pages));
+/* Given each time the writer thread frees a page */
+static K_SEM_DEFINE(written_sem, 0, 1);
+/* Set by the producer, see flash_writer_set_baseline() */
+static uint16_t baseline;
+
+static struct flash_writer_stats stats;
+
+static void seal(struct page *p)
+{
+    memset(p->data + p->used, REC_ERASED, REC_PAGE_SIZE - p->used);
+    atomic_set(&p->full, 1);
+    k_sem_give(&sealed_sem);
+    fill = (fill + 1) % ARRAY_SIZE(pages);
+}
+
+int flash_writer_append(const void *data, size_t len)
+{
+    uint32_t start = k_cycle_get_32();
+    struct page *p;
+    uint32_t elapsed_us;
+    int ret = 0;
+
+    if (len > REC_PAGE_SIZE - REC_PAGE_HDR_SIZE) {
+        return -EINVAL;
+    }
+
+    /* Only a flush contends, and it holds the mutex for a memset */
+    k_mutex_lock(&fill_mutex, K_FOREVER);
+    p = &pages[fill];
+    if (!atomic_get(&p->full) && p->used + len > REC_PAGE_SIZE) {
+        seal(p);
+        p = &pages[fill];
+    }
+
+    if (atomic_get(&p->full)) {
+        stats.frames_dropped++;
+        ret = -EBUSY;
+    } else {
+        if (p->used == 0) {
+            /* Header is filled in by the writer thread */
+            p->used = REC_PAGE_HDR_SIZE;
+            p->baseline = baseline;
+        }
+        memcpy(p->data + p->used, data, len);
+        p->used += len;
+    }
+    k_mutex_unlock(&fill_mutex);
+
+    elapsed_us = k_cyc_to_us_ceil32(k_cycle_get_32() - start);
+    stats.max_append_us = MAX(stats.max_append_us, elapsed_us);
+    return ret;
+}
+
+void flash_writer_set_baseline(uint16_t new_baseline)
+{
+    baseline = new_baseline;
+}
+
+int flash_writer_flush(k_timeout_t timeout)
+{
+    k_timepoint_t end = sys_timepoint_calc(timeout);
+    struct page *p;
+
+    k_mutex_lock(&fill_mutex, K_FOREVER);
+    p = &pages[fill];
+    if (!atomic_get(&p->full) && p->used > REC_PAGE_HDR_SIZE) {
+        seal(p);
+    }
+    k_mutex_unlock(&fill_mutex);
+
+    for (size_t i = 0; i < ARRAY_SIZE(pages); i++) {
+        while (atomic_get(&pages[i].full)) {
+            if (k_sem_take(&written_sem, sys_timepoint_timeout(end)) != 0) {
+                return -EAGAIN;
+            }
+        }
+    }
+    return 0;
+}
+
+/* Find the page following the newest one and the next sequence number */
+static void scan(const struct flash_area *fa, uint32_t num_pages,
+                 uint32_t *page, uint32_t *seq)
+{
+    uint8_t buf[REC_PAGE_HDR_SIZE];
+    struct rec_page_hdr hdr;
+    bool found = false;
+
+    *page = 0;
+    *seq = 0;
+    for (uint32_t i = 0; i < num_pages; i++) {
+        if (flash_area_read(fa, (off_t)i * REC_PAGE_SIZE, buf, sizeof(buf)) ||
+            rec_page_hdr_get(buf, &hdr)) {
+            continue;
+        }
+        if (!found || (int32_t)(hdr.seq - *seq) >= 0) {
+            found = true;
+            *seq = hdr.seq + 1;
+            *page = (i + 1) % num_pages;
+        }
+    }
+}
+
+static int encrypt_page(const struct rec_page_hdr *hdr, struct page *p)
+{
+    const size_t len = REC_PAGE_SIZE - REC_PAGE_HDR_SIZE;
+    int64_t start = timebase_now_us();
+    uint32_t elapsed_us;
+    int ret;
+
+    ret = rec_crypto_page(hdr, p->data + REC_PAGE_HDR_SIZE, len);
+    elapsed_us = (uint32_t)(timebase_now_us() - start);
+    stats.max_encrypt_us = MAX(stats.max_encrypt_us, elapsed_us);
+    stats.encrypt_us += elapsed_us;
+    stats.encrypt_bytes += len;
+    return ret;
+}
+
+static int erase_page(const struct flash_area *fa, uint32_t page)
+{
+    int64_t start = timebase_now_us();
+    int ret;
+
+    ret = flash_area_erase(fa, (off_t)page * REC_PAGE_SIZE, REC_PAGE_SIZE);
+    stats.max_erase_us =
+        MAX(stats.max_erase_us, (uint32_t)(timebase_now_us() - start));
+    return ret;
+}
+
+static void writer_thread(void)
+{
+    const struct flash_area *fa;
+    uint32_t num_pages;
+    uint32_t page;
+    uint32_t seq;
+    uint8_t nonce[REC_NONCE_SIZE] = {0};
+    int drain = 0;
+    int ret;
+
+    if (IS_ENABLED(CONFIG_APP_RECORDER_ENCRYPT) && rec_crypto_init(nonce) < 0) {
+        /* Never store patient data in plain text */
+        LOG_ERR("encryption unavailable, recording disabled");
+        return;
+    }
+
+    ret = flash_area_open(RECORDER_PARTITION, &fa);
+    if (ret < 0) {
+        LOG_ERR("recorder partition: %d", ret);
+        return;
+    }
+
+    num_pages = fa->fa_size / REC_PAGE_SIZE;
+    scan(fa, num_pages, &page, &seq);
+    LOG_INF("recorder: %u pages, resuming at page %u seq %u", num_pages,
+            page, seq);
+    if (erase_page(fa, page) < 0) {
+        LOG_ERR("erase page %u failed", page);
+    }
+    boot_time_mark(BOOT_MARK_STORAGE);
+
+    while (1) {
+        struct page *p = &pages[drain];
+        struct rec_page_hdr hdr = {
+            .magic = REC_PAGE_MAGIC,
+            .seq = seq,
+            .fs_hz = PIPELINE_SAMPLE_RATE_HZ,
+        };
+        int64_t start;
+
+        k_sem_take(&sealed_sem, K_FOREVER);
+
+        if (IS_ENABLED(CONFIG_APP_RECORDER_ENCRYPT)) {
+            hdr.flags |= REC_PAGE_FLAG_ENCRYPTED;
+            memcpy(hdr.nonce, nonce, sizeof(hdr.nonce));
+        }
+        rec_page_baseline_set(&hdr, p->baseline);
+        rec_page_hdr_put(p->data, &hdr);
+
+        if (IS_ENABLED(CONFIG_APP_RECORDER_ENCRYPT) &&
+            encrypt_page(&hdr, p) < 0) {
+            ret = -EIO;
+        } else {
+            start = timebase_now_us();
+            ret = flash_area_write(fa, (off_t)page * REC_PAGE_SIZE, p->data,
+                                   REC_PAGE_SIZE);
+            stats.max_program_us = MAX(stats.max_program_us,
+                                       (uint32_t)(timebase_now_us() - start));
+        }
+        if (ret < 0) {
+            LOG_ERR("write page %u failed: %d", page, ret);
+        } else {
+            stats.pages_written++;
+        }
+
+        p->used = 0;
+        atomic_clear(&p->full);
+        k_sem_give(&written_sem);
+        drain = (drain + 1) % ARRAY_SIZE(pages);
+
+        page = (page + 1) % num_pages;
+        seq++;
+        /* Erase ahead, the oldest page of the ring is overwritten */
+        if (erase_page(fa, page) < 0) {
+            LOG_ERR("erase page %u failed", page);
+        }
+    }
+}
+
+K_THREAD_DEFINE(flash_writer, WRITER_STACK_SIZE, writer_thread, NULL, NULL,
+                NULL, WRITER_PRIORITY, 0, 0);
+
+void flash_writer_stats_get(struct flash_writer_stats *out)
+{
+    *out = stats;
+}
+
+static void mbedtls_heap_log(void)
+{
+#ifdef CONFIG_MBEDTLS_MEMORY_DEBUG
+    size_t used;
+    size_t blocks;
+
+    mbedtls_memory_buffer_alloc_max_get(&used, &blocks);
+    LOG_INF("recorder: mbedTLS heap peak %u of %u B, %u blocks",
+            (uint32_t)used, CONFIG_MBEDTLS_HEAP_SIZE, (uint32_t)blocks);
+#endif
+}
+
+void flash_writer_stats_log(void)
+{
+    struct flash_writer_stats s;
+
+    flash_writer_stats_get(&s);
+    LOG_INF("recorder: %u pages, %u frames dropped, append max %u us, "
+            "program max %u us, erase max %u us",
+            s.pages_written, s.frames_dropped, s.max_append_us,
+            s.max_program_us, s.max_erase_us);
+    if (IS_ENABLED(CONFIG_APP_RECORDER_ENCRYPT) && s.encrypt_us > 0) {
+        LOG_INF("recorder: encrypt max %u us/page, %u KB/s", s.max_encrypt_us,
+                (uint32_t)(s.encrypt_bytes * USEC_PER_SEC / 1024 / s.encrypt_us));
+    }
+    mbedtls_heap_log();
+}
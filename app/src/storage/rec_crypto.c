@@ -0,0 +1,152 @@
+#include <errno.h>
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/logging/log.h>
+
+#include <psa/crypto.h>
+
+#include "rec_crypto.h"
+
+LOG_MODULE_REGISTER(rec_crypto, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define REC_KEY_ID   ((psa_key_id_t)(PSA_KEY_ID_USER_MIN + 0x100))
+#define REC_KEY_BITS 128
+
+static psa_key_id_t key_id = PSA_KEY_ID_NULL;
+static K_SEM_DEFINE(provisioned_sem, 0, 1);
+
+int rec_crypto_provision(const uint8_t key[REC_KEY_SIZE])
+{
+    psa_key_attributes_t attr = PSA_KEY_ATTRIBUTES_INIT;
+    psa_key_id_t id;
+    psa_status_t status;
+
+    status = psa_crypto_init();
+    if (status != PSA_SUCCESS) {
+        LOG_ERR("psa_crypto_init: %d", status);
+        return -EIO;
+    }
+
+    psa_set_key_id(&attr, REC_KEY_ID);
+    psa_set_key_lifetime(&attr, PSA_KEY_LIFETIME_PERSISTENT);
+    /* CTR decrypts by encrypting, and the backend already has the key */
+    psa_set_key_usage_flags(&attr, PSA_KEY_USAGE_ENCRYPT);
+    psa_set_key_algorithm(&attr, PSA_ALG_CTR);
+    psa_set_key_type(&attr, PSA_KEY_TYPE_AES);
+    psa_set_key_bits(&attr, REC_KEY_BITS);
+
+    status = psa_import_key(&attr, key, REC_KEY_SIZE, &id);
+    if (status == PSA_ERROR_ALREADY_EXISTS) {
+        return -EEXIST;
+    }
+    if (status != PSA_SUCCESS) {
+        LOG_ERR("recorder key import: %d", status);
+        return -EIO;
+    }
+    LOG_INF("recorder key provisioned");
+    k_sem_give(&provisioned_sem);
+    return 0;
+}
+
+int rec_crypto_init(uint8_t nonce[REC_NONCE_SIZE])
+{
+    psa_key_attributes_t attr = PSA_KEY_ATTRIBUTES_INIT;
+    psa_key_usage_t usage = 0;
+    psa_status_t status;
+
+    status = psa_crypto_init();
+    if (status != PSA_SUCCESS) {
+        LOG_ERR("psa_crypto_init: %d", status);
+        return -EIO;
+    }
+
+    status = psa_get_key_attributes(REC_KEY_ID, &attr);
+    if (status == PSA_SUCCESS) {
+        usage = psa_get_key_usage_flags(&attr);
+    }
+    psa_reset_key_attributes(&attr);
+    /* Generated on the device by older firmware, it never left it */
+    if (status == PSA_SUCCESS && (usage & PSA_KEY_USAGE_EXPORT)) {
+        LOG_WRN("dropping the recorder key generated on the device");
+        status = psa_destroy_key(REC_KEY_ID);
+        if (status != PSA_SUCCESS) {
+            LOG_ERR("recorder key: %d", status);
+            return -EIO;
+        }
+        status = PSA_ERROR_INVALID_HANDLE;
+    }
+    if (status != PSA_SUCCESS) {
+        LOG_WRN("recorder key not provisioned, recording waits for it");
+        k_sem_take(&provisioned_sem, K_FOREVER);
+    }
+    key_id = REC_KEY_ID;
+
+    status = psa_generate_random(nonce, REC_NONCE_SIZE);
+    if (status != PSA_SUCCESS) {
+        LOG_ERR("nonce: %d", status);
+        return -EIO;
+    }
+    return 0;
+}
+
+int rec_crypto_page(const struct rec_page_hdr *hdr, uint8_t *data, size_t len)
+{
+    psa_cipher_operation_t op = PSA_CIPHER_OPERATION_INIT;
+    uint8_t iv[16];
+    size_t out_len = 0;
+    size_t fin_len = 0;
+    psa_status_t status;
+
+    rec_page_iv(iv, hdr);
+
+    status = psa_cipher_encrypt_setup(&op, key_id, PSA_ALG_CTR);
+    if (status == PSA_SUCCESS) {
+        status = psa_cipher_set_iv(&op, iv, sizeof(iv));
+    }
+    if (status == PSA_SUCCESS) {
+        status = psa_cipher_update(&op, data, len, data, len, &out_len);
+    }
+    if (status == PSA_SUCCESS) {
+        status = psa_cipher_finish(&op, data + out_len, len - out_len,
+                                   &fin_len);
+    }
+    if (status != PSA_SUCCESS) {
+        psa_cipher_abort(&op);
+        LOG_ERR("page %u: %d", hdr->seq, status);
+        return -EIO;
+    }
+    return 0;
+}
+
+#ifdef CONFIG_APP_RECORDER_KEY_BLE
+static ssize_t key_write(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                         const void *buf, uint16_t len, uint16_t offset,
+                         uint8_t flags)
+{
+    int ret;
+
+    ARG_UNUSED(conn);
+    ARG_UNUSED(attr);
+    ARG_UNUSED(flags);
+
+    if (offset != 0 || len != REC_KEY_SIZE) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+    ret = rec_crypto_provision(buf);
+    if (ret == -EEXIST) {
+        return BT_GATT_ERR(BT_ATT_ERR_WRITE_NOT_PERMITTED);
+    }
+    if (ret < 0) {
+        return BT_GATT_ERR(BT_ATT_ERR_UNLIKELY);
+    }
+    return len;
+}
+
+/* Writable only over an authenticated LE Secure Connections link */
+BT_GATT_SERVICE_DEFINE(rec_key_svc,
+                       BT_GATT_PRIMARY_SERVICE(BT_UUID_REC_KEY_SERVICE),
+                       BT_GATT_CHARACTERISTIC(BT_UUID_REC_KEY,
+                                              BT_GATT_CHRC_WRITE,
+                                              BT_GATT_PERM_WRITE_LESC, NULL,
+                                              key_write, NULL));
+#endif
@@ -0,0 +1,38 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "dsp/ecg_codec.h"
+#include "dsp/rec_format.h"
+#include "flash_writer.h"
+#include "recorder.h"
+
+LOG_MODULE_REGISTER(recorder, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define FRAME_MAX ECG_CODEC_MAX_SIZE(PIPELINE_BLOCK_SAMPLES * PIPELINE_LEADS)
+
+BUILD_ASSERT(FRAME_MAX <= REC_PAGE_SIZE - REC_PAGE_HDR_SIZE,
+             "a block of all leads must fit a recorder page");
+
+static uint8_t frame[FRAME_MAX];
+
+void recorder_put(const struct sample_block *block)
+{
+    const struct ecg_codec_frame f = {
+        .seq = block->seq,
+        .timestamp_us = block->timestamp_us,
+        .count = block->count,
+        .leads = PIPELINE_LEADS,
+    };
+    size_t len;
+
+    len = ecg_codec_encode_strided(&f, &block->samples[0][0], SAMPLE_STRIDE,
+                                   frame, sizeof(frame));
+    if (flash_writer_append(frame, len) == -EINVAL) {
+        LOG_ERR("frame of %zu bytes does not fit a page", len);
+    }
+}
+
+void recorder_set_baseline(uint16_t baseline_cutoff_chz)
+{
+    flash_writer_set_baseline(baseline_cutoff_chz);
+}
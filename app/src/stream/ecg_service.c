@@ -0,0 +1,92 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+
+#include "block_pool.h"
+#include "blocks.h"
+#include "dsp/ecg_codec.h"
+#include "ecg_service.h"
+
+LOG_MODULE_REGISTER(ecg_service, CONFIG_LOG_DEFAULT_LEVEL);
+
+BUILD_ASSERT(ECG_CODEC_MAX_SIZE(PIPELINE_BLOCK_SAMPLES) <=
+                 CONFIG_APP_PACKET_SIZE,
+             "an encoded block must fit one packet");
+
+#define STREAM_STACK_SIZE 1024
+#define STREAM_PRIORITY   K_PRIO_PREEMPT(6)
+
+static K_FIFO_DEFINE(stream_fifo);
+static atomic_t subscribed;
+
+static uint32_t notified;
+static uint32_t dropped;
+static uint32_t notify_errors;
+
+static void ccc_changed(const struct bt_gatt_attr *attr, uint16_t value)
+{
+    ARG_UNUSED(attr);
+
+    atomic_set(&subscribed, value == BT_GATT_CCC_NOTIFY);
+    LOG_INF("ECG stream %s", value == BT_GATT_CCC_NOTIFY ? "on" : "off");
+}
+
+BT_GATT_SERVICE_DEFINE(ecg_svc, BT_GATT_PRIMARY_SERVICE(BT_UUID_ECG_SERVICE),
+                       BT_GATT_CHARACTERISTIC(BT_UUID_ECG_STREAM,
+                                              BT_GATT_CHRC_NOTIFY,
+                                              BT_GATT_PERM_NONE, NULL, NULL,
+                                              NULL),
+                       BT_GATT_CCC(ccc_changed,
+                                   BT_GATT_PERM_READ | BT_GATT_PERM_WRITE));
+
+void ecg_service_put(const struct sample_block *block)
+{
+    const struct ecg_codec_frame f = {
+        .seq = block->seq,
+        .timestamp_us = block->timestamp_us,
+        .count = block->count,
+    };
+    struct enc_packet *pkt;
+
+    if (!atomic_get(&subscribed)) {
+        return;
+    }
+
+    pkt = block_pool_alloc(BLOCK_POOL_PACKETS, K_NO_WAIT);
+    if (pkt == NULL) {
+        dropped++;
+        return;
+    }
+    /* BLE carries the primary lead only, all leads go to flash and wire */
+    pkt->len = ecg_codec_encode(&f, block->samples[0], pkt->data,
+                                sizeof(pkt->data));
+    k_fifo_put(&stream_fifo, pkt);
+}
+
+static void stream_thread(void)
+{
+    while (1) {
+        struct enc_packet *pkt = k_fifo_get(&stream_fifo, K_FOREVER);
+        int err;
+
+        /* Waits for a TX buffer, the packet pool absorbs the backlog */
+        err = bt_gatt_notify(NULL, &ecg_svc.attrs[1], pkt->data, pkt->len);
+        if (err == 0) {
+            notified++;
+        } else {
+            notify_errors++;
+        }
+        block_pool_free(BLOCK_POOL_PACKETS, pkt);
+    }
+}
+
+K_THREAD_DEFINE(ecg_stream, STREAM_STACK_SIZE, stream_thread, NULL, NULL,
+                NULL, STREAM_PRIORITY, 0, 0);
+
+void ecg_service_stats_log(void)
+{
+    LOG_INF("stream: %u notified, %u dropped, %u failed", notified, dropped,
+            notify_errors);
+}
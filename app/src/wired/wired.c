@@ -0,0 +1,237 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/spinlock.h>
+
+#include "blocks.h"
+#include "dsp/ecg_codec.h"
+#include "dsp/wire_frame.h"
+#include "wired.h"
+
+LOG_MODULE_REGISTER(wired, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define PAYLOAD_MAX                                                            \
+    ECG_CODEC_MAX_SIZE(PIPELINE_BLOCK_SAMPLES * PIPELINE_LEADS)
+#define FRAME_MAX WIRE_FRAME_SIZE(PAYLOAD_MAX)
+
+BUILD_ASSERT(PAYLOAD_MAX <= WIRE_PAYLOAD_MAX);
+BUILD_ASSERT(FRAME_MAX <= CONFIG_APP_WIRED_BUF_SIZE,
+             "a frame must fit a TX buffer");
+
+static const struct device *const uart =
+    DEVICE_DT_GET(DT_CHOSEN(kardio_wire_uart));
+
+/*
+ * Two buffers: one is filled by wired_put(), the other is on the wire.
+ * They swap when the transfer completes and the filling one has data.
+ * While wired_put() encodes into a reserved slot the filling buffer is
+ * pinned: a transfer that completes meanwhile leaves it for the commit.
+ */
+static uint8_t bufs[2][CONFIG_APP_WIRED_BUF_SIZE] __aligned(4);
+static size_t fill_len;
+static uint8_t fill_idx;
+static bool reserved;
+static bool busy;
+static bool ready;
+static bool use_async;
+static struct k_spinlock lock;
+
+/* Transfer in progress; position within it for interrupt driven TX */
+static size_t tx_len;
+static const uint8_t *irq_data;
+static size_t irq_len;
+
+static uint64_t bytes_sent;
+static uint32_t frames;
+static uint32_t dropped;
+static uint32_t tx_errors;
+static uint32_t put_us_max;
+static uint64_t put_us_total;
+
+static int tx_start(const uint8_t *data, size_t len)
+{
+    tx_len = len;
+    if (use_async) {
+        return uart_tx(uart, data, len, SYS_FOREVER_US);
+    }
+    irq_data = data;
+    irq_len = len;
+    uart_irq_tx_enable(uart);
+    return 0;
+}
+
+/* Called with the lock held: put the filling buffer on the wire */
+static void tx_next_locked(void)
+{
+    if (tx_start(bufs[fill_idx], fill_len) != 0) {
+        /*
+         * Nothing is on the wire and no TX_DONE will come: the buffer
+         * stays the filling one, the next wired_put() retries.
+         */
+        busy = false;
+        tx_errors++;
+        return;
+    }
+    busy = true;
+    fill_idx ^= 1;
+    fill_len = 0;
+}
+
+/* Called with the lock held once the buffer on the wire is out */
+static void tx_done_locked(size_t len)
+{
+    bytes_sent += len;
+    if (fill_len == 0 || reserved) {
+        busy = false;
+        return;
+    }
+    tx_next_locked();
+}
+
+static void uart_async_cb(const struct device *dev, struct uart_event *evt,
+                          void *user_data)
+{
+    ARG_UNUSED(dev);
+    ARG_UNUSED(user_data);
+
+    switch (evt->type) {
+    case UART_TX_DONE:
+    case UART_TX_ABORTED:
+        K_SPINLOCK(&lock) {
+            tx_done_locked(evt->data.tx.len);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void uart_irq_cb(const struct device *dev, void *user_data)
+{
+    ARG_UNUSED(user_data);
+
+    while (uart_irq_update(dev) && uart_irq_tx_ready(dev)) {
+        int n;
+
+        if (irq_len == 0) {
+            uart_irq_tx_disable(dev);
+            break;
+        }
+        n = uart_fifo_fill(dev, irq_data, irq_len);
+        if (n <= 0) {
+            break;
+        }
+        irq_data += n;
+        irq_len -= n;
+        if (irq_len > 0) {
+            continue;
+        }
+
+        uart_irq_tx_disable(dev);
+        K_SPINLOCK(&lock) {
+            tx_done_locked(tx_len);
+        }
+    }
+}
+
+void wired_put(const struct sample_block *block)
+{
+    const struct ecg_codec_frame f = {
+        .seq = block->seq,
+        .timestamp_us = block->timestamp_us,
+        .count = block->count,
+        .leads = PIPELINE_LEADS,
+    };
+    uint32_t start = k_cycle_get_32();
+    uint32_t put_us;
+    uint8_t *out = NULL;
+    uint8_t *payload;
+    size_t len;
+
+    if (!ready) {
+        return;
+    }
+
+    /*
+     * Only reserve room under the lock: it masks interrupts, and encoding
+     * a multi-lead block there would hold off the BLE and UART ISRs.
+     */
+    K_SPINLOCK(&lock) {
+        if (CONFIG_APP_WIRED_BUF_SIZE - fill_len < FRAME_MAX) {
+            /* Link slower than the blocks, or a failed start to retry */
+            dropped++;
+            if (!busy && fill_len > 0) {
+                tx_next_locked();
+            }
+        } else {
+            out = &bufs[fill_idx][fill_len];
+            reserved = true;
+        }
+    }
+    if (out != NULL) {
+        /* Encode in place behind the header, no intermediate copy */
+        payload = out + WIRE_HDR_SIZE;
+        len = ecg_codec_encode_strided(&f, &block->samples[0][0],
+                                       SAMPLE_STRIDE, payload, PAYLOAD_MAX);
+        wire_frame_hdr(out, WIRE_TYPE_ECG, 0, (uint16_t)len);
+        wire_frame_crc(payload + len, out, payload, (uint16_t)len);
+
+        K_SPINLOCK(&lock) {
+            reserved = false;
+            fill_len += WIRE_FRAME_SIZE(len);
+            frames++;
+            if (!busy) {
+                tx_next_locked();
+            }
+        }
+    }
+
+    put_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+    put_us_max = MAX(put_us_max, put_us);
+    put_us_total += put_us;
+}
+
+void wired_stats_log(void)
+{
+    static uint64_t last_bytes;
+    static int64_t last_ms;
+    int64_t now_ms = k_uptime_get();
+    uint64_t sent = bytes_sent;
+
+    LOG_INF("wired: %u frames, %u dropped, %u errors, %u B/s, "
+            "put %u us avg %u us max",
+            frames, dropped, tx_errors,
+            now_ms > last_ms ? (uint32_t)((sent - last_bytes) * MSEC_PER_SEC /
+                                          (now_ms - last_ms))
+                             : 0,
+            frames > 0 ? (uint32_t)(put_us_total / frames) : 0, put_us_max);
+    last_bytes = sent;
+    last_ms = now_ms;
+}
+
+static int wired_init(void)
+{
+    if (!device_is_ready(uart)) {
+        LOG_ERR("%s is not ready", uart->name);
+        return -ENODEV;
+    }
+
+    /* DMA where the driver has it, TX interrupt otherwise (CDC ACM) */
+    use_async = IS_ENABLED(CONFIG_UART_ASYNC_API) &&
+                uart_callback_set(uart, uart_async_cb, NULL) == 0;
+    if (!use_async) {
+        if (!IS_ENABLED(CONFIG_UART_INTERRUPT_DRIVEN) ||
+            uart_irq_callback_user_data_set(uart, uart_irq_cb, NULL) != 0) {
+            LOG_ERR("%s: neither async nor interrupt driven", uart->name);
+            return -ENOTSUP;
+        }
+    }
+    ready = true;
+    LOG_INF("wired output on %s (%s)", uart->name,
+            use_async ? "async" : "interrupt");
+    return 0;
+}
+
+SYS_INIT(wired_init, APPLICATION, 10);
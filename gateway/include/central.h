@@ -0,0 +1,16 @@
+#ifndef GATEWAY_CENTRAL_H_
+#define GATEWAY_CENTRAL_H_
+
+/**
+ * Central role: scan for straps advertising the ECG service, connect up
+ * to CONFIG_BT_MAX_CONN of them and subscribe to their ECG streams.
+ */
+int central_init(void);
+
+/**
+ * Log per-strap and fleet statistics: frames, bytes, lost frames (from
+ * gaps in the block sequence) and delivery latency.
+ */
+void central_stats_log(void);
+
+#endif /* GATEWAY_CENTRAL_H_ */
@@ -0,0 +1,22 @@
+#ifndef GATEWAY_WIRE_OUT_H_
+#define GATEWAY_WIRE_OUT_H_
+
+#include <stdint.h>
+
+/**
+ * Framed output of all strap streams on the kardio,wire-uart chosen
+ * device (USB CDC ACM or a UART), see dsp/wire_frame.h.
+ *
+ * Frames are queued whole into a ring buffer drained by the UART TX
+ * interrupt. A frame that does not fit is dropped and counted, never
+ * truncated.
+ */
+int wire_out_init(void);
+
+/** Queue one frame, callable from any thread. */
+int wire_out_send(uint8_t type, uint8_t src, const uint8_t *payload,
+                  uint16_t len);
+
+void wire_out_stats_log(void);
+
+#endif /* GATEWAY_WIRE_OUT_H_ */
@@ -0,0 +1,381 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/logging/log.h>
+
+#include "central.h"
+#include "dsp/ecg_codec.h"
+#include "dsp/wire_frame.h"
+#include "ecg_service.h"
+#include "wire_out.h"
+
+LOG_MODULE_REGISTER(central, CONFIG_LOG_DEFAULT_LEVEL);
+
+/* Strap blocks are 50 samples, leave room for larger configurations */
+#define FRAME_SAMPLES_MAX 200
+
+#define SUPERVISION_TIMEOUT 400
+
+/* One shared interval holding a slot per strap, in 1.25 ms units */
+#define CONN_INTERVAL                                                          \
+    MAX(6, DIV_ROUND_UP(CONFIG_GW_MAX_STRAPS * CONFIG_GW_STRAP_SLOT_US, 1250))
+
+struct strap_stats {
+    uint32_t frames;
+    uint32_t lost;
+    uint32_t invalid;
+    uint64_t bytes;
+    uint64_t latency_us_total;
+    uint32_t latency_us_count;
+    uint32_t latency_us_max;
+};
+
+struct strap {
+    bt_addr_le_t addr;
+    bool used;
+    struct bt_conn *conn;
+    struct bt_gatt_exchange_params mtu;
+    struct bt_gatt_discover_params disc;
+    struct bt_gatt_subscribe_params sub;
+    uint32_t next_seq;
+    bool have_seq;
+    struct strap_stats stats;
+};
+
+static struct strap straps[CONFIG_BT_MAX_CONN];
+static struct bt_conn *connecting;
+
+static uint64_t last_log_bytes;
+static int64_t last_log_ms;
+
+static void scan_start(void);
+
+static struct strap *strap_find(const struct bt_conn *conn)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(straps); i++) {
+        if (straps[i].conn == conn) {
+            return &straps[i];
+        }
+    }
+    return NULL;
+}
+
+/* The slot a strap had before, else a fresh one, else any idle one */
+static struct strap *strap_slot(const bt_addr_le_t *addr)
+{
+    struct strap *fresh = NULL;
+    struct strap *idle = NULL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(straps); i++) {
+        struct strap *s = &straps[i];
+
+        if (s->conn != NULL) {
+            continue;
+        }
+        if (s->used && bt_addr_le_eq(&s->addr, addr)) {
+            return s;
+        }
+        if (!s->used && fresh == NULL) {
+            fresh = s;
+        }
+        if (idle == NULL) {
+            idle = s;
+        }
+    }
+    return fresh != NULL ? fresh : idle;
+}
+
+static bool strap_connected(const bt_addr_le_t *addr)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(straps); i++) {
+        if (straps[i].conn != NULL && bt_addr_le_eq(&straps[i].addr, addr)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint8_t notify_func(struct bt_conn *conn,
+                           struct bt_gatt_subscribe_params *params,
+                           const void *data, uint16_t length)
+{
+    static int32_t samples[FRAME_SAMPLES_MAX];
+    struct strap *s = CONTAINER_OF(params, struct strap, sub);
+    struct ecg_codec_frame f;
+    int64_t last_sample_us;
+    int64_t latency_us;
+
+    ARG_UNUSED(conn);
+
+    if (data == NULL) {
+        LOG_INF("strap %u unsubscribed", (unsigned int)(s - straps));
+        params->value_handle = 0;
+        return BT_GATT_ITER_STOP;
+    }
+
+    s->stats.bytes += length;
+    if (ecg_codec_decode(data, length, &f, samples, ARRAY_SIZE(samples)) < 0) {
+        s->stats.invalid++;
+        return BT_GATT_ITER_CONTINUE;
+    }
+    s->stats.frames++;
+    wire_out_send(WIRE_TYPE_ECG, (uint8_t)(s - straps), data, length);
+
+    if (s->have_seq && f.seq != s->next_seq) {
+        /* Restarts (seq going back) are not counted as loss */
+        if (f.seq > s->next_seq) {
+            s->stats.lost += f.seq - s->next_seq;
+        }
+    }
+    s->next_seq = f.seq + 1;
+    s->have_seq = true;
+
+    /*
+     * Strap and gateway uptimes share an origin only in simulation, where
+     * all devices boot at the same instant; on air this is a relative
+     * figure.
+     */
+    last_sample_us = f.timestamp_us + (int64_t)f.count * USEC_PER_SEC /
+                                          CONFIG_GW_STRAP_SAMPLE_RATE_HZ;
+    latency_us = k_ticks_to_us_floor64(k_uptime_ticks()) - last_sample_us;
+    if (latency_us > 0) {
+        s->stats.latency_us_total += latency_us;
+        s->stats.latency_us_count++;
+        s->stats.latency_us_max =
+            MAX(s->stats.latency_us_max, (uint32_t)MIN(latency_us, UINT32_MAX));
+    }
+    return BT_GATT_ITER_CONTINUE;
+}
+
+static uint8_t discover_func(struct bt_conn *conn,
+                             const struct bt_gatt_attr *attr,
+                             struct bt_gatt_discover_params *params)
+{
+    struct strap *s = CONTAINER_OF(params, struct strap, disc);
+    const struct bt_gatt_chrc *chrc;
+    int err;
+
+    if (attr == NULL) {
+        LOG_WRN("strap %u: no ECG stream characteristic",
+                (unsigned int)(s - straps));
+        bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+        return BT_GATT_ITER_STOP;
+    }
+
+    chrc = attr->user_data;
+    s->sub.notify = notify_func;
+    s->sub.value = BT_GATT_CCC_NOTIFY;
+    s->sub.value_handle = chrc->value_handle;
+    /* The strap declares the CCC right after the characteristic value */
+    s->sub.ccc_handle = chrc->value_handle + 1;
+
+    err = bt_gatt_subscribe(conn, &s->sub);
+    if (err && err != -EALREADY) {
+        LOG_WRN("strap %u: subscribe failed: %d", (unsigned int)(s - straps),
+                err);
+    }
+    return BT_GATT_ITER_STOP;
+}
+
+static void mtu_exchanged(struct bt_conn *conn, uint8_t err,
+                          struct bt_gatt_exchange_params *params)
+{
+    struct strap *s = CONTAINER_OF(params, struct strap, mtu);
+    int ret;
+
+    if (err) {
+        LOG_WRN("strap %u: MTU exchange failed: 0x%02x",
+                (unsigned int)(s - straps), err);
+    }
+
+    s->disc.uuid = BT_UUID_ECG_STREAM;
+    s->disc.func = discover_func;
+    s->disc.start_handle = BT_ATT_FIRST_ATTRIBUTE_HANDLE;
+    s->disc.end_handle = BT_ATT_LAST_ATTRIBUTE_HANDLE;
+    s->disc.type = BT_GATT_DISCOVER_CHARACTERISTIC;
+
+    ret = bt_gatt_discover(conn, &s->disc);
+    if (ret) {
+        LOG_WRN("strap %u: discovery failed: %d", (unsigned int)(s - straps),
+                ret);
+    }
+}
+
+static bool ad_has_ecg_service(struct bt_data *data, void *user_data)
+{
+    static const uint8_t uuid[] = {BT_UUID_ECG_SERVICE_VAL};
+    bool *found = user_data;
+
+    if (data->type != BT_DATA_UUID128_ALL &&
+        data->type != BT_DATA_UUID128_SOME) {
+        return true;
+    }
+    for (size_t i = 0; i + sizeof(uuid) <= data->data_len; i += sizeof(uuid)) {
+        if (memcmp(&data->data[i], uuid, sizeof(uuid)) == 0) {
+            *found = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type,
+                         struct net_buf_simple *ad)
+{
+    const struct bt_le_conn_param *param =
+        BT_LE_CONN_PARAM(CONN_INTERVAL, CONN_INTERVAL, 0, SUPERVISION_TIMEOUT);
+    bool found = false;
+    int err;
+
+    ARG_UNUSED(rssi);
+
+    if (type != BT_GAP_ADV_TYPE_ADV_IND || connecting != NULL ||
+        strap_connected(addr)) {
+        return;
+    }
+    bt_data_parse(ad, ad_has_ecg_service, &found);
+    if (!found || bt_le_scan_stop() != 0) {
+        return;
+    }
+
+    err = bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN, param, &connecting);
+    if (err) {
+        LOG_WRN("Create connection failed: %d", err);
+        scan_start();
+    }
+}
+
+static void scan_start(void)
+{
+    int err;
+
+    if (connecting != NULL || strap_slot(BT_ADDR_LE_ANY) == NULL) {
+        return;
+    }
+    err = bt_le_scan_start(BT_LE_SCAN_PASSIVE, device_found);
+    if (err && err != -EALREADY) {
+        LOG_ERR("Scanning failed to start: %d", err);
+    }
+}
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+    struct strap *s;
+
+    if (conn != connecting) {
+        return;
+    }
+    connecting = NULL;
+
+    if (err) {
+        LOG_WRN("Connection failed: 0x%02x", err);
+        bt_conn_unref(conn);
+        scan_start();
+        return;
+    }
+
+    s = strap_slot(bt_conn_get_dst(conn));
+    if (!s->used || !bt_addr_le_eq(&s->addr, bt_conn_get_dst(conn))) {
+        /* An idle slot handed to another strap starts its counters over */
+        last_log_bytes -= MIN(last_log_bytes, s->stats.bytes);
+        memset(&s->stats, 0, sizeof(s->stats));
+    }
+    s->conn = conn;
+    s->addr = *bt_conn_get_dst(conn);
+    s->used = true;
+    s->have_seq = false;
+    LOG_INF("strap %u connected", (unsigned int)(s - straps));
+
+    s->mtu.func = mtu_exchanged;
+    if (bt_gatt_exchange_mtu(conn, &s->mtu) != 0) {
+        mtu_exchanged(conn, BT_ATT_ERR_UNLIKELY, &s->mtu);
+    }
+    scan_start();
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    struct strap *s = strap_find(conn);
+
+    if (s == NULL) {
+        return;
+    }
+    LOG_INF("strap %u disconnected: 0x%02x", (unsigned int)(s - straps),
+            reason);
+    bt_conn_unref(s->conn);
+    s->conn = NULL;
+    scan_start();
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+};
+
+int central_init(void)
+{
+    int err = bt_enable(NULL);
+
+    if (err) {
+        LOG_ERR("Bluetooth init failed: %d", err);
+        return err;
+    }
+    LOG_INF("schedule: %u straps x %u us, interval %u us",
+            CONFIG_GW_MAX_STRAPS, CONFIG_GW_STRAP_SLOT_US,
+            CONN_INTERVAL * 1250);
+    last_log_ms = k_uptime_get();
+    scan_start();
+    return 0;
+}
+
+void central_stats_log(void)
+{
+    int64_t now_ms = k_uptime_get();
+    uint32_t connected_count = 0;
+    uint32_t frames = 0;
+    uint32_t lost = 0;
+    uint32_t latency_max = 0;
+    uint64_t bytes = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(straps); i++) {
+        const struct strap *s = &straps[i];
+        const struct strap_stats *st = &s->stats;
+        char addr[BT_ADDR_LE_STR_LEN];
+
+        if (!s->used) {
+            continue;
+        }
+        bt_addr_le_to_str(&s->addr, addr, sizeof(addr));
+        LOG_INF("strap %u %s%s: %u frames, %u lost, %u invalid, %llu B, "
+                "latency avg %u us, max %u us",
+                (unsigned int)i, addr, s->conn != NULL ? "" : " (down)",
+                st->frames, st->lost, st->invalid,
+                (unsigned long long)st->bytes,
+                st->latency_us_count > 0
+                    ? (uint32_t)(st->latency_us_total / st->latency_us_count)
+                    : 0,
+                st->latency_us_max);
+
+        connected_count += s->conn != NULL;
+        frames += st->frames;
+        lost += st->lost;
+        bytes += st->bytes;
+        latency_max = MAX(latency_max, st->latency_us_max);
+    }
+
+    LOG_INF("fleet: %u straps, %u B/s, %u frames, %u lost (%u.%u%%), "
+            "latency max %u us",
+            connected_count,
+            now_ms > last_log_ms
+                ? (uint32_t)((bytes - last_log_bytes) * MSEC_PER_SEC /
+                             (now_ms - last_log_ms))
+                : 0,
+            frames, lost,
+            frames + lost > 0 ? lost * 100 / (frames + lost) : 0,
+            frames + lost > 0 ? lost * 1000 / (frames + lost) % 10 : 0,
+            latency_max);
+    last_log_bytes = bytes;
+    last_log_ms = now_ms;
+}
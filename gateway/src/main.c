@@ -0,0 +1,26 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "central.h"
+#include "wire_out.h"
+
+LOG_MODULE_REGISTER(main, CONFIG_LOG_DEFAULT_LEVEL);
+
+int main(void)
+{
+    int ret = wire_out_init();
+
+    if (ret == 0) {
+        ret = central_init();
+    }
+    if (ret) {
+        return 0;
+    }
+
+    while (1) {
+        k_sleep(K_SECONDS(CONFIG_GW_STATS_INTERVAL_S));
+        central_stats_log();
+        wire_out_stats_log();
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/ring_buffer.h>
+
+#include "dsp/wire_frame.h"
+#include "wire_out.h"
+
+LOG_MODULE_REGISTER(wire_out, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define WIRE_UART_NODE DT_CHOSEN(kardio_wire_uart)
+
+#if DT_NODE_EXISTS(WIRE_UART_NODE)
+static const struct device *const uart = DEVICE_DT_GET(WIRE_UART_NODE);
+#else
+static const struct device *const uart;
+#endif
+
+RING_BUF_DECLARE(tx_ring, CONFIG_GW_WIRE_BUF_SIZE);
+static struct k_spinlock tx_lock;
+
+static uint32_t frames;
+static uint32_t dropped;
+static uint64_t bytes;
+
+static void uart_isr(const struct device *dev, void *user_data)
+{
+    ARG_UNUSED(user_data);
+
+    while (uart_irq_update(dev) && uart_irq_tx_ready(dev)) {
+        uint8_t *data;
+        uint32_t len;
+        int sent;
+
+        K_SPINLOCK(&tx_lock) {
+            len = ring_buf_get_claim(&tx_ring, &data, CONFIG_GW_WIRE_BUF_SIZE);
+            if (len == 0) {
+                uart_irq_tx_disable(dev);
+            }
+        }
+        if (len == 0) {
+            break;
+        }
+        sent = uart_fifo_fill(dev, data, len);
+        K_SPINLOCK(&tx_lock) {
+            ring_buf_get_finish(&tx_ring, MAX(sent, 0));
+        }
+        if (sent <= 0) {
+            break;
+        }
+    }
+}
+
+int wire_out_init(void)
+{
+    if (uart == NULL) {
+        LOG_INF("no kardio,wire-uart, framed output disabled");
+        return 0;
+    }
+    if (!device_is_ready(uart)) {
+        LOG_ERR("%s is not ready", uart->name);
+        return -ENODEV;
+    }
+    return uart_irq_callback_user_data_set(uart, uart_isr, NULL);
+}
+
+int wire_out_send(uint8_t type, uint8_t src, const uint8_t *payload,
+                  uint16_t len)
+{
+    uint8_t hdr[WIRE_HDR_SIZE];
+    uint8_t crc[WIRE_CRC_SIZE];
+    int ret = 0;
+
+    if (uart == NULL) {
+        return -ENODEV;
+    }
+
+    wire_frame_hdr(hdr, type, src, len);
+    wire_frame_crc(crc, hdr, payload, len);
+
+    K_SPINLOCK(&tx_lock) {
+        if (ring_buf_space_get(&tx_ring) < WIRE_FRAME_SIZE(len)) {
+            dropped++;
+            ret = -ENOBUFS;
+            K_SPINLOCK_BREAK;
+        }
+        ring_buf_put(&tx_ring, hdr, sizeof(hdr));
+        ring_buf_put(&tx_ring, payload, len);
+        ring_buf_put(&tx_ring, crc, sizeof(crc));
+        frames++;
+        bytes += WIRE_FRAME_SIZE(len);
+    }
+    if (ret == 0) {
+        uart_irq_tx_enable(uart);
+    }
+    return ret;
+}
+
+void wire_out_stats_log(void)
+{
+    if (uart == NULL) {
+        return;
+    }
+    LOG_INF("wire: %u frames, %llu B, %u dropped, %u B queued", frames,
+            (unsigned long long)bytes, dropped,
+            ring_buf_size_get(&tx_ring));
+}
@@ -0,0 +1,54 @@
+#!/bin/sh
+# Fleet simulation: N straps and one gateway in BabbleSim.
+#
+# Usage: sim/fleet.sh [N ...]        (default: 1 2 5 10 15 20)
+#
+# Needs BSIM_OUT_PATH and BSIM_COMPONENTS_PATH, run from the west
+# workspace. Every strap boots with its own -rs seed, so each gets its own
+# device ID and therefore its own synthetic ECG. The gateway log is kept
+# per run in build/fleet/; the last statistics of every run are collected
+# in build/fleet/summary.csv.
+
+set -eu
+
+: "${BSIM_OUT_PATH:?BabbleSim not set up}"
+SIM_LENGTH_S=${SIM_LENGTH_S:-60}
+TOP=$(cd "$(dirname "$0")/.." && pwd)
+OUT=${TOP}/build/fleet
+COUNTS=${*:-1 2 5 10 15 20}
+
+west build -p auto -b nrf52_bsim --no-sysbuild -d "${OUT}/strap" "${TOP}/app"
+west build -p auto -b nrf52_bsim --no-sysbuild -d "${OUT}/gateway" \
+    "${TOP}/gateway"
+
+STRAP=${OUT}/strap/zephyr/zephyr.exe
+GATEWAY=${OUT}/gateway/zephyr/zephyr.exe
+
+echo "straps,connected,bytes_per_s,frames,lost,loss_pct,latency_max_us" \
+    > "${OUT}/summary.csv"
+
+for n in ${COUNTS}; do
+    sim=kardio_fleet_${n}
+    log=${OUT}/gateway_${n}.log
+
+    (cd "${BSIM_OUT_PATH}/bin" &&
+        ./bs_2G4_phy_v1 -s="${sim}" -D=$((n + 1)) \
+            -sim_length=$((SIM_LENGTH_S * 1000000)) > /dev/null) &
+
+    i=0
+    while [ "${i}" -lt "${n}" ]; do
+        "${STRAP}" -s="${sim}" -d="${i}" -rs=$((i + 1)) > /dev/null &
+        i=$((i + 1))
+    done
+    "${GATEWAY}" -s="${sim}" -d="${n}" -rs=1000 > "${log}" 2>&1 || true
+    wait
+
+    # fleet: 5 straps, 7600 B/s, 2990 frames, 0 lost (0.0%), latency max 61000 us
+    grep "fleet:" "${log}" | tail -n 1 | sed -E \
+        's/.*fleet: ([0-9]+) straps, ([0-9]+) B\/s, ([0-9]+) frames, ([0-9]+) lost \(([0-9.]+)%\), latency max ([0-9]+) us.*/'"${n}"',\1,\2,\3,\4,\5,\6/' \
+        >> "${OUT}/summary.csv"
+    echo "${n} straps:"
+    grep "strap [0-9]* .*frames" "${log}" | tail -n "${n}"
+done
+
+cat "${OUT}/summary.csv"
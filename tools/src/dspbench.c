@@ -0,0 +1,1362 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dsp/biquad.h"
+#include "dsp/ecg_analysis.h"
+#include "dsp/ecg_codec.h"
+#include "dsp/delin.h"
+#include "dsp/ecg_synth.h"
+#include "dsp/hr_fusion.h"
+#include "dsp/hrv.h"
+#include "dsp/mains.h"
+#include "dsp/median.h"
+#include "dsp/pat.h"
+#include "dsp/ppg_synth.h"
+#include "dsp/qrs.h"
+#include "dsp/rec_format.h"
+#include "dsp/sliding.h"
+#include "dsp/soa.h"
+#include "dsp/spectrum.h"
+#include "dsp/spo2.h"
+#include "rec_cipher.h"
+
+/*
+ * Host benchmarks of the firmware DSP code.
+ *
+ * layout: per-block cost of the sample path for several lead counts, with
+ * the samples kept as per-lead rows (as struct sample_block does) against
+ * kept interleaved as the front end delivers them. Stages match the
+ * firmware: unpack the DMA buffer, calibrate, baseline filter and encode
+ * for the recorder.
+ *
+ * delin: per-beat delineation cost and fiducial errors against the known
+ * wave boundaries of the synthetic ECG.
+ *
+ * baseline: per-block cost of baseline wander removal by high-pass, by
+ * the running medians and by sorting every window, and the RMS deviation
+ * of the result from the synthetic ECG without wander (DC aside, which the
+ * high-pass removes from the ECG itself).
+ *
+ * sliding: per-sample cost of window minimum, maximum, mean and variance
+ * by the deque kernels against scanning the window, for windows up to
+ * 8 s at 500 Hz, and the samples where the two disagree.
+ *
+ * mains: synthetic ECG with mains interference at and off the nominal
+ * frequencies, drifting, or none. Reports the tracked frequency, the time
+ * to the first notch, the interference left after the notches and the
+ * per-block cost of estimator and notch, against a fixed 50 Hz notch.
+ *
+ * fft: cost of the portable real FFT and power spectrum for 128 to 4096
+ * points, and the SNR of the bins against a double precision DFT, on
+ * synthetic ECG with noise. The CMSIS-DSP path only runs on target.
+ * Then the frequency domain HRV of RR series with known respiratory
+ * sinus arrhythmia and Mayer waves.
+ *
+ * spo2: emulated red and infrared PPG at 100 Hz over a range of SpO2 and
+ * perfusion. Reports the SpO2, perfusion index and pulse rate found, the
+ * beats rejected and the estimator cost per sample and per second of
+ * signal, the figure the firmware budget is set against.
+ *
+ * pat: synthetic ECG at 500 Hz and PPG whose pulses follow the R peaks
+ * after a known arrival time swinging 210 to 290 ms over a minute, each
+ * in blocks of its own size on one microsecond timebase. R peaks come
+ * from the QRS detector. Reports pairs found, the errors of the arrival
+ * time and of its R peak and foot ends in ms, and the matching and foot
+ * detection cost per beat.
+ *
+ * fusion: eleven minutes of beat to beat heart rate from ECG and PPG
+ * through rest, walking, running and recovery, with the ECG lead off
+ * while running, the ECG noisy with double and missed detections in
+ * recovery, the PPG off at rest, both lost for 20 s and the ECG off again
+ * for a last walk. The PPG jitters with motion
+ * and locks onto the step rate now and then while running, and its beats
+ * arrive later than the ECG ones. Per stretch, reports the seconds the
+ * estimate is valid and each source reliable, then the RMS error against
+ * the heart rate without sinus arrhythmia of each source alone, its last
+ * beat while not stale, and of the estimate, all read once a second at
+ * the seconds the estimate is valid, and the worst estimate error. Then
+ * the beats accepted and rejected per source, the restarts and the cost
+ * per update.
+ *
+ * crypto: AES-128-CTR of recorder pages as the recorder encrypts them,
+ * one keystream per page from its nonce and sequence number, through the
+ * host cipher rec2edf decrypts with. Reports the cost per page and of a
+ * single block, which is the per-page setup, the throughput, and the
+ * pages per hour of the codec stream of one lead at 500 Hz. On target the
+ * same figures are in the recorder statistics.
+ */
+
+#define PI 3.14159265358979323846
+
+#define BLOCK_SAMPLES 50
+#define MAX_LEADS     12
+#define SAMPLE_ALIGN  16
+#define STRIDE        52 /* BLOCK_SAMPLES rounded up to SAMPLE_ALIGN */
+
+enum stage { UNPACK, CALIBRATE, FILTER, ENCODE, STAGES };
+
+static const char *const stage_names[STAGES] = {
+    "unpack", "calibrate", "filter", "encode",
+};
+
+struct layout {
+    const char *name;
+    void (*unpack)(const uint8_t *in, size_t leads, int32_t *x);
+    void (*calibrate)(int32_t *x, size_t leads);
+    void (*filter)(struct biquad *f, int32_t *x, size_t leads);
+    size_t (*encode)(const struct ecg_codec_frame *f, const int32_t *x,
+                     uint8_t *out, size_t cap);
+};
+
+static int32_t gain_q16 = 65536 + 655;
+static int32_t offset_uv = -12;
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void soa_unpack(const uint8_t *in, size_t leads, int32_t *x)
+{
+    soa_unpack_s24be(in, BLOCK_SAMPLES, leads, x, STRIDE);
+}
+
+static void soa_calibrate(int32_t *x, size_t leads)
+{
+    for (size_t l = 0; l < leads; l++) {
+        int32_t *row = x + l * STRIDE;
+
+        for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+            row[i] = (int32_t)(((int64_t)row[i] * gain_q16) >> 16) +
+                     offset_uv;
+        }
+    }
+}
+
+static void soa_filter(struct biquad *f, int32_t *x, size_t leads)
+{
+    for (size_t l = 0; l < leads; l++) {
+        biquad_process(&f[l], x + l * STRIDE, BLOCK_SAMPLES);
+    }
+}
+
+static size_t soa_encode(const struct ecg_codec_frame *f, const int32_t *x,
+                         uint8_t *out, size_t cap)
+{
+    return ecg_codec_encode_strided(f, x, STRIDE, out, cap);
+}
+
+static void aos_unpack(const uint8_t *in, size_t leads, int32_t *x)
+{
+    for (size_t i = 0; i < BLOCK_SAMPLES * leads; i++, in += 3) {
+        uint32_t v = ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) |
+                     ((uint32_t)in[2] << 8);
+
+        x[i] = (int32_t)v >> 8;
+    }
+}
+
+static void aos_calibrate(int32_t *x, size_t leads)
+{
+    for (size_t i = 0; i < BLOCK_SAMPLES * leads; i++) {
+        x[i] = (int32_t)(((int64_t)x[i] * gain_q16) >> 16) + offset_uv;
+    }
+}
+
+static void aos_filter(struct biquad *f, int32_t *x, size_t leads)
+{
+    int32_t row[BLOCK_SAMPLES];
+
+    /* The filter runs along a lead, so every lead is gathered first */
+    for (size_t l = 0; l < leads; l++) {
+        for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+            row[i] = x[i * leads + l];
+        }
+        biquad_process(&f[l], row, BLOCK_SAMPLES);
+        for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+            x[i * leads + l] = row[i];
+        }
+    }
+}
+
+static size_t aos_encode(const struct ecg_codec_frame *f, const int32_t *x,
+                         uint8_t *out, size_t cap)
+{
+    int32_t rows[MAX_LEADS * BLOCK_SAMPLES];
+    size_t leads = f->leads;
+
+    for (size_t l = 0; l < leads; l++) {
+        for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+            rows[l * BLOCK_SAMPLES + i] = x[i * leads + l];
+        }
+    }
+    return ecg_codec_encode(f, rows, out, cap);
+}
+
+static const struct layout layouts[] = {
+    {"soa", soa_unpack, soa_calibrate, soa_filter, soa_encode},
+    {"interleaved", aos_unpack, aos_calibrate, aos_filter, aos_encode},
+};
+
+static void run(const struct layout *lo, size_t leads, const uint8_t *dma,
+                size_t blocks, double *ns)
+{
+    static int32_t x[MAX_LEADS * STRIDE]
+        __attribute__((aligned(SAMPLE_ALIGN)));
+    static uint8_t frame[ECG_CODEC_MAX_SIZE(MAX_LEADS * BLOCK_SAMPLES)];
+    struct biquad f[MAX_LEADS];
+    struct biquad_coeffs c;
+    double t[STAGES] = {0};
+    size_t bytes = 0;
+
+    biquad_highpass(&c, 500, 0.5);
+    for (size_t l = 0; l < leads; l++) {
+        biquad_init(&f[l], &c);
+    }
+
+    for (size_t b = 0; b < blocks; b++) {
+        const struct ecg_codec_frame fr = {
+            .seq = (uint32_t)b,
+            .count = BLOCK_SAMPLES,
+            .leads = (uint8_t)leads,
+        };
+        const uint8_t *in = dma + (b % 64) * BLOCK_SAMPLES * leads * 3;
+        double t0 = now_s(), t1, t2, t3, t4;
+
+        lo->unpack(in, leads, x);
+        t1 = now_s();
+        lo->calibrate(x, leads);
+        t2 = now_s();
+        lo->filter(f, x, leads);
+        t3 = now_s();
+        bytes += lo->encode(&fr, x, frame, sizeof(frame));
+        t4 = now_s();
+
+        t[UNPACK] += t1 - t0;
+        t[CALIBRATE] += t2 - t1;
+        t[FILTER] += t3 - t2;
+        t[ENCODE] += t4 - t3;
+    }
+    for (int s = 0; s < STAGES; s++) {
+        ns[s] = t[s] * 1e9 / (double)blocks;
+    }
+    /* Keep the encoder from being optimized away */
+    if (bytes == 0) {
+        fprintf(stderr, "no output\n");
+    }
+}
+
+static void bench_layout(size_t blocks)
+{
+    static const size_t lead_counts[] = {1, 3, 8, 12};
+    static int32_t rows[MAX_LEADS * STRIDE];
+    static uint8_t dma[64 * BLOCK_SAMPLES * MAX_LEADS * 3];
+    struct ecg_synth synth;
+
+    printf("leads,layout");
+    for (int s = 0; s < STAGES; s++) {
+        printf(",%s_ns", stage_names[s]);
+    }
+    printf(",total_ns\n");
+
+    for (size_t k = 0; k < sizeof(lead_counts) / sizeof(lead_counts[0]);
+         k++) {
+        size_t leads = lead_counts[k];
+
+        /* 64 distinct DMA buffers, leads scaled copies of the synth */
+        ecg_synth_init(&synth, 500, 72, 1);
+        for (size_t b = 0; b < 64; b++) {
+            ecg_synth_fill(&synth, rows, BLOCK_SAMPLES);
+            for (size_t l = 1; l < leads; l++) {
+                for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+                    rows[l * STRIDE + i] = rows[i] * (int32_t)(l + 1) / 4;
+                }
+            }
+            soa_pack_s24be(rows, BLOCK_SAMPLES, leads, STRIDE,
+                           dma + b * BLOCK_SAMPLES * leads * 3);
+        }
+
+        for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) {
+            double ns[STAGES], total = 0;
+
+            run(&layouts[i], leads, dma, blocks, ns);
+            printf("%zu,%s", leads, layouts[i].name);
+            for (int s = 0; s < STAGES; s++) {
+                printf(",%.0f", ns[s]);
+                total += ns[s];
+            }
+            printf(",%.0f\n", total);
+        }
+    }
+}
+
+/* Wave boundaries of the synthetic beat (ecg_synth.c), ms from the R peak */
+#define SYNTH_P_ON    (-250)
+#define SYNTH_QRS_ON  (-40)
+#define SYNTH_QRS_OFF 42
+#define SYNTH_T_END   340
+
+struct error {
+    double sum;
+    double sq;
+    size_t n;
+};
+
+static void error_add(struct error *e, double v)
+{
+    e->sum += v;
+    e->sq += v * v;
+    e->n++;
+}
+
+static void error_print(const struct error *e)
+{
+    double mean = e->n > 0 ? e->sum / (double)e->n : 0.0;
+    double var = e->n > 0 ? e->sq / (double)e->n - mean * mean : 0.0;
+
+    printf(",%.1f,%.1f", mean, sqrt(var > 0.0 ? var : 0.0));
+}
+
+static void bench_delin(size_t blocks)
+{
+    static const uint32_t rates[] = {250, 500, 1000};
+    static struct qrs q;
+    static struct delin d;
+
+    printf("fs_hz,beats,block_ns,beat_ns,beat_ns_max,p_on_bias,p_on_sd,"
+           "qrs_on_bias,qrs_on_sd,qrs_off_bias,qrs_off_sd,t_end_bias,"
+           "t_end_sd\n");
+
+    for (size_t k = 0; k < sizeof(rates) / sizeof(rates[0]); k++) {
+        uint32_t fs = rates[k];
+        struct error p_on = {0}, qrs_on = {0}, qrs_off = {0}, t_end = {0};
+        struct delin_beat out[DELIN_PENDING];
+        struct ecg_synth synth;
+        struct biquad baseline;
+        struct biquad_coeffs c;
+        double idle = 0, busy = 0, busy_max = 0;
+        size_t idle_blocks = 0, beats = 0;
+        uint64_t last = 0;
+
+        ecg_synth_init(&synth, fs, 72, 1);
+        biquad_highpass(&c, fs, 0.05);
+        biquad_init(&baseline, &c);
+        qrs_init(&q, fs);
+        delin_init(&d, fs);
+
+        for (size_t b = 0; b < blocks; b++) {
+            int32_t x[BLOCK_SAMPLES];
+            uint64_t r[BLOCK_SAMPLES];
+            size_t n, m;
+            double t0, t;
+
+            ecg_synth_fill(&synth, x, BLOCK_SAMPLES);
+            biquad_process(&baseline, x, BLOCK_SAMPLES);
+            n = qrs_process(&q, x, BLOCK_SAMPLES, r, BLOCK_SAMPLES);
+
+            t0 = now_s();
+            for (size_t i = 0; i < n; i++) {
+                delin_add_beat(&d, r[i],
+                               last > 0 ? (uint16_t)((r[i] - last) * 1000 / fs)
+                                        : 0);
+                last = r[i];
+            }
+            m = delin_push(&d, x, BLOCK_SAMPLES, out, DELIN_PENDING);
+            t = now_s() - t0;
+
+            if (m == 0) {
+                idle += t;
+                idle_blocks++;
+                continue;
+            }
+            busy += t;
+            busy_max = t > busy_max ? t : busy_max;
+            for (size_t i = 0; i < m; i++) {
+                error_add(&qrs_on, out[i].qrs_on - SYNTH_QRS_ON);
+                error_add(&qrs_off, out[i].qrs_off - SYNTH_QRS_OFF);
+                if (out[i].flags & DELIN_P_WAVE) {
+                    error_add(&p_on, out[i].p_on - SYNTH_P_ON);
+                }
+                if (out[i].flags & DELIN_T_WAVE) {
+                    error_add(&t_end, out[i].t_end - SYNTH_T_END);
+                }
+            }
+            beats += m;
+        }
+
+        /* A beat costs what its block took above a block without one */
+        idle /= idle_blocks > 0 ? (double)idle_blocks : 1.0;
+        printf("%u,%zu,%.0f,%.0f,%.0f", fs, beats, idle * 1e9,
+               beats > 0 ? (busy / (double)beats - idle) * 1e9 : 0.0,
+               (busy_max - idle) * 1e9);
+        error_print(&p_on);
+        error_print(&qrs_on);
+        error_print(&qrs_off);
+        error_print(&t_end);
+        printf("\n");
+    }
+}
+
+enum baseline_method { HIGHPASS_050, HIGHPASS_005, MEDIAN, MEDIAN_SORT };
+
+static const char *const baseline_names[] = {
+    "highpass-0.5", "highpass-0.05", "median", "median-sort",
+};
+
+static int cmp_i32(const void *a, const void *b)
+{
+    int32_t x = *(const int32_t *)a;
+    int32_t y = *(const int32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* The textbook way: sort a copy of the window for every output sample */
+struct sort_median {
+    int32_t *ring;
+    int32_t *tmp;
+    size_t n;
+    size_t count;
+    size_t pos;
+};
+
+static int32_t sort_median_add(struct sort_median *s, int32_t x)
+{
+    s->ring[s->pos] = x;
+    s->pos = (s->pos + 1) % s->n;
+    s->count += s->count < s->n;
+    memcpy(s->tmp, s->ring, s->count * sizeof(*s->tmp));
+    qsort(s->tmp, s->count, sizeof(*s->tmp), cmp_i32);
+    return s->tmp[s->count / 2];
+}
+
+static void bench_baseline(size_t blocks)
+{
+    static const uint32_t rates[] = {250, 500, 1000};
+
+    printf("fs_hz,method,block_ns,rms_error_uv\n");
+
+    for (size_t k = 0; k < sizeof(rates) / sizeof(rates[0]); k++) {
+        uint32_t fs = rates[k];
+        size_t delay = MEDIAN_BASELINE_DELAY(fs);
+        size_t w1 = MEDIAN_BASELINE_W1(fs), w2 = MEDIAN_BASELINE_W2(fs);
+        size_t words = MEDIAN_BASELINE_WORDS(fs);
+        uint32_t *storage = malloc(words * sizeof(*storage));
+        int32_t *clean = malloc((delay + BLOCK_SAMPLES) * sizeof(*clean));
+
+        for (int method = HIGHPASS_050; method <= MEDIAN_SORT; method++) {
+            /* Sorting is slow enough that a fraction of the run will do */
+            size_t nblocks = method == MEDIAN_SORT ? blocks / 200 + 1 : blocks;
+            struct sort_median s1 = {0}, s2 = {0};
+            struct ecg_synth synth, ref;
+            struct median_baseline mb;
+            struct biquad hp;
+            struct biquad_coeffs c;
+            size_t lag = method >= MEDIAN ? delay : 0;
+            /* Let the 0.05 Hz high-pass settle */
+            size_t skip = (method == HIGHPASS_005 ? 60 : 5) * fs;
+            double t = 0, sum = 0, sq = 0;
+            size_t err_n = 0;
+
+            ecg_synth_init(&synth, fs, 72, 1);
+            ecg_synth_init(&ref, fs, 72, 1);
+            ref.wander_uv = 0;
+            biquad_highpass(&c, fs, method == HIGHPASS_050 ? 0.5 : 0.05);
+            biquad_init(&hp, &c);
+            median_baseline_init(&mb, fs, storage, words);
+            if (method == MEDIAN_SORT) {
+                s1.n = w1;
+                s1.ring = calloc(w1, sizeof(int32_t));
+                s1.tmp = malloc(w1 * sizeof(int32_t));
+                s2.n = w2;
+                s2.ring = calloc(w2, sizeof(int32_t));
+                s2.tmp = malloc(w2 * sizeof(int32_t));
+                mb.delay_pos = 0;
+            }
+            memset(clean, 0, (delay + BLOCK_SAMPLES) * sizeof(*clean));
+
+            for (size_t b = 0; b < nblocks; b++) {
+                int32_t x[BLOCK_SAMPLES];
+                double t0;
+
+                ecg_synth_fill(&synth, x, BLOCK_SAMPLES);
+                /* Clean reference, kept as far back as the filter delay */
+                memmove(clean, clean + BLOCK_SAMPLES, delay * sizeof(*clean));
+                ecg_synth_fill(&ref, clean + delay, BLOCK_SAMPLES);
+
+                t0 = now_s();
+                switch (method) {
+                case HIGHPASS_050:
+                case HIGHPASS_005:
+                    biquad_process(&hp, x, BLOCK_SAMPLES);
+                    break;
+                case MEDIAN:
+                    median_baseline_process(&mb, x, BLOCK_SAMPLES);
+                    break;
+                default:
+                    for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+                        int32_t d = mb.delay[mb.delay_pos];
+                        int32_t m = sort_median_add(&s2,
+                                                    sort_median_add(&s1, x[i]));
+
+                        mb.delay[mb.delay_pos] = x[i];
+                        mb.delay_pos = (mb.delay_pos + 1) % mb.delay_len;
+                        x[i] = d - m;
+                    }
+                    break;
+                }
+                t += now_s() - t0;
+
+                if ((b + 1) * BLOCK_SAMPLES < skip) {
+                    continue;
+                }
+                for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+                    double e = x[i] - clean[delay + i - lag];
+
+                    sum += e;
+                    sq += e * e;
+                    err_n++;
+                }
+            }
+            printf("%u,%s,%.0f,", fs, baseline_names[method],
+                   t * 1e9 / (double)nblocks);
+            if (err_n > 0) {
+                double mean = sum / (double)err_n;
+
+                printf("%.1f\n", sqrt(sq / (double)err_n - mean * mean));
+            } else {
+                printf("\n");
+            }
+            free(s1.ring);
+            free(s1.tmp);
+            free(s2.ring);
+            free(s2.tmp);
+        }
+        free(clean);
+        free(storage);
+    }
+}
+
+static void bench_sliding(size_t blocks)
+{
+    static const uint32_t windows_ms[] = {200, 500, 1000, 2000, 4000, 8000};
+    const uint32_t fs = 500;
+
+    printf("window_ms,window,kernel_ns,scan_ns,mismatches\n");
+
+    for (size_t k = 0; k < sizeof(windows_ms) / sizeof(windows_ms[0]); k++) {
+        size_t n = fs * windows_ms[k] / 1000;
+        uint32_t *storage = malloc(SLIDING_WORDS(n) * sizeof(*storage));
+        int32_t *ring = calloc(n, sizeof(*ring));
+        /* Scanning is O(window), a fraction of the run will do */
+        size_t nblocks = blocks / (n / 20 + 1) + 1;
+        size_t samples = nblocks * BLOCK_SAMPLES;
+        struct ecg_synth synth;
+        struct sliding s;
+        double t_kernel = 0, t_scan = 0;
+        size_t count = 0, pos = 0, mismatches = 0;
+        volatile int64_t sink = 0;
+
+        ecg_synth_init(&synth, fs, 72, 1);
+        sliding_init(&s, storage, n);
+
+        for (size_t b = 0; b < nblocks; b++) {
+            int32_t x[BLOCK_SAMPLES];
+            int32_t mx[BLOCK_SAMPLES], mn[BLOCK_SAMPLES];
+            int32_t mean[BLOCK_SAMPLES];
+            uint64_t var[BLOCK_SAMPLES];
+            double t0;
+
+            ecg_synth_fill(&synth, x, BLOCK_SAMPLES);
+
+            t0 = now_s();
+            for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+                sliding_add(&s, x[i]);
+                mx[i] = sliding_max(&s);
+                mn[i] = sliding_min(&s);
+                mean[i] = sliding_mean(&s);
+                var[i] = sliding_var(&s);
+            }
+            t_kernel += now_s() - t0;
+
+            t0 = now_s();
+            for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+                int32_t smax, smin;
+                int64_t sum = 0, sq = 0;
+
+                ring[pos] = x[i];
+                pos = (pos + 1) % n;
+                count += count < n;
+                smax = smin = ring[0];
+                for (size_t j = 0; j < count; j++) {
+                    smax = ring[j] > smax ? ring[j] : smax;
+                    smin = ring[j] < smin ? ring[j] : smin;
+                    sum += ring[j];
+                    sq += (int64_t)ring[j] * ring[j];
+                }
+                sink += smax + smin + sum + sq;
+                /* The reference in floating point, against rounding */
+                mismatches += smax != mx[i] || smin != mn[i] ||
+                              sum / (int64_t)count != mean[i] ||
+                              fabs((double)sq / (double)count -
+                                   ((double)sum / (double)count) *
+                                       ((double)sum / (double)count) -
+                                   (double)var[i]) >= 1.0;
+            }
+            t_scan += now_s() - t0;
+        }
+        printf("%u,%zu,%.1f,%.1f,%zu\n", windows_ms[k], n,
+               t_kernel * 1e9 / (double)samples,
+               t_scan * 1e9 / (double)samples, mismatches);
+        free(ring);
+        free(storage);
+    }
+}
+
+struct mains_case {
+    const char *name;
+    double f0_hz;
+    /* Drift over the whole run */
+    double drift_hz;
+    double amp_uv;
+};
+
+static const struct mains_case mains_cases[] = {
+    {"none", 50.0, 0.0, 0.0},       {"50", 50.0, 0.0, 100.0},
+    {"49.8", 49.8, 0.0, 100.0},     {"50.2", 50.2, 0.0, 100.0},
+    {"60", 60.0, 0.0, 100.0},       {"59.7", 59.7, 0.0, 100.0},
+    {"50-drift", 49.8, 0.4, 100.0}, {"60-weak", 60.0, 0.0, 20.0},
+};
+
+static double gauss(uint32_t *seed)
+{
+    double u, v;
+
+    *seed = *seed * 1664525u + 1013904223u;
+    u = ((*seed >> 8) + 1.0) / 16777217.0;
+    *seed = *seed * 1664525u + 1013904223u;
+    v = (*seed >> 8) / 16777216.0;
+    return sqrt(-2.0 * log(u)) * cos(2.0 * PI * v);
+}
+
+static void bench_mains(size_t blocks)
+{
+    static const uint32_t rates[] = {250, 500, 1000};
+
+    printf("fs_hz,case,freq_hz,lock_s,estimates,retunes,residual_uv,"
+           "fixed_residual_uv,estimate_ns,notch_ns,fixed_notch_ns\n");
+
+    for (size_t k = 0; k < sizeof(rates) / sizeof(rates[0]); k++) {
+        uint32_t fs = rates[k];
+        size_t nblocks = blocks / 20 * fs / 500 + 1;
+
+        for (size_t c = 0; c < sizeof(mains_cases) / sizeof(mains_cases[0]);
+             c++) {
+            const struct mains_case *mc = &mains_cases[c];
+            struct ecg_synth synth;
+            struct mains m;
+            struct mains_notch notch = {0}, ref_notch = {0};
+            struct biquad fixed, fixed_ref;
+            struct biquad_coeffs fc;
+            struct mains_stats st;
+            double phase = 0, t_est = 0, t = 0, t_fixed = 0, lock_s = -1;
+            double sq = 0, sq_fixed = 0;
+            size_t err_n = 0;
+            uint32_t seed = 7;
+
+            ecg_synth_init(&synth, fs, 72, 1);
+            mains_init(&m, fs);
+            biquad_notch(&fc, fs, 50.0, MAINS_NOTCH_BW_CHZ / 100.0);
+            biquad_init(&fixed, &fc);
+            biquad_init(&fixed_ref, &fc);
+
+            for (size_t b = 0; b < nblocks; b++) {
+                int32_t clean[BLOCK_SAMPLES], x[BLOCK_SAMPLES];
+                int32_t y[BLOCK_SAMPLES], ref[BLOCK_SAMPLES];
+                double t0;
+
+                ecg_synth_fill(&synth, clean, BLOCK_SAMPLES);
+                for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+                    double f = mc->f0_hz + mc->drift_hz * (double)b /
+                                               (double)nblocks;
+
+                    phase += 2.0 * PI * f / fs;
+                    x[i] = clean[i] +
+                           (int32_t)lround(mc->amp_uv * sin(phase) +
+                                           0.3 * mc->amp_uv *
+                                               sin(3.0 * phase + 0.5) +
+                                           10.0 * gauss(&seed));
+                    y[i] = x[i];
+                }
+
+                t0 = now_s();
+                mains_update(&m, x, BLOCK_SAMPLES);
+                t_est += now_s() - t0;
+                t0 = now_s();
+                mains_notch_process(&m, &notch, x, BLOCK_SAMPLES);
+                t += now_s() - t0;
+                t0 = now_s();
+                biquad_process(&fixed, y, BLOCK_SAMPLES);
+                t_fixed += now_s() - t0;
+
+                if (lock_s < 0 && m.harmonics != 0) {
+                    lock_s = (double)(b + 1) * BLOCK_SAMPLES / fs;
+                }
+
+                /* The same notches on the clean ECG give the reference */
+                memcpy(ref, clean, sizeof(ref));
+                mains_notch_process(&m, &ref_notch, ref, BLOCK_SAMPLES);
+                if (b < nblocks / 2) {
+                    memcpy(ref, clean, sizeof(ref));
+                    biquad_process(&fixed_ref, ref, BLOCK_SAMPLES);
+                    continue;
+                }
+                for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+                    double e = x[i] - ref[i];
+
+                    sq += e * e;
+                    err_n++;
+                }
+                memcpy(ref, clean, sizeof(ref));
+                biquad_process(&fixed_ref, ref, BLOCK_SAMPLES);
+                for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+                    double e = y[i] - ref[i];
+
+                    sq_fixed += e * e;
+                }
+            }
+            mains_stats_get(&m, &st);
+            printf("%u,%s,%.3f,%.1f,%u,%u,%.1f,%.1f,%.0f,%.0f,%.0f\n", fs,
+                   mc->name, st.freq_mhz / 1000.0, lock_s, st.estimates,
+                   st.retunes, sqrt(sq / (double)err_n),
+                   sqrt(sq_fixed / (double)err_n),
+                   t_est * 1e9 / (double)nblocks, t * 1e9 / (double)nblocks,
+                   t_fixed * 1e9 / (double)nblocks);
+        }
+    }
+}
+
+/* Bins 0 to n / 2 of the DFT divided by n, as (re, im) pairs */
+static void dft(const int32_t *x, size_t n, double *out)
+{
+    for (size_t k = 0; k <= n / 2; k++) {
+        double re = 0, im = 0;
+
+        for (size_t i = 0; i < n; i++) {
+            /* k i mod n keeps the angle exact */
+            double w = 2.0 * PI * (double)(k * i % n) / (double)n;
+
+            re += x[i] * cos(w);
+            im -= x[i] * sin(w);
+        }
+        out[2 * k] = re / (double)n;
+        out[2 * k + 1] = im / (double)n;
+    }
+}
+
+static void bench_hrv_freq(void)
+{
+    static const double resp_hz[] = {0.2, 0.25, 0.3};
+    struct spectrum sp;
+    int32_t *buf = malloc(HRV_FREQ_WORDS * sizeof(*buf));
+    uint64_t power[HRV_FREQ_N / 2 + 1];
+
+    printf("resp_bpm,lf_ms2,hf_ms2,lf_hf,resp_found_bpm,freq_ns\n");
+    spectrum_init(&sp, HRV_FREQ_N);
+    for (size_t r = 0; r < sizeof(resp_hz) / sizeof(resp_hz[0]); r++) {
+        struct hrv h;
+        struct hrv_freq fr;
+        double t = 0, t0;
+
+        hrv_init(&h);
+        /* 850 ms, 0.1 Hz Mayer waves of 20 ms and 30 ms of RSA */
+        for (size_t b = 0; b < HRV_WINDOW; b++) {
+            double rr = 850.0 + 20.0 * sin(2.0 * PI * 0.1 * t / 1000.0) +
+                        30.0 * sin(2.0 * PI * resp_hz[r] * t / 1000.0);
+
+            t += rr;
+            hrv_add_rr(&h, (uint32_t)lround(rr));
+        }
+        t0 = now_s();
+        hrv_freq_get(&h, &sp, buf, power, &fr);
+        t0 = now_s() - t0;
+        printf("%.1f,%u,%u,%.2f,%.1f,%.0f\n", resp_hz[r] * 60.0, fr.lf_ms2,
+               fr.hf_ms2, fr.lf_hf_pct / 100.0, fr.resp_dbrpm / 10.0,
+               t0 * 1e9);
+    }
+    free(buf);
+}
+
+static void bench_fft(size_t blocks)
+{
+    printf("n,shift,rfft_ns,power_ns,snr_db\n");
+
+    for (uint32_t n = 128; n <= SPECTRUM_MAX_N; n *= 2) {
+        int32_t *x = malloc(n * sizeof(*x));
+        int32_t *buf = malloc(SPECTRUM_WORDS(n) * sizeof(*buf));
+        uint64_t *power = malloc((n / 2 + 1) * sizeof(*power));
+        double *ref = malloc((n + 2) * sizeof(*ref));
+        /* As many samples as the other benches go through */
+        size_t reps = blocks * BLOCK_SAMPLES / n / 10 + 1;
+        struct ecg_synth synth;
+        struct spectrum sp;
+        double t_fft = 0, t_power = 0, sig = 0, err = 0;
+        uint32_t seed = 3;
+        int shift = 0;
+
+        ecg_synth_init(&synth, 500, 72, 1);
+        ecg_synth_fill(&synth, x, n);
+        for (uint32_t i = 0; i < n; i++) {
+            x[i] += (int32_t)lround(20.0 * gauss(&seed));
+        }
+        spectrum_init(&sp, n);
+
+        for (size_t r = 0; r < reps; r++) {
+            double t0;
+
+            memcpy(buf, x, n * sizeof(*x));
+            t0 = now_s();
+            shift = spectrum_rfft(&sp, buf);
+            t_fft += now_s() - t0;
+        }
+        for (size_t r = 0; r < reps; r++) {
+            double t0;
+
+            memcpy(buf, x, n * sizeof(*x));
+            t0 = now_s();
+            spectrum_power(&sp, buf, power);
+            t_power += now_s() - t0;
+        }
+
+        memcpy(buf, x, n * sizeof(*x));
+        shift = spectrum_rfft(&sp, buf);
+        dft(x, n, ref);
+        for (uint32_t i = 0; i < n + 2; i++) {
+            double e = ldexp(buf[i], -shift) - ref[i];
+
+            sig += ref[i] * ref[i];
+            err += e * e;
+        }
+        printf("%u,%d,%.0f,%.0f,%.1f\n", n, shift,
+               t_fft * 1e9 / (double)reps, t_power * 1e9 / (double)reps,
+               10.0 * log10(sig / err));
+        free(ref);
+        free(power);
+        free(buf);
+        free(x);
+    }
+
+    bench_hrv_freq();
+}
+
+static void bench_spo2(size_t blocks)
+{
+    static const uint32_t spo2s[] = {1000, 970, 900, 800, 700};
+    static const uint32_t pis[] = {30, 200, 1000};
+    const uint32_t fs = 100;
+    /* Samples per block at the PPG rate, blocks / 20 per 10 s */
+    const size_t block = 25;
+    size_t nblocks = blocks / 20 * 40 / 10 + 40;
+
+    printf("spo2,pi,spo2_found,pi_found,pr_bpm,beats,rejected,ns_sample,"
+           "us_second\n");
+
+    for (size_t a = 0; a < sizeof(spo2s) / sizeof(spo2s[0]); a++) {
+        for (size_t b = 0; b < sizeof(pis) / sizeof(pis[0]); b++) {
+            struct ppg_synth synth;
+            struct spo2 o;
+            struct spo2_stats st;
+            double t = 0;
+
+            ppg_synth_init(&synth, fs, 72, 5);
+            ppg_synth_set(&synth, spo2s[a], pis[b]);
+            spo2_init(&o, fs, NULL);
+            for (size_t k = 0; k < nblocks; k++) {
+                int32_t red[25], ir[25];
+                double t0;
+
+                ppg_synth_fill(&synth, red, ir, block);
+                t0 = now_s();
+                spo2_process(&o, red, ir, block);
+                t += now_s() - t0;
+            }
+            spo2_stats_get(&o, &st);
+            printf("%.1f,%.2f,%.1f,%.2f,%.1f,%u,%u,%.1f,%.1f\n",
+                   spo2s[a] / 10.0, pis[b] / 100.0, st.spo2_dpct / 10.0,
+                   st.pi_cpct / 100.0, st.pr_dbpm / 10.0, st.beats,
+                   st.rejected, t * 1e9 / (double)(nblocks * block),
+                   t * 1e6 * fs / (double)(nblocks * block));
+        }
+    }
+}
+
+#define PAT_TRUTH 16
+
+struct pat_truth {
+    int64_t r_us;
+    int64_t foot_us;
+};
+
+static void bench_pat(size_t blocks)
+{
+    static const uint32_t rates[] = {50, 100, 200};
+    static const uint32_t pis[] = {30, 200};
+    const uint32_t ecg_fs = 500;
+    const int64_t ecg_us = 1000000 / ecg_fs;
+    /* PPG generated this far behind the ECG, past every onset it needs */
+    const int64_t lag_us = 200000;
+
+    printf("ppg_hz,pi,beats,pairs,r_unpaired,feet_unpaired,pat_err_ms,"
+           "pat_sd_ms,pat_max_ms,r_err_ms,r_sd_ms,foot_err_ms,foot_sd_ms,"
+           "ns_beat\n");
+
+    for (size_t k = 0; k < sizeof(rates) / sizeof(rates[0]); k++) {
+        for (size_t c = 0; c < sizeof(pis) / sizeof(pis[0]); c++) {
+            const uint32_t fs = rates[k];
+            const size_t ppg_block = fs / 4;
+            const int64_t ppg_us = 1000000 / fs;
+            struct pat_truth truth[PAT_TRUTH] = {0};
+            int64_t onsets[PAT_TRUTH];
+            size_t onset_head = 0, onset_count = 0, truth_n = 0;
+            static struct ecg_analysis a;
+            struct ecg_synth ecg;
+            struct ppg_synth ppg;
+            struct pat p;
+            struct pat_stats st;
+            struct error e_pat = {0}, e_r = {0}, e_foot = {0};
+            double t = 0, worst = 0;
+            uint64_t last_r = UINT64_MAX, ecg_n = 0, ppg_n = 0;
+            uint32_t pairs = 0;
+
+            ecg_synth_init(&ecg, ecg_fs, 72, 1);
+            ppg_synth_init(&ppg, fs, 72, 2);
+            ppg_synth_set(&ppg, 970, pis[c]);
+            ecg_analysis_init(&a, ecg_fs, 50);
+            pat_init(&p, fs);
+
+            for (size_t b = 0; b < blocks / 4; b++) {
+                int32_t x[BLOCK_SAMPLES];
+                uint64_t beats[4];
+                size_t nb;
+                double t0;
+
+                ecg_synth_fill(&ecg, x, BLOCK_SAMPLES);
+                ecg_n += BLOCK_SAMPLES;
+                if (ecg_synth_r_peak(&ecg) < ecg_n &&
+                    ecg_synth_r_peak(&ecg) != last_r) {
+                    struct pat_truth *tr = &truth[truth_n++ % PAT_TRUTH];
+                    double sec = (double)ecg_n / ecg_fs;
+                    int64_t pat_us =
+                        250000 + (int64_t)(40000.0 * sin(2.0 * PI * sec / 60));
+                    int64_t onset_us;
+
+                    last_r = ecg_synth_r_peak(&ecg);
+                    tr->r_us = (int64_t)last_r * ecg_us;
+                    /* The pulse starts on a sample, the foot follows it */
+                    onset_us = tr->r_us + pat_us - PPG_SYNTH_FOOT_US;
+                    onset_us = (onset_us + ppg_us - 1) / ppg_us * ppg_us;
+                    tr->foot_us = onset_us + PPG_SYNTH_FOOT_US;
+                    onsets[(onset_head + onset_count++) % PAT_TRUTH] =
+                        onset_us;
+                }
+
+                nb = ecg_analysis_process(&a, x, BLOCK_SAMPLES, beats, 4);
+                t0 = now_s();
+                for (size_t i = 0; i < nb && i < 4; i++) {
+                    pat_r_peak(&p, (int64_t)beats[i] * ecg_us);
+                }
+                t += now_s() - t0;
+
+                while ((int64_t)(ppg_n + ppg_block) * ppg_us + lag_us <=
+                       (int64_t)ecg_n * ecg_us) {
+                    int32_t red[50], ir[50];
+                    int64_t t_us = (int64_t)ppg_n * ppg_us;
+
+                    for (size_t i = 0; i < ppg_block; i++) {
+                        if (onset_count > 0 &&
+                            onsets[onset_head] <= t_us + (int64_t)i * ppg_us) {
+                            ppg_synth_pulse(&ppg);
+                            onset_head = (onset_head + 1) % PAT_TRUTH;
+                            onset_count--;
+                        }
+                        ppg_synth_fill(&ppg, &red[i], &ir[i], 1);
+                    }
+                    ppg_n += ppg_block;
+                    t0 = now_s();
+                    pat_ppg(&p, ir, ppg_block, t_us);
+                    t += now_s() - t0;
+                }
+
+                if (p.pairs == pairs) {
+                    continue;
+                }
+                pairs = p.pairs;
+                for (size_t i = 0; i < PAT_TRUTH; i++) {
+                    const struct pat_truth *tr = &truth[i];
+                    double d_r = (double)(p.last_r_us - tr->r_us) / 1000.0;
+                    double d_pat;
+
+                    if (tr->r_us == 0 || fabs(d_r) > 50.0) {
+                        continue;
+                    }
+                    d_pat = (double)p.last_pat_us / 1000.0 -
+                            (double)(tr->foot_us - tr->r_us) / 1000.0;
+                    error_add(&e_pat, d_pat);
+                    error_add(&e_r, d_r);
+                    error_add(&e_foot, d_pat + d_r);
+                    worst = fabs(d_pat) > worst ? fabs(d_pat) : worst;
+                    break;
+                }
+            }
+
+            pat_stats_get(&p, &st);
+            printf("%u,%.2f,%u,%u,%u,%u", fs, pis[c] / 100.0, a.beats,
+                   st.pairs, st.r_unpaired, st.feet_unpaired);
+            error_print(&e_pat);
+            printf(",%.1f", worst);
+            error_print(&e_r);
+            error_print(&e_foot);
+            printf(",%.0f\n", t * 1e9 / (double)(a.beats ? a.beats : 1));
+        }
+    }
+}
+
+enum fusion_state { FUSION_ON, FUSION_OFF, FUSION_NOISY };
+
+struct fusion_stretch {
+    const char *name;
+    double end_s;
+    /* Heart rate approached with a 20 s time constant */
+    double hr_bpm;
+    uint32_t activity_mg;
+    uint8_t ecg;
+    uint8_t ppg;
+};
+
+static const struct fusion_stretch fusion_stretches[] = {
+    {"rest", 120, 65, 20, FUSION_ON, FUSION_ON},
+    {"walk", 180, 100, 250, FUSION_ON, FUSION_ON},
+    {"run", 240, 150, 700, FUSION_ON, FUSION_ON},
+    {"run-ecg-off", 300, 155, 700, FUSION_OFF, FUSION_ON},
+    {"recovery-ecg-noisy", 420, 80, 150, FUSION_NOISY, FUSION_ON},
+    {"rest-ppg-off", 540, 65, 20, FUSION_ON, FUSION_OFF},
+    {"none", 560, 65, 20, FUSION_OFF, FUSION_OFF},
+    {"rest-again", 600, 65, 20, FUSION_ON, FUSION_ON},
+    {"walk-ecg-off", 660, 100, 250, FUSION_OFF, FUSION_ON},
+};
+
+#define FUSION_STRETCHES                                                       \
+    (sizeof(fusion_stretches) / sizeof(fusion_stretches[0]))
+#define FUSION_BEATS 2048
+
+struct fusion_event {
+    double arrival_s;
+    int64_t t_us;
+    uint32_t hr_cbpm;
+    uint8_t degraded;
+};
+
+static size_t fusion_stretch_at(double t)
+{
+    size_t i = 0;
+
+    while (i < FUSION_STRETCHES - 1 && t >= fusion_stretches[i].end_s) {
+        i++;
+    }
+    return i;
+}
+
+/* Heart rate without sinus arrhythmia */
+static double fusion_truth(double t)
+{
+    double hr = fusion_stretches[0].hr_bpm;
+    double start = 0;
+
+    for (size_t i = 0; i < FUSION_STRETCHES; i++) {
+        const struct fusion_stretch *s = &fusion_stretches[i];
+
+        if (t < s->end_s) {
+            return s->hr_bpm + (hr - s->hr_bpm) * exp(-(t - start) / 20.0);
+        }
+        hr = s->hr_bpm + (hr - s->hr_bpm) * exp(-(s->end_s - start) / 20.0);
+        start = s->end_s;
+    }
+    return hr;
+}
+
+static void fusion_event_add(struct fusion_event *ev, size_t *n,
+                             double arrival_s, double t_s, double hr_bpm,
+                             uint8_t degraded)
+{
+    if (*n < FUSION_BEATS) {
+        ev[*n].arrival_s = arrival_s;
+        ev[*n].t_us = (int64_t)(t_s * 1e6);
+        ev[*n].hr_cbpm = (uint32_t)lround(hr_bpm * 100.0);
+        ev[*n].degraded = degraded;
+        (*n)++;
+    }
+}
+
+static void bench_fusion(size_t blocks)
+{
+    static struct fusion_event ev[HR_SOURCES][FUSION_BEATS];
+    size_t n[HR_SOURCES] = {0}, next[HR_SOURCES] = {0};
+    const struct fusion_event *last[HR_SOURCES] = {NULL};
+    struct error raw[FUSION_STRETCHES][HR_SOURCES] = {0};
+    struct error fused[FUSION_STRETCHES] = {0};
+    double worst[FUSION_STRETCHES] = {0};
+    uint32_t valid[FUSION_STRETCHES] = {0};
+    uint32_t reliable[FUSION_STRETCHES][HR_SOURCES] = {0};
+    uint32_t seed = 3;
+    struct hr_fusion f;
+    struct hr_fusion_stats st;
+    double t = 0, prev = 0, cost = 0;
+    size_t updates = 0;
+
+    (void)blocks;
+
+    /* Beats, and what each source makes of them */
+    while (t < fusion_stretches[FUSION_STRETCHES - 1].end_s) {
+        const struct fusion_stretch *s =
+            &fusion_stretches[fusion_stretch_at(t)];
+        double rsa = s->activity_mg < 100 ? 3.0 : 1.0;
+        double hr = fusion_truth(t) + rsa * sin(2.0 * PI * 0.25 * t);
+        double rr = 60.0 / hr;
+        double u;
+
+        prev = t;
+        t += rr;
+        seed = seed * 1664525u + 1013904223u;
+        u = (seed >> 8) / 16777216.0;
+
+        if (s->ecg == FUSION_ON) {
+            fusion_event_add(ev[HR_SOURCE_ECG], &n[HR_SOURCE_ECG], t + 0.1, t,
+                             60.0 / (t - prev + 0.002 * gauss(&seed)), 0);
+        } else if (s->ecg == FUSION_NOISY) {
+            /* Extra detections halve the interval, missed ones double it */
+            double k = u < 0.1 ? 0.5 : u < 0.15 ? 2.0 : 1.0;
+
+            fusion_event_add(ev[HR_SOURCE_ECG], &n[HR_SOURCE_ECG], t + 0.1, t,
+                             60.0 / (k * (t - prev) + 0.008 * gauss(&seed)),
+                             1);
+        }
+        if (s->ppg == FUSION_ON) {
+            double jitter = 0.01 * (1.0 + s->activity_mg / 250.0);
+            double pr = 60.0 / (t - prev + jitter * gauss(&seed));
+
+            /* Locked onto the step rate */
+            if (s->activity_mg >= 500 && u > 0.8) {
+                pr = 170.0;
+            }
+            fusion_event_add(ev[HR_SOURCE_PPG], &n[HR_SOURCE_PPG], t + 0.45,
+                             t + 0.25, pr, 0);
+        }
+    }
+
+    /* Arrival order, the estimate read once a second */
+    hr_fusion_init(&f);
+    for (uint32_t sec = 1; sec <= fusion_stretches[FUSION_STRETCHES - 1].end_s;
+         sec++) {
+        size_t k = fusion_stretch_at(sec - 1);
+        double e;
+
+        hr_fusion_motion(&f, fusion_stretches[k].activity_mg);
+        while (1) {
+            size_t src = HR_SOURCES;
+            const struct fusion_event *x;
+            double t0;
+
+            for (size_t i = 0; i < HR_SOURCES; i++) {
+                if (next[i] < n[i] && ev[i][next[i]].arrival_s <= sec &&
+                    (src == HR_SOURCES ||
+                     ev[i][next[i]].arrival_s < ev[src][next[src]].arrival_s)) {
+                    src = i;
+                }
+            }
+            if (src == HR_SOURCES) {
+                break;
+            }
+            x = &ev[src][next[src]++];
+            last[src] = x;
+            t0 = now_s();
+            hr_fusion_update(&f, (enum hr_source)src, x->t_us, x->hr_cbpm,
+                             x->degraded);
+            cost += now_s() - t0;
+            updates++;
+        }
+
+        hr_fusion_stats_get(&f, (int64_t)sec * 1000000, &st);
+        for (size_t i = 0; i < HR_SOURCES; i++) {
+            reliable[k][i] += (st.reliable >> i) & 1;
+        }
+        if (!st.valid) {
+            continue;
+        }
+        valid[k]++;
+        e = st.hr_cbpm / 100.0 - fusion_truth(sec);
+        error_add(&fused[k], e);
+        worst[k] = fabs(e) > worst[k] ? fabs(e) : worst[k];
+        /* Each source alone, at the same seconds: its last beat if live */
+        for (size_t i = 0; i < HR_SOURCES; i++) {
+            if (last[i] != NULL &&
+                (int64_t)sec * 1000000 - last[i]->t_us <=
+                    (int64_t)HR_FUSION_STALE_MS * 1000) {
+                error_add(&raw[k][i],
+                          last[i]->hr_cbpm / 100.0 - fusion_truth(sec));
+            }
+        }
+    }
+
+    printf("stretch,seconds,valid_s,ecg_reliable_s,ppg_reliable_s,"
+           "ecg_rms_bpm,ppg_rms_bpm,fused_rms_bpm,fused_max_bpm\n");
+    for (size_t k = 0; k < FUSION_STRETCHES; k++) {
+        const struct fusion_stretch *s = &fusion_stretches[k];
+
+        printf("%s,%.0f,%u,%u,%u", s->name,
+               s->end_s - (k > 0 ? fusion_stretches[k - 1].end_s : 0),
+               valid[k], reliable[k][HR_SOURCE_ECG],
+               reliable[k][HR_SOURCE_PPG]);
+        for (size_t i = 0; i < HR_SOURCES; i++) {
+            const struct error *r = &raw[k][i];
+
+            printf(",%.1f", r->n > 0 ? sqrt(r->sq / (double)r->n) : 0.0);
+        }
+        printf(",%.1f,%.1f\n",
+               fused[k].n > 0 ? sqrt(fused[k].sq / (double)fused[k].n) : 0.0,
+               worst[k]);
+    }
+    hr_fusion_stats_get(&f, (int64_t)(t * 1e6), &st);
+    printf("ecg_accepted,ecg_rejected,ppg_accepted,ppg_rejected,restarts,"
+           "ns_update\n");
+    printf("%u,%u,%u,%u,%u,%.0f\n", st.accepted[HR_SOURCE_ECG],
+           st.rejected[HR_SOURCE_ECG], st.accepted[HR_SOURCE_PPG],
+           st.rejected[HR_SOURCE_PPG], st.restarts,
+           cost * 1e9 / (double)(updates ? updates : 1));
+}
+
+static void bench_crypto(size_t blocks)
+{
+    static uint8_t page[REC_PAGE_SIZE];
+    const uint8_t key[REC_KEY_SIZE] = {0x2b, 0x7e, 0x15, 0x16};
+    const size_t len = REC_PAGE_SIZE - REC_PAGE_HDR_SIZE;
+    struct rec_page_hdr hdr = {
+        .magic = REC_PAGE_MAGIC,
+        .fs_hz = 500,
+        .flags = REC_PAGE_FLAG_ENCRYPTED,
+        .nonce = {1, 2, 3, 4, 5, 6, 7, 8},
+    };
+    size_t pages = blocks / 20 > 0 ? blocks / 20 : 1;
+    struct ecg_synth synth;
+    uint64_t bytes = 0;
+    double t0, t_page, t_block;
+    int32_t x[BLOCK_SAMPLES];
+    uint8_t frame[ECG_CODEC_MAX_SIZE(BLOCK_SAMPLES)];
+
+    /* A minute of codec frames tells the recorder's byte rate */
+    ecg_synth_init(&synth, 500, 72, 1);
+    for (uint32_t b = 0; b < 60 * 500 / BLOCK_SAMPLES; b++) {
+        const struct ecg_codec_frame f = {
+            .seq = b,
+            .count = BLOCK_SAMPLES,
+        };
+
+        ecg_synth_fill(&synth, x, BLOCK_SAMPLES);
+        bytes += ecg_codec_encode(&f, x, frame, sizeof(frame));
+    }
+    memset(page, 0x5a, sizeof(page));
+
+    t0 = now_s();
+    for (size_t i = 0; i < pages; i++) {
+        hdr.seq = (uint32_t)i;
+        if (rec_cipher_page(key, &hdr, page + REC_PAGE_HDR_SIZE, len) != 0) {
+            fprintf(stderr, "cipher failed\n");
+            return;
+        }
+    }
+    t_page = (now_s() - t0) / (double)pages;
+
+    t0 = now_s();
+    for (size_t i = 0; i < pages; i++) {
+        hdr.seq = (uint32_t)i;
+        if (rec_cipher_page(key, &hdr, page + REC_PAGE_HDR_SIZE, 16) != 0) {
+            fprintf(stderr, "cipher failed\n");
+            return;
+        }
+    }
+    t_block = (now_s() - t0) / (double)pages;
+
+    printf("page_bytes,pages,us_page,us_setup,mb_s,pages_per_h\n");
+    printf("%zu,%zu,%.2f,%.2f,%.0f,%.0f\n", len, pages, t_page * 1e6,
+           t_block * 1e6, len / t_page / 1e6,
+           (double)bytes * 60.0 / (double)len);
+}
+
+static const struct bench {
+    const char *name;
+    void (*run)(size_t blocks);
+} benches[] = {
+    {"layout", bench_layout},
+    {"delin", bench_delin},
+    {"baseline", bench_baseline},
+    {"sliding", bench_sliding},
+    {"mains", bench_mains},
+    {"fft", bench_fft},
+    {"spo2", bench_spo2},
+    {"pat", bench_pat},
+    {"fusion", bench_fusion},
+    {"crypto", bench_crypto},
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-n blocks] [bench...]\n"
+            "  -n blocks  blocks per run (default 200000)\n"
+            "  bench      layout, delin, baseline, sliding, mains, fft,\n"
+            "             spo2, pat, fusion, crypto\n"
+            "             (default: all)\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    size_t blocks = 200000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            blocks = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (blocks == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        int selected = optind == argc;
+
+        for (int a = optind; a < argc; a++) {
+            selected |= strcmp(argv[a], benches[i].name) == 0;
+        }
+        if (selected) {
+            printf("# %s\n", benches[i].name);
+            benches[i].run(blocks);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,312 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "edf_writer.h"
+
+/* Leads plus the annotation signal */
+#define EDF_HDR_SIZE(leads) (256 * ((size_t)(leads) + 2))
+/* Time-keeping TAL, a gap and a restart marker at 72 h onsets */
+#define EDF_ANNOT_SAMPLES 48
+#define EDF_ANNOT_BYTES   (2 * EDF_ANNOT_SAMPLES)
+#define EDF_NRECORDS_OFF  236
+
+/* Mapped output window, the file grows in steps of this size */
+#define WINDOW_SIZE (64u << 20)
+
+static void field(char **p, const char *s, size_t width)
+{
+    size_t len = strlen(s);
+
+    if (len > width) {
+        len = width;
+    }
+    memcpy(*p, s, len);
+    memset(*p + len, ' ', width - len);
+    *p += width;
+}
+
+static int window_map(struct edf_writer *w, uint64_t off)
+{
+    if (w->win != NULL) {
+        munmap(w->win, WINDOW_SIZE);
+        w->win = NULL;
+    }
+    if (ftruncate(w->fd, (off_t)(off + WINDOW_SIZE)) < 0) {
+        return -1;
+    }
+    w->win = mmap(NULL, WINDOW_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED,
+                  w->fd, (off_t)off);
+    if (w->win == MAP_FAILED) {
+        w->win = NULL;
+        return -1;
+    }
+    w->win_off = off;
+    return 0;
+}
+
+static int out(struct edf_writer *w, const void *data, size_t len)
+{
+    const uint8_t *src = data;
+
+    while (len > 0) {
+        uint64_t in_win = w->pos - w->win_off;
+        size_t chunk;
+
+        if (in_win == WINDOW_SIZE) {
+            /* Finished pages are written back by the kernel */
+            if (window_map(w, w->win_off + WINDOW_SIZE) < 0) {
+                return -1;
+            }
+            in_win = 0;
+        }
+        chunk = WINDOW_SIZE - in_win;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(w->win + in_win, src, chunk);
+        w->pos += chunk;
+        src += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+/* One field of width bytes for every lead, then for the annotations */
+static void fields(char **p, unsigned leads, const char *s,
+                   const char *annot, size_t width)
+{
+    for (unsigned i = 0; i < leads; i++) {
+        field(p, s, width);
+    }
+    field(p, annot, width);
+}
+
+static int header(struct edf_writer *w, const char *label)
+{
+    char hdr[EDF_HDR_SIZE(EDF_MAX_LEADS)];
+    char num[24];
+    char annot[8];
+    char *p = hdr;
+
+    field(&p, "0", 8);
+    field(&p, "X X X X", 80);
+    field(&p, "Startdate X X X BLE_kardio", 80);
+    /* Device time is relative to boot, EDF+ convention for unknown date */
+    field(&p, "01.01.85", 8);
+    field(&p, "00.00.00", 8);
+    snprintf(num, sizeof(num), "%zu", EDF_HDR_SIZE(w->leads));
+    field(&p, num, 8);
+    field(&p, "EDF+D", 44);
+    field(&p, "-1", 8);
+    field(&p, "1", 8);
+    snprintf(num, sizeof(num), "%u", w->leads + 1);
+    field(&p, num, 4);
+
+    for (unsigned i = 0; i < w->leads; i++) {
+        if (w->leads > 1) {
+            snprintf(num, sizeof(num), "%.12s %u", label, i + 1);
+            field(&p, num, 16);
+        } else {
+            field(&p, label, 16);
+        }
+    }
+    field(&p, "EDF Annotations", 16);
+    fields(&p, w->leads, "AgAgCl electrode", "", 80);
+    fields(&p, w->leads, "uV", "", 8);
+    fields(&p, w->leads, "-32768", "-1", 8);
+    fields(&p, w->leads, "32767", "1", 8);
+    fields(&p, w->leads, "-32768", "-32768", 8);
+    fields(&p, w->leads, "32767", "32767", 8);
+    fields(&p, w->leads, "", "", 80);
+    snprintf(num, sizeof(num), "%u", w->fs_hz);
+    snprintf(annot, sizeof(annot), "%d", EDF_ANNOT_SAMPLES);
+    fields(&p, w->leads, num, annot, 8);
+    fields(&p, w->leads, "", "", 32);
+
+    return out(w, hdr, EDF_HDR_SIZE(w->leads));
+}
+
+/* Append a TAL at file time t_us, each followed by a zero byte */
+static size_t tal(char *annot, size_t len, int64_t t_us, const char *text)
+{
+    int n = snprintf(annot + len, EDF_ANNOT_BYTES - len,
+                     "+%" PRId64 ".%06" PRId64 "\x14%s\x14", t_us / 1000000,
+                     t_us % 1000000, text);
+
+    return n > 0 ? len + (size_t)n + 1 : len;
+}
+
+static int record_flush(struct edf_writer *w)
+{
+    char annot[EDF_ANNOT_BYTES] = {0};
+    int64_t onset = w->rec_start_us - w->start_us;
+    size_t len;
+
+    if (w->rec_fill == 0) {
+        return 0;
+    }
+
+    for (unsigned l = 0; l < w->leads; l++) {
+        memset(w->rec + (size_t)l * w->fs_hz + w->rec_fill, 0,
+               (w->fs_hz - w->rec_fill) * sizeof(w->rec[0]));
+    }
+
+    /* Time-keeping TAL, then the markers of this record */
+    len = tal(annot, 0, onset, "");
+    if (w->restarted) {
+        len = tal(annot, len, onset, "Device restart");
+    }
+    if (w->gap_us >= 0) {
+        tal(annot, len, w->gap_us - w->start_us, "Recording gap");
+    }
+
+    if (out(w, w->rec,
+            (size_t)w->leads * w->fs_hz * sizeof(w->rec[0])) < 0 ||
+        out(w, annot, sizeof(annot)) < 0) {
+        return -1;
+    }
+    w->records++;
+    w->end_us = w->rec_start_us + (int64_t)w->fs_hz * w->sample_us;
+    w->rec_fill = 0;
+    w->gap_us = -1;
+    w->restarted = 0;
+    return 0;
+}
+
+int edf_open(struct edf_writer *w, const char *path, uint32_t fs_hz,
+             unsigned leads, const char *label)
+{
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+    if (fs_hz == 0 || 1000000 % fs_hz != 0 || leads == 0 ||
+        leads > EDF_MAX_LEADS) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    w->fs_hz = fs_hz;
+    w->leads = leads;
+    w->sample_us = 1000000 / fs_hz;
+    w->rec = calloc((size_t)leads * fs_hz, sizeof(w->rec[0]));
+    w->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (w->rec == NULL || w->fd < 0 || window_map(w, 0) < 0 ||
+        header(w, label) < 0) {
+        edf_close(w);
+        return -1;
+    }
+    w->start_us = -1;
+    w->gap_us = -1;
+    return 0;
+}
+
+void edf_restart(struct edf_writer *w)
+{
+    w->restart = w->start_us >= 0;
+}
+
+int edf_write(struct edf_writer *w, int64_t t_us, const int32_t *x,
+              unsigned leads, size_t n)
+{
+    if (leads != w->leads) {
+        errno = EINVAL;
+        return -1;
+    }
+    t_us += w->offset_us;
+    if (w->start_us < 0) {
+        w->start_us = t_us;
+    } else if (w->restart || t_us < w->next_us - w->sample_us / 2) {
+        /* Device time starts over: go on right after the last record */
+        w->restarts++;
+        w->restart = 0;
+        if (w->rec_fill > 0) {
+            w->gap_us = w->next_us;
+            if (record_flush(w) < 0) {
+                return -1;
+            }
+        }
+        w->offset_us += w->end_us - t_us;
+        t_us = w->end_us;
+        w->restarted = 1;
+    } else if (t_us - w->next_us > w->sample_us / 2) {
+        int64_t missing = (t_us - w->next_us + w->sample_us / 2) / w->sample_us;
+
+        w->gaps++;
+        if (w->rec_fill > 0 && w->gap_us < 0 &&
+            missing < (int64_t)(w->fs_hz - w->rec_fill)) {
+            /* A gap inside the record is zero filled, marked where it starts */
+            w->gap_us = w->next_us;
+            for (unsigned l = 0; l < w->leads; l++) {
+                memset(w->rec + (size_t)l * w->fs_hz + w->rec_fill, 0,
+                       (size_t)missing * sizeof(w->rec[0]));
+            }
+            w->rec_fill += (size_t)missing;
+        } else {
+            /*
+             * Otherwise the record ends, the next one's onset shows the
+             * jump. At a record boundary nothing is pending and the next
+             * record carries the marker.
+             */
+            if (w->gap_us < 0) {
+                w->gap_us = w->next_us;
+            }
+            if (record_flush(w) < 0) {
+                return -1;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (w->rec_fill == 0) {
+            w->rec_start_us = t_us + (int64_t)i * w->sample_us;
+        }
+        for (unsigned l = 0; l < leads; l++) {
+            int32_t v = x[l * n + i];
+
+            w->rec[(size_t)l * w->fs_hz + w->rec_fill] =
+                (int16_t)(v > INT16_MAX   ? INT16_MAX
+                          : v < INT16_MIN ? INT16_MIN
+                                          : v);
+        }
+        if (++w->rec_fill == w->fs_hz && record_flush(w) < 0) {
+            return -1;
+        }
+    }
+    w->samples += n;
+    w->next_us = t_us + (int64_t)n * w->sample_us;
+    return 0;
+}
+
+int edf_close(struct edf_writer *w)
+{
+    int ret = 0;
+
+    if (w->win != NULL) {
+        char num[9];
+
+        if (record_flush(w) < 0) {
+            ret = -1;
+        }
+        munmap(w->win, WINDOW_SIZE);
+        w->win = NULL;
+
+        snprintf(num, sizeof(num), "%-8" PRIu64, w->records);
+        if (pwrite(w->fd, num, 8, EDF_NRECORDS_OFF) != 8) {
+            ret = -1;
+        }
+    }
+    if (w->fd >= 0) {
+        if (ftruncate(w->fd, (off_t)w->pos) < 0 || close(w->fd) < 0) {
+            ret = -1;
+        }
+        w->fd = -1;
+    }
+    free(w->rec);
+    w->rec = NULL;
+    return ret;
+}
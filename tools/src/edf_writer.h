@@ -0,0 +1,86 @@
+#ifndef TOOLS_EDF_WRITER_H_
+#define TOOLS_EDF_WRITER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Most ECG signals in one file, as many as a codec frame carries. */
+#define EDF_MAX_LEADS 16
+
+/**
+ * Streaming EDF+D writer for the leads of one ECG recording, one signal
+ * per lead.
+ *
+ * Data records last one second. Output goes through a sliding
+ * memory-mapped window of the file, so memory use is constant. Samples
+ * are microvolts stored as 16 bit integers at 1 uV resolution.
+ *
+ * Every gap in the timestamps is marked with a "Recording gap" annotation
+ * where the data stops, in the record it stops in or, at a record
+ * boundary, in the next one. It is zero filled if it ends within the current
+ * record, otherwise that record is zero padded and the next one starts
+ * at the new time. Device timestamps restart at boot, so a timestamp
+ * going back, or edf_restart(), is taken as a restart: the data goes on
+ * right after the last record, marked "Device restart". Record onsets
+ * thus never go back and records never overlap.
+ */
+struct edf_writer {
+    int fd;
+    uint8_t *win;
+    uint64_t win_off;
+    uint64_t pos;
+
+    uint32_t fs_hz;
+    unsigned leads;
+    int64_t sample_us;
+    /* Record being filled, [leads][fs_hz] */
+    int16_t *rec;
+    size_t rec_fill;
+    /* File time: device time plus the offset of the restarts so far */
+    int64_t offset_us;
+    int64_t start_us;
+    int64_t rec_start_us;
+    int64_t end_us;
+    int64_t next_us;
+    /* Where the data of the current record stops, -1 for no gap */
+    int64_t gap_us;
+    int restart;
+    int restarted;
+
+    uint64_t records;
+    /* Samples per lead */
+    uint64_t samples;
+    uint64_t gaps;
+    uint64_t restarts;
+};
+
+/**
+ * @param leads Signals in the file, 1 to EDF_MAX_LEADS.
+ * @param label Signal label, numbered from 1 per lead if there are several.
+ *
+ * @return 0 on success, -1 on error (errno set).
+ */
+int edf_open(struct edf_writer *w, const char *path, uint32_t fs_hz,
+             unsigned leads, const char *label);
+
+/**
+ * Append @p n samples per lead, the first ones taken at @p t_us.
+ *
+ * @param x Samples as a [leads][n] array, lead after lead.
+ *
+ * @return 0 on success, -1 on error; errno is EINVAL if @p leads is not
+ *         the lead count of the file.
+ */
+int edf_write(struct edf_writer *w, int64_t t_us, const int32_t *x,
+              unsigned leads, size_t n);
+
+/**
+ * Take the next samples as from a restarted device, whatever their
+ * timestamp, e.g. when a recording shows a new boot.
+ */
+void edf_restart(struct edf_writer *w);
+
+/** Flush the last record, fix up the header and close the file. */
+int edf_close(struct edf_writer *w);
+
+#endif /* TOOLS_EDF_WRITER_H_ */
@@ -0,0 +1,136 @@
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "edf_writer.h"
+#include "rec_reader.h"
+
+#define MAX_FRAME_SAMPLES 4096
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-k key] [-l label] [-v] <recorder dump> <out.edf>\n"
+            "  -k key    AES-128 recorder key, 32 hex digits\n"
+            "  -l label  signal label, numbered per lead (default \"ECG\")\n"
+            "  -v        print statistics and throughput\n",
+            prog);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    static int32_t samples[MAX_FRAME_SAMPLES];
+    uint8_t key[REC_KEY_SIZE];
+    const char *label = "ECG";
+    struct ecg_codec_frame f;
+    struct rec_reader reader;
+    struct edf_writer edf;
+    int have_key = 0;
+    int verbose = 0;
+    unsigned leads;
+    uint32_t boots;
+    uint64_t frames = 0;
+    double t0;
+    int opt;
+    int ret;
+
+    while ((opt = getopt(argc, argv, "k:l:vh")) != -1) {
+        switch (opt) {
+        case 'k':
+            if (rec_key_parse(optarg, key) != 0) {
+                fprintf(stderr, "invalid key\n");
+                return 2;
+            }
+            have_key = 1;
+            break;
+        case 'l':
+            label = optarg;
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (argc - optind != 2) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    t0 = now_s();
+    if (rec_reader_open(&reader, argv[optind], have_key ? key : NULL) != 0) {
+        fprintf(stderr, "%s: no recording found\n", argv[optind]);
+        return 1;
+    }
+    /* The first frame tells the leads, one EDF signal each */
+    ret = rec_reader_next(&reader, &f, samples, MAX_FRAME_SAMPLES);
+    leads = ret > 0 && f.leads > 0 ? f.leads : 1;
+    boots = reader.boots;
+    if (edf_open(&edf, argv[optind + 1], reader.fs_hz, leads, label) != 0) {
+        fprintf(stderr, "%s: %s\n", argv[optind + 1], strerror(errno));
+        rec_reader_close(&reader);
+        return 1;
+    }
+
+    while (ret > 0) {
+        unsigned n = f.leads > 0 ? f.leads : 1;
+
+        /* Timestamps going back show a restart as well, this one may not */
+        if (reader.boots != boots) {
+            boots = reader.boots;
+            edf_restart(&edf);
+        }
+        if (edf_write(&edf, f.timestamp_us, samples, n, f.count) != 0) {
+            if (errno == EINVAL) {
+                fprintf(stderr, "frame %" PRIu64 ": %u leads, not %u\n",
+                        frames, n, leads);
+            } else {
+                fprintf(stderr, "%s: %s\n", argv[optind + 1],
+                        strerror(errno));
+            }
+            ret = -1;
+            break;
+        }
+        frames++;
+        ret = rec_reader_next(&reader, &f, samples, MAX_FRAME_SAMPLES);
+    }
+
+    if (edf_close(&edf) != 0) {
+        fprintf(stderr, "%s: %s\n", argv[optind + 1], strerror(errno));
+        ret = -1;
+    }
+    rec_reader_close(&reader);
+
+    if (verbose) {
+        double elapsed = now_s() - t0;
+        double hours = (double)edf.samples / reader.fs_hz / 3600.0;
+
+        fprintf(stderr,
+                "%u pages (%u bad), %" PRIu64 " frames, %" PRIu64
+                " samples (%.1f h), %" PRIu64 " records, %" PRIu64
+                " gaps, %" PRIu64 " restarts\n"
+                "%.3f s, %.1f Msamples/s, %.0fx real time\n",
+                reader.pages_read, reader.pages_bad, frames, edf.samples, hours,
+                edf.records, edf.gaps, edf.restarts, elapsed,
+                edf.samples / elapsed / 1e6, hours * 3600.0 / elapsed);
+    }
+    if (reader.pages_bad > 0) {
+        fprintf(stderr, "warning: %u pages could not be decoded%s\n",
+                reader.pages_bad, have_key ? "" : " (encrypted, no key?)");
+    }
+    return ret < 0 ? 1 : 0;
+}
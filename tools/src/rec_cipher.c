@@ -0,0 +1,57 @@
+#include <ctype.h>
+#include <string.h>
+
+#include <openssl/evp.h>
+
+#include "rec_cipher.h"
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = (char)tolower((unsigned char)c);
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+int rec_key_parse(const char *hex, uint8_t key[REC_KEY_SIZE])
+{
+    if (strlen(hex) != 2 * REC_KEY_SIZE) {
+        return -1;
+    }
+    for (int i = 0; i < REC_KEY_SIZE; i++) {
+        int hi = hex_digit(hex[2 * i]);
+        int lo = hex_digit(hex[2 * i + 1]);
+
+        if (hi < 0 || lo < 0) {
+            return -1;
+        }
+        key[i] = (uint8_t)(hi << 4 | lo);
+    }
+    return 0;
+}
+
+int rec_cipher_page(const uint8_t key[REC_KEY_SIZE],
+                    const struct rec_page_hdr *hdr, uint8_t *data, size_t len)
+{
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    uint8_t iv[16];
+    int out_len = 0;
+    int ret = -1;
+
+    if (ctx == NULL) {
+        return -1;
+    }
+
+    rec_page_iv(iv, hdr);
+    if (EVP_EncryptInit_ex(ctx, EVP_aes_128_ctr(), NULL, key, iv) == 1 &&
+        EVP_EncryptUpdate(ctx, data, &out_len, data, (int)len) == 1 &&
+        (size_t)out_len == len) {
+        ret = 0;
+    }
+    EVP_CIPHER_CTX_free(ctx);
+    return ret;
+}
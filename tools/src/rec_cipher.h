@@ -0,0 +1,21 @@
+#ifndef TOOLS_REC_CIPHER_H_
+#define TOOLS_REC_CIPHER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dsp/rec_format.h"
+
+/** Parse a 32 digit hex key. @return 0 on success. */
+int rec_key_parse(const char *hex, uint8_t key[REC_KEY_SIZE]);
+
+/**
+ * Apply the page AES-128-CTR keystream in place, see rec_format.h.
+ * Encryption and decryption are the same operation.
+ *
+ * @return 0 on success.
+ */
+int rec_cipher_page(const uint8_t key[REC_KEY_SIZE],
+                    const struct rec_page_hdr *hdr, uint8_t *data, size_t len);
+
+#endif /* TOOLS_REC_CIPHER_H_ */
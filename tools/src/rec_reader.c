@@ -0,0 +1,132 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rec_reader.h"
+
+static int page_hdr(const struct rec_reader *r, size_t idx,
+                    struct rec_page_hdr *hdr)
+{
+    return rec_page_hdr_get(r->map + idx * REC_PAGE_SIZE, hdr);
+}
+
+int rec_reader_open(struct rec_reader *r, const char *path,
+                    const uint8_t *key)
+{
+    struct rec_page_hdr hdr;
+    struct stat st;
+    uint32_t newest_seq = 0;
+    int found = 0;
+    void *map;
+    int fd;
+
+    memset(r, 0, sizeof(*r));
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size < REC_PAGE_SIZE) {
+        close(fd);
+        return -1;
+    }
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    r->map = map;
+    r->size = (size_t)st.st_size;
+    r->num_pages = r->size / REC_PAGE_SIZE;
+    if (key != NULL) {
+        memcpy(r->key_buf, key, REC_KEY_SIZE);
+        r->key = r->key_buf;
+    }
+
+    /* The page after the newest one is the oldest in the ring */
+    for (size_t i = 0; i < r->num_pages; i++) {
+        if (page_hdr(r, i, &hdr) != 0) {
+            continue;
+        }
+        if (!found || (int32_t)(hdr.seq - newest_seq) > 0) {
+            found = 1;
+            newest_seq = hdr.seq;
+            r->first = (i + 1) % r->num_pages;
+            r->fs_hz = hdr.fs_hz;
+        }
+    }
+    if (!found) {
+        rec_reader_close(r);
+        return -1;
+    }
+    return 0;
+}
+
+static int load_page(struct rec_reader *r)
+{
+    while (r->visited < r->num_pages) {
+        size_t idx = (r->first + r->visited) % r->num_pages;
+
+        r->visited++;
+        if (page_hdr(r, idx, &r->hdr) != 0) {
+            continue;
+        }
+
+        memcpy(r->page, r->map + idx * REC_PAGE_SIZE, REC_PAGE_SIZE);
+        if (r->hdr.flags & REC_PAGE_FLAG_ENCRYPTED) {
+            if (r->key == NULL ||
+                rec_cipher_page(r->key, &r->hdr, r->page + REC_PAGE_HDR_SIZE,
+                                REC_PAGE_SIZE - REC_PAGE_HDR_SIZE) != 0) {
+                r->pages_bad++;
+                continue;
+            }
+        }
+
+        if (r->boots == 0 ||
+            memcmp(r->nonce, r->hdr.nonce, REC_NONCE_SIZE) != 0) {
+            memcpy(r->nonce, r->hdr.nonce, REC_NONCE_SIZE);
+            r->boots++;
+        }
+        r->pos = REC_PAGE_HDR_SIZE;
+        r->have_page = 1;
+        r->pages_read++;
+        return 1;
+    }
+    return 0;
+}
+
+int rec_reader_next(struct rec_reader *r, struct ecg_codec_frame *f,
+                    int32_t *x, size_t max_samples)
+{
+    while (1) {
+        int len;
+
+        if (!r->have_page && !load_page(r)) {
+            return 0;
+        }
+
+        if (r->pos < REC_PAGE_SIZE && r->page[r->pos] != REC_ERASED) {
+            len = ecg_codec_decode(r->page + r->pos, REC_PAGE_SIZE - r->pos, f,
+                                   x, max_samples);
+            if (len > 0) {
+                r->pos += (size_t)len;
+                return 1;
+            }
+            /* Corrupt frame, e.g. wrong key: skip the rest of the page */
+            r->pages_bad++;
+        }
+        r->have_page = 0;
+    }
+}
+
+void rec_reader_close(struct rec_reader *r)
+{
+    if (r->map != NULL) {
+        munmap((void *)r->map, r->size);
+        r->map = NULL;
+    }
+}
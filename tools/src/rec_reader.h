@@ -0,0 +1,65 @@
+#ifndef TOOLS_REC_READER_H_
+#define TOOLS_REC_READER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dsp/ecg_codec.h"
+#include "dsp/rec_format.h"
+#include "rec_cipher.h"
+
+/**
+ * Sequential frame reader over a recorder partition dump.
+ *
+ * The dump is memory-mapped and walked page by page in ring order, from
+ * the oldest to the newest page, so memory use does not depend on the
+ * recording length.
+ */
+struct rec_reader {
+    const uint8_t *map;
+    size_t size;
+    size_t num_pages;
+    /* Ring position of the oldest page and pages visited so far */
+    size_t first;
+    size_t visited;
+
+    const uint8_t *key;
+    uint8_t key_buf[REC_KEY_SIZE];
+
+    struct rec_page_hdr hdr;
+    uint8_t page[REC_PAGE_SIZE];
+    size_t pos;
+    int have_page;
+
+    /** Sample rate of the recording, valid after rec_reader_open(). */
+    uint16_t fs_hz;
+    /**
+     * Boots so far: every boot draws a new nonce, so an encrypted page
+     * whose nonce differs from the page before starts one.
+     */
+    uint32_t boots;
+    uint8_t nonce[REC_NONCE_SIZE];
+    uint32_t pages_read;
+    uint32_t pages_bad;
+};
+
+/**
+ * @param key AES key for encrypted pages or NULL.
+ *
+ * @return 0 on success, -1 if the file cannot be mapped or holds no
+ *         recorder page.
+ */
+int rec_reader_open(struct rec_reader *r, const char *path,
+                    const uint8_t *key);
+
+/**
+ * Decode the next frame.
+ *
+ * @return 1 if a frame was decoded, 0 at the end of the recording.
+ */
+int rec_reader_next(struct rec_reader *r, struct ecg_codec_frame *f,
+                    int32_t *x, size_t max_samples);
+
+void rec_reader_close(struct rec_reader *r);
+
+#endif /* TOOLS_REC_READER_H_ */
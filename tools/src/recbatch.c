@@ -0,0 +1,374 @@
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dsp/ecg_analysis.h"
+#include "rec_reader.h"
+
+/*
+ * Batch analysis of recorder dumps on all cores. Every recording goes
+ * through the same baseline filter, QRS detector, HRV and delineation code
+ * as the DSP thread on the strap, one recording per worker at a time.
+ * The baseline filter is the one recorded in the pages, following cutoff
+ * changes, unless -c or -m override it.
+ */
+
+#define MAX_FRAME_SAMPLES 4096
+#define MAX_FRAME_BEATS   (MAX_FRAME_SAMPLES / 50)
+
+/* Pages without a recorded baseline: the binding's default, 0.01 Hz */
+#define BASELINE_CUTOFF_CHZ 50
+
+struct result {
+    int ok;
+    uint32_t pages;
+    uint32_t pages_bad;
+    uint64_t samples;
+    uint32_t fs_hz;
+    uint32_t beats;
+    struct hrv_stats hrv;
+    struct delin_stats delin;
+};
+
+struct batch {
+    char **paths;
+    size_t count;
+    struct result *results;
+    atomic_size_t next;
+
+    const uint8_t *key;
+    const char *beats_dir;
+    /* Forced baseline, -c or -m; the recorded one if neither */
+    uint16_t cutoff_chz;
+    int median;
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-j jobs] [-k key] [-b dir] [-c chz | -m] [-S] "
+            "<dump>...\n"
+            "  -j jobs  worker threads (default: online CPUs)\n"
+            "  -k key   AES-128 recorder key, 32 hex digits\n"
+            "  -b dir   write the R peak times and fiducial points of every\n"
+            "           recording to dir\n"
+            "  -c chz   baseline high-pass cutoff in 0.01 Hz\n"
+            "  -m       median baseline instead of the high-pass\n"
+            "           (default: as recorded by the device, else -c %u)\n"
+            "  -S       scaling run: repeat with 1, 2, 4 .. jobs workers\n",
+            prog, BASELINE_CUTOFF_CHZ);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static FILE *beats_open(const struct batch *b, const char *path,
+                        const char *suffix)
+{
+    const char *base = strrchr(path, '/');
+    char name[4096];
+
+    if (b->beats_dir == NULL) {
+        return NULL;
+    }
+    snprintf(name, sizeof(name), "%s/%s.%s.csv", b->beats_dir,
+             base != NULL ? base + 1 : path, suffix);
+    return fopen(name, "w");
+}
+
+static void delin_write(FILE *out, const struct delin_beat *d, size_t n,
+                        uint32_t fs_hz)
+{
+    for (size_t i = 0; i < n; i++, d++) {
+        fprintf(out, "%.3f,%u,", (double)d->r / fs_hz, d->rr_ms);
+        if (d->flags & DELIN_P_WAVE) {
+            fprintf(out, "%d,%d,%d,", d->p_on, d->p_peak, d->p_end);
+        } else {
+            fprintf(out, ",,,");
+        }
+        fprintf(out, "%d,%d,", d->qrs_on, d->qrs_off);
+        if (d->flags & DELIN_T_WAVE) {
+            fprintf(out, "%d,%d,%u,%u,", d->t_peak, d->t_end, d->qt_ms,
+                    d->qtc_ms);
+        } else {
+            fprintf(out, ",,,,");
+        }
+        fprintf(out, "%d\n", d->st_uv);
+    }
+}
+
+static void analyse(const struct batch *b, const char *path, struct result *res)
+{
+    /* Worker stacks are small, keep the frame buffers off them */
+    int32_t *samples = malloc(MAX_FRAME_SAMPLES * sizeof(*samples));
+    uint64_t beats[MAX_FRAME_BEATS];
+    struct ecg_analysis *a = malloc(sizeof(*a));
+    struct rec_reader *reader = malloc(sizeof(*reader));
+    uint32_t *median_buf = NULL;
+    struct ecg_codec_frame f;
+    FILE *out = NULL;
+    FILE *fid = NULL;
+    int follow = !b->median && b->cutoff_chz == 0;
+    int baseline;
+    int more;
+
+    memset(res, 0, sizeof(*res));
+    if (samples == NULL || a == NULL || reader == NULL) {
+        goto done;
+    }
+    if (rec_reader_open(reader, path, b->key) != 0) {
+        fprintf(stderr, "%s: no recording found\n", path);
+        goto done;
+    }
+    /* The first page tells how the device filtered */
+    more = rec_reader_next(reader, &f, samples, MAX_FRAME_SAMPLES);
+    if (b->median) {
+        baseline = REC_BASELINE_MEDIAN;
+    } else if (b->cutoff_chz > 0) {
+        baseline = b->cutoff_chz;
+    } else {
+        baseline = rec_page_baseline(&reader->hdr);
+        if (baseline < 0) {
+            baseline = BASELINE_CUTOFF_CHZ;
+        }
+    }
+    ecg_analysis_init(a, reader->fs_hz,
+                      baseline != REC_BASELINE_MEDIAN ? (uint16_t)baseline
+                                                      : BASELINE_CUTOFF_CHZ);
+    if (baseline == REC_BASELINE_MEDIAN) {
+        size_t words = MEDIAN_BASELINE_WORDS(reader->fs_hz);
+
+        median_buf = malloc(words * sizeof(*median_buf));
+        if (median_buf == NULL ||
+            ecg_analysis_use_median(a, median_buf, words) != 0) {
+            rec_reader_close(reader);
+            goto done;
+        }
+    }
+    if (b->beats_dir != NULL &&
+        ((out = beats_open(b, path, "beats")) == NULL ||
+         (fid = beats_open(b, path, "delin")) == NULL)) {
+        fprintf(stderr, "%s: %s\n", b->beats_dir, strerror(errno));
+    }
+    if (fid != NULL) {
+        fprintf(fid, "r_s,rr_ms,p_on,p_peak,p_end,qrs_on,qrs_off,t_peak,"
+                     "t_end,qt_ms,qtc_ms,st_uv\n");
+    }
+
+    for (; more > 0;
+         more = rec_reader_next(reader, &f, samples, MAX_FRAME_SAMPLES)) {
+        int recorded = rec_page_baseline(&reader->hdr);
+        size_t n;
+
+        /* Cutoff changed in the settings while recording */
+        if (follow && baseline != REC_BASELINE_MEDIAN && recorded > 0 &&
+            recorded != baseline) {
+            baseline = recorded;
+            ecg_analysis_set_baseline(a, (uint16_t)baseline);
+        }
+        n = ecg_analysis_process(a, samples, f.count, beats, MAX_FRAME_BEATS);
+        if (n > MAX_FRAME_BEATS) {
+            n = MAX_FRAME_BEATS;
+        }
+        for (size_t i = 0; out != NULL && i < n; i++) {
+            fprintf(out, "%.3f\n", (double)beats[i] / reader->fs_hz);
+        }
+        if (fid != NULL) {
+            delin_write(fid, a->delineated, a->delineated_count,
+                        reader->fs_hz);
+        }
+        res->samples += f.count;
+    }
+
+    res->ok = 1;
+    res->pages = reader->pages_read;
+    res->pages_bad = reader->pages_bad;
+    res->fs_hz = reader->fs_hz;
+    res->beats = a->beats;
+    hrv_get(&a->hrv, &res->hrv);
+    delin_stats_get(&a->delin, &res->delin, 0);
+    rec_reader_close(reader);
+
+done:
+    if (out != NULL) {
+        fclose(out);
+    }
+    if (fid != NULL) {
+        fclose(fid);
+    }
+    free(reader);
+    free(median_buf);
+    free(a);
+    free(samples);
+}
+
+static void *worker(void *arg)
+{
+    struct batch *b = arg;
+    size_t i;
+
+    while ((i = atomic_fetch_add(&b->next, 1)) < b->count) {
+        analyse(b, b->paths[i], &b->results[i]);
+    }
+    return NULL;
+}
+
+static int run(struct batch *b, unsigned jobs)
+{
+    pthread_t *threads = calloc(jobs, sizeof(*threads));
+    unsigned started = 0;
+
+    if (threads == NULL) {
+        return -1;
+    }
+    atomic_store(&b->next, 0);
+    for (; started < jobs; started++) {
+        if (pthread_create(&threads[started], NULL, worker, b) != 0) {
+            break;
+        }
+    }
+    if (started == 0) {
+        /* Nothing could be started, work on the calling thread */
+        worker(b);
+    }
+    for (unsigned i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    return 0;
+}
+
+/* 1, 2, 4 .. and finally @p jobs itself */
+static unsigned next_jobs(unsigned j, unsigned jobs)
+{
+    if (j == jobs) {
+        return jobs + 1;
+    }
+    return j * 2 < jobs ? j * 2 : jobs;
+}
+
+static void report(const struct batch *b)
+{
+    printf("file,hours,pages,bad_pages,beats,hr_bpm,mean_rr_ms,sdnn_ms,"
+           "rmssd_ms,qrs_ms,pr_ms,qt_ms,qtc_ms,st_uv\n");
+    for (size_t i = 0; i < b->count; i++) {
+        const struct result *r = &b->results[i];
+
+        if (!r->ok) {
+            continue;
+        }
+        printf("%s,%.3f,%u,%u,%u,%.1f,%u,%u,%u,%u,%u,%u,%u,%d\n", b->paths[i],
+               (double)r->samples / r->fs_hz / 3600.0, r->pages, r->pages_bad,
+               r->beats, r->hrv.hr_dbpm / 10.0, r->hrv.mean_rr_ms,
+               r->hrv.sdnn_ms, r->hrv.rmssd_ms, r->delin.qrs_ms,
+               r->delin.pr_ms, r->delin.qt_ms, r->delin.qtc_ms,
+               r->delin.st_uv);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned jobs = cpus > 0 ? (unsigned)cpus : 1;
+    uint8_t key[REC_KEY_SIZE];
+    struct batch b = {0};
+    int scaling = 0;
+    int failed = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:k:b:c:mSh")) != -1) {
+        switch (opt) {
+        case 'j':
+            jobs = (unsigned)strtoul(optarg, NULL, 0);
+            if (jobs == 0) {
+                jobs = 1;
+            }
+            break;
+        case 'k':
+            if (rec_key_parse(optarg, key) != 0) {
+                fprintf(stderr, "invalid key\n");
+                return 2;
+            }
+            b.key = key;
+            break;
+        case 'b':
+            b.beats_dir = optarg;
+            break;
+        case 'c':
+            b.cutoff_chz = (uint16_t)strtoul(optarg, NULL, 0);
+            if (b.cutoff_chz == 0) {
+                fprintf(stderr, "invalid cutoff\n");
+                return 2;
+            }
+            break;
+        case 'm':
+            b.median = 1;
+            break;
+        case 'S':
+            scaling = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind == argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    b.paths = &argv[optind];
+    b.count = (size_t)(argc - optind);
+    b.results = calloc(b.count, sizeof(*b.results));
+    if (b.results == NULL) {
+        return 1;
+    }
+
+    for (unsigned j = scaling ? 1 : jobs; j <= jobs; j = next_jobs(j, jobs)) {
+        double t0 = now_s();
+        double elapsed;
+        double hours = 0.0;
+
+        if (run(&b, j) != 0) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        elapsed = now_s() - t0;
+        for (size_t i = 0; i < b.count; i++) {
+            if (b.results[i].ok) {
+                hours += (double)b.results[i].samples / b.results[i].fs_hz /
+                         3600.0;
+            }
+        }
+        fprintf(stderr,
+                "%u workers: %zu recordings (%.1f h) in %.3f s, "
+                "%.2f records/s, %.0fx real time\n",
+                j, b.count, hours, elapsed, b.count / elapsed,
+                hours * 3600.0 / elapsed);
+    }
+
+    report(&b);
+    for (size_t i = 0; i < b.count; i++) {
+        if (!b.results[i].ok) {
+            failed++;
+        } else if (b.results[i].pages_bad > 0) {
+            fprintf(stderr, "warning: %s: %u pages could not be decoded%s\n",
+                    b.paths[i], b.results[i].pages_bad,
+                    b.key != NULL ? "" : " (encrypted, no key?)");
+        }
+    }
+    free(b.results);
+    return failed > 0 ? 1 : 0;
+}
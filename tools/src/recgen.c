@@ -0,0 +1,185 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dsp/ecg_codec.h"
+#include "dsp/ecg_synth.h"
+#include "dsp/rec_format.h"
+#include "rec_cipher.h"
+
+/*
+ * Generate a recorder partition dump from the synthetic ECG source, laid
+ * out exactly as the firmware flash writer does. Used to exercise and
+ * benchmark the host tools on recordings of any length. The recording
+ * may be split into several boots: each starts a new page, with its
+ * timestamps and block numbers back at zero and, encrypted, a new nonce.
+ * A stretch of blocks may be left out, as lost by a device that went on.
+ */
+
+#define BLOCK_SAMPLES 50
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-r rate] [-H hours] [-b boots] [-s seed] [-k key] "
+            "[-c chz] [-g start,len] <out>\n"
+            "  -r rate   sample rate in Hz (default 500)\n"
+            "  -H hours  recording length (default 1)\n"
+            "  -b boots  split the recording into boots (default 1)\n"
+            "  -s seed   synthetic ECG seed (default 1)\n"
+            "  -k key    encrypt with AES-128 key, 32 hex digits\n"
+            "  -c chz    baseline recorded in the pages, cutoff in 0.01 Hz\n"
+            "            or 0 for the medians (default 50)\n"
+            "  -g start,len  leave out len seconds of blocks from start\n",
+            prog);
+}
+
+static int page_write(FILE *out, uint8_t *page, size_t used, uint32_t seq,
+                      uint16_t fs_hz, uint16_t baseline, const uint8_t *key,
+                      uint32_t boot)
+{
+    struct rec_page_hdr hdr = {
+        .magic = REC_PAGE_MAGIC,
+        .seq = seq,
+        .fs_hz = fs_hz,
+    };
+
+    memset(page + used, REC_ERASED, REC_PAGE_SIZE - used);
+    if (key != NULL) {
+        hdr.flags = REC_PAGE_FLAG_ENCRYPTED;
+        /* "recgen00", then the boot number */
+        memcpy(hdr.nonce, "recgen00", REC_NONCE_SIZE);
+        hdr.nonce[6] = (uint8_t)('0' + boot / 10 % 10);
+        hdr.nonce[7] = (uint8_t)('0' + boot % 10);
+    }
+    rec_page_baseline_set(&hdr, baseline);
+    rec_page_hdr_put(page, &hdr);
+    if (key != NULL &&
+        rec_cipher_page(key, &hdr, page + REC_PAGE_HDR_SIZE,
+                        REC_PAGE_SIZE - REC_PAGE_HDR_SIZE) != 0) {
+        return -1;
+    }
+    return fwrite(page, REC_PAGE_SIZE, 1, out) == 1 ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t page[REC_PAGE_SIZE];
+    uint8_t frame[ECG_CODEC_MAX_SIZE(BLOCK_SAMPLES)];
+    int32_t samples[BLOCK_SAMPLES];
+    uint8_t key[REC_KEY_SIZE];
+    const uint8_t *page_key = NULL;
+    struct ecg_synth synth;
+    uint32_t fs_hz = 500;
+    uint32_t seed = 1;
+    uint32_t boots = 1;
+    uint32_t boot = 0;
+    uint16_t baseline = 50;
+    double hours = 1.0;
+    double gap_s = 0.0;
+    double gap_len_s = 0.0;
+    uint64_t blocks;
+    uint64_t boot_start = 0;
+    size_t used = REC_PAGE_HDR_SIZE;
+    uint32_t seq = 0;
+    FILE *out;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:H:b:s:k:c:g:h")) != -1) {
+        switch (opt) {
+        case 'r':
+            fs_hz = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'H':
+            hours = strtod(optarg, NULL);
+            break;
+        case 'b':
+            boots = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'k':
+            if (rec_key_parse(optarg, key) != 0) {
+                fprintf(stderr, "invalid key\n");
+                return 2;
+            }
+            page_key = key;
+            break;
+        case 'c':
+            baseline = (uint16_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'g':
+            if (sscanf(optarg, "%lf,%lf", &gap_s, &gap_len_s) != 2) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (argc - optind != 1 || fs_hz == 0 || 1000000 % fs_hz != 0 ||
+        boots == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    out = fopen(argv[optind], "wb");
+    if (out == NULL) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    ecg_synth_init(&synth, fs_hz, 72, seed);
+    blocks = (uint64_t)(hours * 3600.0 * fs_hz / BLOCK_SAMPLES);
+    for (uint64_t b = 0; b < blocks; b++) {
+        struct ecg_codec_frame f = {
+            .count = BLOCK_SAMPLES,
+        };
+        int reboot = b > 0 && b == blocks * (boot + 1) / boots;
+        double t_s;
+        size_t len;
+
+        if (reboot) {
+            boot_start = b;
+        }
+        f.seq = (uint32_t)(b - boot_start);
+        f.timestamp_us = (int64_t)(f.seq * BLOCK_SAMPLES * (1000000 / fs_hz));
+        ecg_synth_fill(&synth, samples, BLOCK_SAMPLES);
+        /* Recording time, across boots; a boot's first block is kept */
+        t_s = (double)b * BLOCK_SAMPLES / fs_hz;
+        if (!reboot && t_s >= gap_s && t_s < gap_s + gap_len_s) {
+            continue;
+        }
+        len = ecg_codec_encode(&f, samples, frame, sizeof(frame));
+        /* A boot never appends to the page of the previous one */
+        if (used + len > REC_PAGE_SIZE || reboot) {
+            if (page_write(out, page, used, seq++, (uint16_t)fs_hz, baseline,
+                           page_key, boot) != 0) {
+                perror(argv[optind]);
+                return 1;
+            }
+            used = REC_PAGE_HDR_SIZE;
+            boot += reboot;
+        }
+        memcpy(page + used, frame, len);
+        used += len;
+    }
+    if (used > REC_PAGE_HDR_SIZE &&
+        page_write(out, page, used, seq++, (uint16_t)fs_hz, baseline, page_key,
+                   boot) != 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    if (fclose(out) != 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+    fprintf(stderr, "%u pages, %llu blocks\n", seq,
+            (unsigned long long)blocks);
+    return 0;
+}
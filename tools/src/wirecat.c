@@ -0,0 +1,186 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dsp/ecg_codec.h"
+#include "dsp/wire_frame.h"
+#include "edf_writer.h"
+
+/*
+ * Receive the framed wired stream of a gateway or a strap (USB CDC ACM,
+ * UART or a capture file), check it and optionally write every source to
+ * its own EDF+ file. Put a tty into raw mode first (stty raw).
+ */
+
+#define MAX_SOURCES       256
+#define MAX_FRAME_SAMPLES 4096
+
+struct source {
+    int seen;
+    uint32_t frames;
+    uint32_t lost;
+    uint32_t invalid;
+    uint32_t next_seq;
+    uint64_t samples;
+    int edf_open;
+    struct edf_writer edf;
+};
+
+static struct source sources[MAX_SOURCES];
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-r rate] [-o prefix] [-v] <tty or capture>\n"
+            "  -r rate    sample rate of the sources in Hz (default 500)\n"
+            "  -o prefix  write source N to <prefix>N.edf\n"
+            "  -v         print statistics and throughput\n",
+            prog);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int ecg_frame(struct source *s, unsigned src, const uint8_t *data,
+                     size_t len, uint32_t fs_hz, const char *prefix)
+{
+    static int32_t samples[MAX_FRAME_SAMPLES];
+    struct ecg_codec_frame f;
+    unsigned leads;
+
+    if (ecg_codec_decode(data, len, &f, samples, MAX_FRAME_SAMPLES) < 0) {
+        s->invalid++;
+        return 0;
+    }
+    if (s->frames > 0 && f.seq > s->next_seq) {
+        s->lost += f.seq - s->next_seq;
+    }
+    s->next_seq = f.seq + 1;
+    s->frames++;
+    s->samples += f.count;
+
+    if (prefix == NULL) {
+        return 0;
+    }
+    leads = f.leads > 0 ? f.leads : 1;
+    if (!s->edf_open) {
+        char path[4096];
+        char label[16];
+
+        /* Leads of the first frame, one EDF signal each */
+        snprintf(path, sizeof(path), "%s%u.edf", prefix, src);
+        snprintf(label, sizeof(label), "ECG %u", src);
+        if (edf_open(&s->edf, path, fs_hz, leads, label) != 0) {
+            fprintf(stderr, "%s: %s\n", path, strerror(errno));
+            return -1;
+        }
+        s->edf_open = 1;
+    }
+    if (edf_write(&s->edf, f.timestamp_us, samples, leads, f.count) != 0) {
+        if (errno == EINVAL) {
+            fprintf(stderr, "source %u: %u leads, not %u\n", src, leads,
+                    s->edf.leads);
+        } else {
+            fprintf(stderr, "source %u: %s\n", src, strerror(errno));
+        }
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static struct wire_parser parser;
+    static uint8_t buf[65536];
+    const char *prefix = NULL;
+    uint32_t fs_hz = 500;
+    uint64_t bytes = 0;
+    int verbose = 0;
+    int ret = 0;
+    double t0;
+    ssize_t n;
+    int opt;
+    int fd;
+
+    while ((opt = getopt(argc, argv, "r:o:vh")) != -1) {
+        switch (opt) {
+        case 'r':
+            fs_hz = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            prefix = optarg;
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (argc - optind != 1 || fs_hz == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    fd = open(argv[optind], O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+        return 1;
+    }
+
+    wire_parser_init(&parser);
+    t0 = now_s();
+    while (ret == 0 && (n = read(fd, buf, sizeof(buf))) > 0) {
+        bytes += (uint64_t)n;
+        for (ssize_t i = 0; i < n && ret == 0; i++) {
+            struct source *s;
+
+            if (!wire_parser_feed(&parser, buf[i])) {
+                continue;
+            }
+            s = &sources[parser.src];
+            s->seen = 1;
+            if (parser.type == WIRE_TYPE_ECG) {
+                ret = ecg_frame(s, parser.src, parser.payload,
+                                parser.payload_len, fs_hz, prefix);
+            }
+        }
+    }
+    close(fd);
+
+    for (unsigned i = 0; i < MAX_SOURCES; i++) {
+        struct source *s = &sources[i];
+
+        if (!s->seen) {
+            continue;
+        }
+        if (s->edf_open && edf_close(&s->edf) != 0) {
+            ret = -1;
+        }
+        printf("source %u: %u frames, %" PRIu64 " samples, %u lost, "
+               "%u invalid\n",
+               i, s->frames, s->samples, s->lost, s->invalid);
+    }
+    if (verbose) {
+        double elapsed = now_s() - t0;
+
+        fprintf(stderr,
+                "%" PRIu64 " bytes, %u frames, %u CRC errors, %u bytes "
+                "skipped\n%.3f s, %.1f KB/s\n",
+                bytes, parser.frames, parser.crc_errors, parser.skipped,
+                elapsed, bytes / elapsed / 1024.0);
+    }
+    return ret < 0 ? 1 : 0;
+}
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Check the data record onsets of an EDF+D file.
+
+Every record starts with a time-keeping annotation "+onset\\x14\\x14". The
+onsets must be non-negative and each record must start no earlier than
+the previous one ends. Every jump forward must be explained by a
+"Recording gap" annotation within the record before it, or at its end.
+Prints the records, the onset jumps and the gaps found.
+"""
+
+import re
+import sys
+
+ONSET = re.compile(rb"^\+(\d+(?:\.\d+)?)\x14\x14")
+GAP = re.compile(rb"\+(\d+(?:\.\d+)?)\x14Recording gap\x14")
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(f"usage: {sys.argv[0]} <file.edf>", file=sys.stderr)
+        return 2
+
+    with open(sys.argv[1], "rb") as f:
+        data = f.read()
+
+    hdr_size = int(data[184:192])
+    records = int(data[236:244])
+    duration = float(data[244:252])
+    signals = int(data[252:256])
+    if data[192:197] != b"EDF+D":
+        print("not EDF+D", file=sys.stderr)
+        return 1
+
+    # Per signal fields: label 16, transducer 80, dimension 8, physical and
+    # digital min/max 4 x 8, prefiltering 80, then samples per record 8
+    spr_off = 256 + signals * (16 + 80 + 8 + 4 * 8 + 80)
+    spr = [int(data[spr_off + 8 * i:spr_off + 8 * (i + 1)])
+           for i in range(signals)]
+    labels = [data[256 + 16 * i:256 + 16 * (i + 1)].strip()
+              for i in range(signals)]
+    annot = labels.index(b"EDF Annotations")
+    rec_size = 2 * sum(spr)
+    annot_off = 2 * sum(spr[:annot])
+
+    if len(data) != hdr_size + records * rec_size:
+        print(f"size {len(data)}, expected {hdr_size + records * rec_size}",
+              file=sys.stderr)
+        return 1
+
+    onsets = []
+    gaps = []
+    for r in range(records):
+        tal = data[hdr_size + r * rec_size + annot_off:
+                   hdr_size + (r + 1) * rec_size]
+        m = ONSET.match(tal)
+        if m is None:
+            print(f"record {r}: no valid onset: {tal[:16]!r}",
+                  file=sys.stderr)
+            return 1
+        onsets.append(float(m.group(1)))
+        gaps += [float(g) for g in GAP.findall(tal)]
+
+    end = 0.0
+    jumps = 0
+    for r, onset in enumerate(onsets):
+        if onset < end - 1e-6:
+            print(f"record {r}: onset {onset} before the end of the "
+                  f"previous record at {end}", file=sys.stderr)
+            return 1
+        if r > 0 and onset > end + 1e-6:
+            jumps += 1
+            if not any(onsets[r - 1] - 1e-6 <= g <= end + 1e-6
+                       for g in gaps):
+                print(f"record {r}: jump from {end} to {onset} without "
+                      f"a gap annotation", file=sys.stderr)
+                return 1
+        end = onset + duration
+
+    print(f"{records} records, {jumps} onset jumps, {len(gaps)} gaps, "
+          f"ends at {end:.6f} s")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())